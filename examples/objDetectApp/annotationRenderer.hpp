@@ -0,0 +1,215 @@
+#ifndef __ANNOTATION_RENDERER_HPP__
+#define __ANNOTATION_RENDERER_HPP__
+
+#include "algorithms/object_detect/IDnnObjDetectorPlugin.hpp"
+#include "common/CpuTopology.hpp"
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <opencv2/opencv.hpp>
+
+
+namespace example {
+
+/**
+ * Draws the detections into a copy of the frame and encodes it on a worker thread, off the detection path.
+ * Frames are rate-limited to one per <minInterval> before anything is copied; the queue is bounded and drops the
+ * oldest frame when the worker falls behind. The canvas and the encode buffer are reused between frames, the
+ * colour of a label is picked once.
+ */
+class AnnotationRenderer {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    struct Stats {
+        uint64_t submitted{0};
+        uint64_t skipped{0};    // rate-limited
+        uint64_t dropped{0};    // queue full
+        uint64_t written{0};
+        uint64_t failed{0};     // encode or write threw
+        float lastRenderMs{0.f};
+    };
+
+    AnnotationRenderer(const std::string& outputPath, std::chrono::milliseconds minInterval, size_t queueSize = 2) :
+        m_outputPath{outputPath},
+        m_minInterval{minInterval},
+        m_queueSize{std::max<size_t>(queueSize, 1)},
+        m_palette{
+            cv::Scalar(255, 0, 0),    // Blue
+            cv::Scalar(0, 255, 0),    // Green
+            cv::Scalar(0, 0, 255),    // Red
+            cv::Scalar(255, 255, 0),  // Cyan
+            cv::Scalar(255, 0, 255),  // Magenta
+            cv::Scalar(0, 255, 255),  // Yellow
+            cv::Scalar(128, 0, 0),    // Maroon
+            cv::Scalar(0, 128, 0),    // Olive
+            cv::Scalar(0, 0, 128),    // Navy
+            cv::Scalar(128, 128, 0),  // Teal
+            cv::Scalar(128, 0, 128),  // Purple
+            cv::Scalar(0, 128, 128)   // Aqua
+        } {
+        m_worker = std::thread(&AnnotationRenderer::run, this);
+    }
+
+    AnnotationRenderer(const AnnotationRenderer&) = delete;
+    AnnotationRenderer& operator=(const AnnotationRenderer&) = delete;
+
+    // Renders the frames still queued before returning
+    ~AnnotationRenderer() {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stop = true;
+        }
+        m_cv.notify_one();
+        if (m_worker.joinable()) {
+            m_worker.join();
+        }
+    }
+
+    /**
+     * @brief Queue a frame for rendering, returns immediately.
+     * @param image Decoded frame, it must not be modified afterwards (the worker reads it).
+     * @param downscale Decode scale of <image>, the bboxes are in original image coordinates.
+     * @return false if the frame was rate-limited or displaced an older frame from the full queue.
+     */
+    bool submit(std::shared_ptr<const cv::Mat> image, const std::vector<dnn_algorithm::ObjDetectOutput>& outputs, int downscale = 1) {
+        auto now = Clock::now();
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_stats.submitted++;
+        if (m_hasSubmitted && now - m_lastSubmit < m_minInterval) {
+            m_stats.skipped++;
+            return false;
+        }
+        m_hasSubmitted = true;
+        m_lastSubmit = now;
+
+        bool displaced = false;
+        if (m_queue.size() >= m_queueSize) {
+            m_queue.pop_front();
+            m_stats.dropped++;
+            displaced = true;
+        }
+        m_queue.push_back({std::move(image), outputs, std::max(downscale, 1)});
+        lock.unlock();
+        m_cv.notify_one();
+        return !displaced;
+    }
+
+    Stats getStats() const {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_stats;
+    }
+
+private:
+    struct Job {
+        std::shared_ptr<const cv::Mat> image{};
+        std::vector<dnn_algorithm::ObjDetectOutput> outputs{};
+        int downscale{1};
+    };
+
+    void run() {
+        // encode and file write, off the cores of the detection stages
+        common::CpuAffinity::applyToCurrentThread(common::CpuAffinity::Stage::IO);
+        Job job;
+        while (true) {
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_cv.wait(lock, [this]() { return m_stop || !m_queue.empty(); });
+                if (m_queue.empty()) {
+                    return;
+                }
+                job = std::move(m_queue.front());
+                m_queue.pop_front();
+            }
+
+            auto start = Clock::now();
+            bool written = false;
+            bool failed = false;
+            try {
+                written = render(job);
+            }
+            catch (const std::exception& e) {
+                // keep the worker alive for the next frame
+                std::cerr << "AnnotationRenderer: " << m_outputPath << ": " << e.what() << std::endl;
+                failed = true;
+            }
+            float elapsed = std::chrono::duration<float, std::milli>(Clock::now() - start).count();
+
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stats.written += written ? 1 : 0;
+            m_stats.failed += failed ? 1 : 0;
+            m_stats.lastRenderMs = elapsed;
+        }
+    }
+
+    bool render(const Job& job) {
+        if (job.image == nullptr || job.image->empty()) {
+            return false;
+        }
+        // copyTo keeps the canvas allocation while the frame size does not change
+        job.image->copyTo(m_canvas);
+        for (const auto& obj : job.outputs) {
+            cv::Point top_left(obj.bbox.left / job.downscale, obj.bbox.top / job.downscale);
+            cv::Point bottom_right(obj.bbox.right / job.downscale, obj.bbox.bottom / job.downscale);
+            cv::rectangle(m_canvas, top_left, bottom_right, colorOf(obj.label), 2);
+            cv::putText(m_canvas, obj.label, cv::Point(top_left.x, top_left.y + 12), cv::FONT_HERSHEY_COMPLEX, 0.4, cv::Scalar(255, 255, 255));
+        }
+
+        // imencode reuses the capacity of m_encoded
+        std::string extension = ".jpg";
+        auto dot = m_outputPath.rfind('.');
+        if (dot != std::string::npos) {
+            extension = m_outputPath.substr(dot);
+        }
+        if (!cv::imencode(extension, m_canvas, m_encoded)) {
+            return false;
+        }
+        std::ofstream file(m_outputPath, std::ios::binary | std::ios::trunc);
+        file.write(reinterpret_cast<const char*>(m_encoded.data()), static_cast<std::streamsize>(m_encoded.size()));
+        return file.good();
+    }
+
+    const cv::Scalar& colorOf(const std::string& label) {
+        auto it = m_labelColors.find(label);
+        if (it == m_labelColors.end()) {
+            it = m_labelColors.emplace(label, m_palette[m_labelColors.size() % m_palette.size()]).first;
+        }
+        return it->second;
+    }
+
+private:
+    std::string m_outputPath;
+    std::chrono::milliseconds m_minInterval;
+    size_t m_queueSize;
+    const std::vector<cv::Scalar> m_palette;
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_cv;
+    std::deque<Job> m_queue{};
+    bool m_stop{false};
+    bool m_hasSubmitted{false};
+    Clock::time_point m_lastSubmit{};
+    Stats m_stats{};
+
+    // worker only
+    cv::Mat m_canvas{};
+    std::vector<uchar> m_encoded{};
+    std::unordered_map<std::string, cv::Scalar> m_labelColors{};
+
+    std::thread m_worker;
+};
+
+} // namespace example
+
+
+#endif // __ANNOTATION_RENDERER_HPP__
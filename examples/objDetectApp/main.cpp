@@ -14,6 +14,10 @@ int main(int argc, char* argv[])
     parser.addOption("--label, --labelTextPath", std::string(""), "Path to the label text file");
     parser.addOption("--model, --modelPath", std::string(""), "Path to the model file");
     parser.addOption("--image, --imagePath", std::string(""), "Path to the input image file");
+    parser.addOption("--warmup", int(1), "Number of warmup inferences before the first image");
+    parser.addOption("--output", std::string("output.jpg"), "Annotated preview image, empty to disable");
+    parser.addOption("--preview_interval_ms", int(1000), "Minimum interval between two annotated previews");
+    parser.addOption("--resultLogDir", std::string(""), "Append the detections to a result log in this directory, empty to disable");
 
     parser.addSubOption("objDetectParams", "--conf_threshold", float(0.25), "objDetectParams conf_threshold");
     parser.addSubOption("objDetectParams", "--nms_threshold", float(0.45), "objDetectParams nms_threshold");
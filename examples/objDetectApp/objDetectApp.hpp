@@ -4,6 +4,10 @@
 #include "common/Logger.hpp"
 #include "common/ArgParser.hpp"
 #include "algorithms/object_detect/dnnObjDetector.hpp"
+#include "algorithms/object_detect/imageDecoder.hpp"
+#include "algorithms/result_log/resultLogWriter.hpp"
+#include "annotationRenderer.hpp"
+#include <chrono>
 #include <memory>
 #include <string>
 #include <iostream>
@@ -25,21 +29,7 @@ public:
 
     ObjDetectApp(common::ArgParser&& args) : 
         m_args(std::move(args)),
-        m_logger{std::make_unique<common::Logger>("ObjDetectApp")},
-        m_colors{
-            cv::Scalar(255, 0, 0),    // Blue
-            cv::Scalar(0, 255, 0),    // Green
-            cv::Scalar(0, 0, 255),    // Red
-            cv::Scalar(255, 255, 0),  // Cyan
-            cv::Scalar(255, 0, 255),  // Magenta
-            cv::Scalar(0, 255, 255),  // Yellow
-            cv::Scalar(128, 0, 0),    // Maroon
-            cv::Scalar(0, 128, 0),    // Olive
-            cv::Scalar(0, 0, 128),    // Navy
-            cv::Scalar(128, 128, 0),  // Teal
-            cv::Scalar(128, 0, 128),  // Purple
-            cv::Scalar(0, 128, 128)   // Aqua
-        } {
+        m_logger{std::make_unique<common::Logger>("ObjDetectApp")} {
         
         m_logger->setPattern();
 
@@ -49,14 +39,30 @@ public:
         m_args.getOptionVal("--dnnType", dnnType);
         m_args.getOptionVal("--pluginPath", pluginPath);
         m_args.getOptionVal("--labelTextPath", labelTextPath);
-        m_dnnObjDetector = std::make_unique<dnn_algorithm::dnnObjDetector>(dnnType, pluginPath, labelTextPath);
-
         std::string modelPath;
         m_args.getOptionVal("--modelPath", modelPath);
-        m_dnnObjDetector->loadModel(modelPath);
+        int warmupRuns = 1;
+        m_args.getOptionVal("--warmup", warmupRuns);
+        m_dnnObjDetector = dnn_algorithm::dnnObjDetector::create(dnnType, pluginPath, labelTextPath, modelPath, warmupRuns);
         std::string imagePath;
         m_args.getOptionVal("--imagePath", imagePath);
-        m_orig_image_ptr = std::make_shared<cv::Mat>(cv::imread(imagePath, cv::IMREAD_COLOR));
+        loadImage(imagePath);
+
+        std::string resultLogDir;
+        m_args.getOptionVal("--resultLogDir", resultLogDir);
+        if (!resultLogDir.empty()) {
+            ResultLogParams logParams;
+            logParams.directory = resultLogDir;
+            m_resultLog = std::make_unique<resultLogWriter>(logParams);
+        }
+
+        std::string outputPath;
+        int previewIntervalMs = 1000;
+        m_args.getOptionVal("--output", outputPath);
+        m_args.getOptionVal("--preview_interval_ms", previewIntervalMs);
+        if (!outputPath.empty()) {
+            m_renderer = std::make_unique<AnnotationRenderer>(outputPath, std::chrono::milliseconds(previewIntervalMs));
+        }
     }
 
     ObjDetectApp(const ObjDetectApp&) = delete;
@@ -65,6 +71,8 @@ public:
     ObjDetectApp& operator=(ObjDetectApp&&) = delete;
 
     ~ObjDetectApp() {
+        // finishes the pending preview
+        m_renderer.reset();
         m_dnnObjDetector.reset();
 
         m_logger->printStdoutLog(common::Logger::LogLevel::Debug, "{} ObjDetectApp::~ObjDetectApp()", LOG_TAG);
@@ -77,11 +85,17 @@ public:
         dnn_algorithm::ObjDetectInput objDetectInput = {
             .handleType = "opencv4",
             .imageHandle = m_orig_image_ptr,
+            .decodeDownscale = m_decodeDownscale,
         };
         m_dnnObjDetector->pushInputData(std::make_shared<dnn_algorithm::ObjDetectInput>(objDetectInput));
         setObjDetectParams(m_objDetectParams);
         m_dnnObjDetector->runObjDetect(m_objDetectParams);
         auto& objDetectOutput = m_dnnObjDetector->popOutputData();
+        if (m_resultLog != nullptr) {
+            auto now = std::chrono::system_clock::now().time_since_epoch();
+            uint64_t timestampNs = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(now).count());
+            m_resultLog->append(0, timestampNs, m_frameId++, objDetectOutput);
+        }
 
         for (const auto& item : objDetectOutput) {
             m_logger->printStdoutLog(common::Logger::LogLevel::Debug,
@@ -89,27 +103,38 @@ public:
                 item.label, item.score, item.bbox.left, item.bbox.right, item.bbox.top, item.bbox.bottom);
         }
 
-        std::map<std::string, cv::Scalar> labelColorMap;
-        for (size_t i = 0; i < objDetectOutput.size(); ++i) {
-            const auto& obj = objDetectOutput[i];
-            if (labelColorMap.find(obj.label) == labelColorMap.end()) {
-                labelColorMap[obj.label] = m_colors[i % m_colors.size()];
-            }
-        }
-
         for (const auto& obj : objDetectOutput) {
             m_logger->printStdoutLog(common::Logger::LogLevel::Info, "{} ObjDetectApp::onProcess() objDetectOutput: bbox: [{}, {}, {}, {}], score: {}, label: {}",
                 LOG_TAG, obj.bbox.left, obj.bbox.top, obj.bbox.right, obj.bbox.bottom, obj.score, obj.label);
-            cv::rectangle(*m_orig_image_ptr, cv::Point(obj.bbox.left, obj.bbox.top), cv::Point(obj.bbox.right, obj.bbox.bottom),
-                    labelColorMap[obj.label], 2);
-            cv::putText(*m_orig_image_ptr, obj.label, cv::Point(obj.bbox.left, obj.bbox.top + 12), cv::FONT_HERSHEY_COMPLEX, 0.4, cv::Scalar(256, 255, 255));
         }
 
-        cv::imwrite("output.jpg", *m_orig_image_ptr);
+        // drawing and encoding happen on the renderer's thread, the source image is left untouched
+        if (m_renderer != nullptr) {
+            m_renderer->submit(m_orig_image_ptr, objDetectOutput, m_decodeDownscale);
+        }
     }
 
 
 private:
+    void loadImage(const std::string& imagePath) {
+        // Decode at the smallest DCT scale that still covers the model input
+        IDnnEngine::dnnInputShape shape;
+        m_dnnObjDetector->getInputShape(shape);
+
+        imageDecoder::DecodedImage decoded;
+        if (imageDecoder::decode(imagePath, shape.width, shape.height, decoded) != 0) {
+            m_logger->printStdoutLog(common::Logger::LogLevel::Error, "{} Failed to decode image: {}", LOG_TAG, imagePath);
+            throw std::runtime_error("Failed to decode image.");
+        }
+        m_logger->printStdoutLog(common::Logger::LogLevel::Debug, "{} decoded {}x{} image at 1/{} scale",
+            LOG_TAG, decoded.origWidth, decoded.origHeight, decoded.downscale);
+
+        m_orig_image_ptr = decoded.image;
+        m_origImageWidth = decoded.origWidth;
+        m_origImageHeight = decoded.origHeight;
+        m_decodeDownscale = decoded.downscale;
+    }
+
     void setObjDetectParams(ObjDetectParams& objDetectParams) {
         IDnnEngine::dnnInputShape shape;
         m_dnnObjDetector->getInputShape(shape);
@@ -119,8 +144,8 @@ private:
         objDetectParams.model_input_channel = shape.channel;
         m_args.getSubOptionVal("objDetectParams", "--conf_threshold", objDetectParams.conf_threshold);
         m_args.getSubOptionVal("objDetectParams", "--nms_threshold", objDetectParams.nms_threshold);
-        objDetectParams.scale_width = static_cast<float>(shape.width) / static_cast<float>(m_orig_image_ptr->cols);
-        objDetectParams.scale_height = static_cast<float>(shape.height) / static_cast<float>(m_orig_image_ptr->rows);
+        objDetectParams.scale_width = static_cast<float>(shape.width) / static_cast<float>(m_origImageWidth);
+        objDetectParams.scale_height = static_cast<float>(shape.height) / static_cast<float>(m_origImageHeight);
         m_args.getSubOptionVal("objDetectParams", "--pads_left", objDetectParams.pads.left);
         m_args.getSubOptionVal("objDetectParams", "--pads_right", objDetectParams.pads.right);
         m_args.getSubOptionVal("objDetectParams", "--pads_top", objDetectParams.pads.top);
@@ -134,7 +159,12 @@ private:
     std::unique_ptr<dnn_algorithm::dnnObjDetector> m_dnnObjDetector{nullptr};
     dnn_algorithm::ObjDetectParams m_objDetectParams{};
     std::shared_ptr<cv::Mat> m_orig_image_ptr{nullptr};
-    std::vector<cv::Scalar> m_colors; // for bounding box
+    size_t m_origImageWidth{0};
+    size_t m_origImageHeight{0};
+    int m_decodeDownscale{1};
+    std::unique_ptr<AnnotationRenderer> m_renderer{nullptr};
+    std::unique_ptr<dnn_algorithm::resultLogWriter> m_resultLog{nullptr};
+    uint64_t m_frameId{0};
 };
 
 
@@ -0,0 +1,118 @@
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <opencv2/opencv.hpp>
+#include <sys/un.h>
+#include "common/ArgParser.hpp"
+#include "serverProtocol.hpp"
+
+using namespace example;
+using namespace common;
+namespace proto = server_protocol;
+
+
+// Sends one image to objDetectServer <count> times and prints the detections and the round-trip time
+int main(int argc, char* argv[])
+{
+    ArgParser parser("ObjDetectClient");
+    parser.addOption("--socket, --socketPath", std::string("/tmp/dnn_infer.sock"), "Unix-domain socket of the server");
+    parser.addOption("--model", std::string(""), "Model name on the server, empty for the first one");
+    parser.addOption("--image, --imagePath", std::string(""), "Path to the input image file");
+    parser.addOption("--count", int(1), "Number of requests");
+    parser.addOption("--conf_threshold", float(0.25), "conf_threshold");
+    parser.addOption("--nms_threshold", float(0.45), "nms_threshold");
+    parser.parseArgs(argc, argv);
+
+    std::string socketPath;
+    std::string model;
+    std::string imagePath;
+    int count = 1;
+    float confThreshold = 0.25f;
+    float nmsThreshold = 0.45f;
+    parser.getOptionVal("--socketPath", socketPath);
+    parser.getOptionVal("--model", model);
+    parser.getOptionVal("--imagePath", imagePath);
+    parser.getOptionVal("--count", count);
+    parser.getOptionVal("--conf_threshold", confThreshold);
+    parser.getOptionVal("--nms_threshold", nmsThreshold);
+
+    cv::Mat image = cv::imread(imagePath, cv::IMREAD_COLOR);
+    if (image.empty()) {
+        std::cerr << "Failed to read image: " << imagePath << std::endl;
+        return -1;
+    }
+
+    std::string shmName = "dnn_client_" + std::to_string(getpid());
+    uint64_t slotSize = image.total() * image.elemSize();
+    auto ring = proto::shmRing::create(shmName, 2, slotSize);
+    if (ring == nullptr) {
+        std::cerr << "Failed to create the sealed ring " << shmName << ": " << strerror(errno) << std::endl;
+        return -1;
+    }
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    std::strncpy(addr.sun_path, socketPath.c_str(), sizeof(addr.sun_path) - 1);
+    if (fd < 0 || connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+        std::cerr << "Failed to connect to " << socketPath << ": " << strerror(errno) << std::endl;
+        return -1;
+    }
+
+    proto::HelloMsg hello{};
+    std::strncpy(hello.shm_name, shmName.c_str(), sizeof(hello.shm_name) - 1);
+    std::strncpy(hello.model, model.c_str(), sizeof(hello.model) - 1);
+    proto::MsgHeader header;
+    proto::HelloAckMsg ack{};
+    if (!proto::sendMsgWithFd(fd, proto::MsgType::Hello, &hello, sizeof(hello), ring->getFd())
+            || !proto::recvAll(fd, &header, sizeof(header)) || header.length != sizeof(ack)
+            || !proto::recvAll(fd, &ack, sizeof(ack)) || ack.status != 0) {
+        std::cerr << "Handshake failed" << std::endl;
+        close(fd);
+        return -1;
+    }
+    std::cout << "Connected, model input " << ack.model_input_width << "x" << ack.model_input_height << std::endl;
+
+    for (int i = 0; i < count; i++) {
+        uint32_t slot = static_cast<uint32_t>(i) % ring->getSlotCount();
+        cv::Mat dst(image.rows, image.cols, CV_8UC3, ring->slot(slot));
+        image.copyTo(dst);
+
+        proto::DetectMsg detect{};
+        detect.request_id = static_cast<uint64_t>(i);
+        detect.slot = slot;
+        detect.format = static_cast<uint32_t>(proto::PixelFormat::BGR);
+        detect.width = static_cast<uint32_t>(image.cols);
+        detect.height = static_cast<uint32_t>(image.rows);
+        detect.stride = static_cast<uint32_t>(image.step);
+        detect.conf_threshold = confThreshold;
+        detect.nms_threshold = nmsThreshold;
+
+        auto start = std::chrono::steady_clock::now();
+        proto::ResultMsg result{};
+        if (!proto::sendMsg(fd, proto::MsgType::Detect, &detect, sizeof(detect))
+                || !proto::recvAll(fd, &header, sizeof(header)) || header.length < sizeof(result)
+                || !proto::recvAll(fd, &result, sizeof(result))) {
+            std::cerr << "Connection lost" << std::endl;
+            break;
+        }
+        std::vector<proto::ResultBox> boxes(result.count);
+        if (header.length != sizeof(result) + boxes.size() * sizeof(proto::ResultBox)
+                || (!boxes.empty() && !proto::recvAll(fd, boxes.data(), boxes.size() * sizeof(proto::ResultBox)))) {
+            std::cerr << "Invalid result" << std::endl;
+            break;
+        }
+        auto elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        std::cout << "request " << result.request_id << ": status " << result.status << ", "
+                  << boxes.size() << " objects, " << elapsed << " ms" << std::endl;
+        for (const auto& box : boxes) {
+            std::cout << "  " << box.label << " " << box.score << " [" << box.left << ", " << box.top
+                      << ", " << box.right << ", " << box.bottom << "]" << std::endl;
+        }
+    }
+
+    close(fd);
+    return 0;
+}
@@ -0,0 +1,27 @@
+#include <csignal>
+#include <iostream>
+#include <string>
+#include "objDetectServer.hpp"
+
+using namespace example;
+using namespace common;
+
+
+int main(int argc, char* argv[])
+{
+    ArgParser parser("ObjDetectServer");
+    parser.addOption("--dnn, --dnnType", std::string("rknn"), "DNN type: trt or rknn");
+    parser.addOption("--models", std::string(""), "Models to serve: name,pluginPath,labelTextPath,modelPath;...");
+    parser.addOption("--plugin, --pluginPath", std::string(""), "Path to the plugin library (single model)");
+    parser.addOption("--label, --labelTextPath", std::string(""), "Path to the label text file (single model)");
+    parser.addOption("--model, --modelPath", std::string(""), "Path to the model file (single model)");
+    parser.addOption("--socket, --socketPath", std::string("/tmp/dnn_infer.sock"), "Unix-domain socket to listen on");
+
+    parser.parseArgs(argc, argv);
+
+    std::signal(SIGINT, [](int) { ObjDetectServer::requestStop(); });
+    std::signal(SIGTERM, [](int) { ObjDetectServer::requestStop(); });
+
+    ObjDetectServer server(std::move(parser));
+    return server.run();
+}
@@ -0,0 +1,413 @@
+#ifndef __OBJDETECTSERVER_HPP__
+#define __OBJDETECTSERVER_HPP__
+
+#include "serverProtocol.hpp"
+#include "common/Logger.hpp"
+#include "common/ArgParser.hpp"
+#include "algorithms/object_detect/dnnObjDetector.hpp"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <opencv2/opencv.hpp>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+
+namespace example {
+
+using namespace dnn_algorithm;
+namespace proto = server_protocol;
+
+/**
+ * Local inference server: the models are loaded once and shared by every client.
+ * Clients connect over a Unix-domain socket, frames are read from the client's shared-memory ring.
+ * Each model has one worker; requests of all clients are queued per model and drained back-to-back,
+ * so the NPU context of a model is shared instead of being loaded by every application.
+ */
+class ObjDetectServer {
+public:
+    static constexpr char LOG_TAG[] {"[ObjDetectServer]: "};
+
+    ObjDetectServer(common::ArgParser&& args) :
+        m_args(std::move(args)),
+        m_logger{std::make_unique<common::Logger>("ObjDetectServer")} {
+
+        m_logger->setPattern();
+
+        std::string dnnType;
+        m_args.getOptionVal("--dnnType", dnnType);
+        std::vector<std::string> modelSpecs;
+        m_args.getOptionSplitStrList("--models", modelSpecs);
+        if (modelSpecs.empty() || (modelSpecs.size() == 1 && modelSpecs[0].empty())) {
+            // single model from the objDetectApp style options
+            std::string pluginPath;
+            std::string labelTextPath;
+            std::string modelPath;
+            m_args.getOptionVal("--pluginPath", pluginPath);
+            m_args.getOptionVal("--labelTextPath", labelTextPath);
+            m_args.getOptionVal("--modelPath", modelPath);
+            modelSpecs = {"default," + pluginPath + "," + labelTextPath + "," + modelPath};
+        }
+
+        for (const auto& spec : modelSpecs) {
+            loadModel(dnnType, spec);
+        }
+        m_args.getOptionVal("--socketPath", m_socketPath);
+    }
+
+    ObjDetectServer(const ObjDetectServer&) = delete;
+    ObjDetectServer& operator=(const ObjDetectServer&) = delete;
+    ObjDetectServer(ObjDetectServer&&) = delete;
+    ObjDetectServer& operator=(ObjDetectServer&&) = delete;
+
+    ~ObjDetectServer() {
+        stop();
+        for (auto& client_thread : m_clientThreads) {
+            client_thread.thread.join();
+        }
+        for (auto& model : m_models) {
+            {
+                std::lock_guard<std::mutex> lock(model->mutex);
+                model->stop = true;
+            }
+            model->cv.notify_all();
+            model->worker.join();
+        }
+        m_logger->printStdoutLog(common::Logger::LogLevel::Debug, "{} ObjDetectServer::~ObjDetectServer()", LOG_TAG);
+    }
+
+    // Async-signal-safe, for SIGINT/SIGTERM handlers
+    static void requestStop() {
+        s_stopRequested = true;
+    }
+
+    // Accept clients until stop() or requestStop() is called
+    int run() {
+        m_listenFd = socket(AF_UNIX, SOCK_STREAM, 0);
+        sockaddr_un addr{};
+        addr.sun_family = AF_UNIX;
+        if (m_listenFd < 0 || m_socketPath.size() >= sizeof(addr.sun_path)) {
+            m_logger->printStdoutLog(common::Logger::LogLevel::Error, "{} Invalid socket path: {}", LOG_TAG, m_socketPath);
+            return -1;
+        }
+        std::strncpy(addr.sun_path, m_socketPath.c_str(), sizeof(addr.sun_path) - 1);
+        unlink(m_socketPath.c_str());
+        if (bind(m_listenFd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 || listen(m_listenFd, 16) != 0) {
+            m_logger->printStdoutLog(common::Logger::LogLevel::Error, "{} Failed to listen on {}: {}", LOG_TAG, m_socketPath, strerror(errno));
+            close(m_listenFd);
+            return -1;
+        }
+        m_logger->printStdoutLog(common::Logger::LogLevel::Info, "{} listening on {}", LOG_TAG, m_socketPath);
+
+        while (!m_stop && !s_stopRequested) {
+            reapClientThreads();
+            pollfd pfd{m_listenFd, POLLIN, 0};
+            if (poll(&pfd, 1, 200) <= 0) {
+                continue;
+            }
+            int fd = accept(m_listenFd, nullptr, nullptr);
+            if (fd < 0) {
+                continue;
+            }
+            auto client = std::make_shared<Client>();
+            client->fd = fd;
+            auto done = std::make_shared<std::atomic<bool>>(false);
+            std::lock_guard<std::mutex> lock(m_clientsMutex);
+            m_clients.push_back(client);
+            m_clientThreads.push_back({std::thread(&ObjDetectServer::serveClient, this, client, done), done});
+        }
+
+        close(m_listenFd);
+        unlink(m_socketPath.c_str());
+        stop();
+        return 0;
+    }
+
+    void stop() {
+        m_stop = true;
+        std::lock_guard<std::mutex> lock(m_clientsMutex);
+        for (auto& client : m_clients) {
+            // unblocks the reader thread of the client
+            shutdown(client->fd, SHUT_RDWR);
+        }
+    }
+
+private:
+    struct Client;
+
+    struct Request {
+        std::shared_ptr<Client> client{};
+        proto::DetectMsg msg{};
+    };
+
+    struct Model {
+        std::string name{};
+        std::unique_ptr<dnnObjDetector> detector{};
+        ObjDetectParams baseParams{};
+        std::mutex mutex;
+        std::condition_variable cv;
+        std::deque<Request> requests{};
+        bool stop{false};
+        std::thread worker;
+    };
+
+    // Closed when the last queued request of the client is answered, so the fd is never reused under a worker
+    struct Client {
+        int fd{-1};
+        std::shared_ptr<proto::shmRing> ring{};
+        Model* model{nullptr};
+        std::mutex writeMutex;
+
+        ~Client() {
+            if (fd >= 0) {
+                close(fd);
+            }
+        }
+    };
+
+    struct ClientThread {
+        std::thread thread;
+        std::shared_ptr<std::atomic<bool>> done{};     // set as the last step of serveClient
+    };
+
+    // spec: "name,pluginPath,labelTextPath,modelPath"
+    void loadModel(const std::string& dnnType, const std::string& spec) {
+        std::vector<std::string> fields;
+        std::stringstream ss(spec);
+        std::string field;
+        while (std::getline(ss, field, ',')) {
+            fields.push_back(field);
+        }
+        if (fields.size() != 4) {
+            throw std::invalid_argument("Invalid model spec, expected name,plugin,labels,model: " + spec);
+        }
+
+        auto model = std::make_unique<Model>();
+        model->name = fields[0];
+        model->detector = dnnObjDetector::create(dnnType, fields[1], fields[2], fields[3]);
+
+        IDnnEngine::dnnInputShape shape;
+        model->detector->getInputShape(shape);
+        model->baseParams.model_input_width = shape.width;
+        model->baseParams.model_input_height = shape.height;
+        model->baseParams.model_input_channel = shape.channel;
+        model->detector->getOutputQuantParams(model->baseParams.quantize_zero_points, model->baseParams.quantize_scales);
+        m_logger->printStdoutLog(common::Logger::LogLevel::Info, "{} loaded model {}: {} ({}x{})",
+            LOG_TAG, model->name, fields[3], shape.width, shape.height);
+
+        model->worker = std::thread(&ObjDetectServer::modelLoop, this, model.get());
+        m_models.push_back(std::move(model));
+    }
+
+    Model* findModel(const std::string& name) {
+        if (name.empty()) {
+            return m_models.empty() ? nullptr : m_models.front().get();
+        }
+        for (auto& model : m_models) {
+            if (model->name == name) {
+                return model.get();
+            }
+        }
+        return nullptr;
+    }
+
+    // Join the threads of the disconnected clients, only the accept loop adds threads
+    void reapClientThreads() {
+        for (auto it = m_clientThreads.begin(); it != m_clientThreads.end();) {
+            if (*it->done) {
+                it->thread.join();
+                it = m_clientThreads.erase(it);
+            }
+            else {
+                ++it;
+            }
+        }
+    }
+
+    void serveClient(std::shared_ptr<Client> client, std::shared_ptr<std::atomic<bool>> done) {
+        proto::MsgHeader header;
+        while (proto::recvAll(client->fd, &header, sizeof(header))) {
+            auto type = static_cast<proto::MsgType>(header.type);
+            if (type == proto::MsgType::Hello && header.length == sizeof(proto::HelloMsg)) {
+                proto::HelloMsg hello;
+                int ring_fd = -1;
+                if (!proto::recvAllWithFd(client->fd, &hello, sizeof(hello), ring_fd)) {
+                    break;
+                }
+                hello.shm_name[sizeof(hello.shm_name) - 1] = '\0';
+                hello.model[sizeof(hello.model) - 1] = '\0';
+                if (client->ring != nullptr && client->model != nullptr) {
+                    // the model worker reads the session of the queued requests, it is fixed once established
+                    m_logger->printStdoutLog(common::Logger::LogLevel::Error, "{} repeated Hello rejected", LOG_TAG);
+                    if (ring_fd >= 0) {
+                        close(ring_fd);
+                    }
+                    proto::HelloAckMsg ack{};
+                    ack.status = -1;
+                    std::lock_guard<std::mutex> lock(client->writeMutex);
+                    proto::sendMsg(client->fd, proto::MsgType::HelloAck, &ack, sizeof(ack));
+                    continue;
+                }
+                client->ring = proto::shmRing::open(hello.shm_name, ring_fd);
+                if (client->ring == nullptr) {
+                    m_logger->printStdoutLog(common::Logger::LogLevel::Error, "{} ring {} is not a sealed memfd", LOG_TAG, hello.shm_name);
+                }
+                client->model = findModel(hello.model);
+
+                proto::HelloAckMsg ack{};
+                ack.status = (client->ring != nullptr && client->model != nullptr) ? 0 : -1;
+                if (client->model != nullptr) {
+                    ack.model_input_width = static_cast<uint32_t>(client->model->baseParams.model_input_width);
+                    ack.model_input_height = static_cast<uint32_t>(client->model->baseParams.model_input_height);
+                }
+                std::lock_guard<std::mutex> lock(client->writeMutex);
+                proto::sendMsg(client->fd, proto::MsgType::HelloAck, &ack, sizeof(ack));
+            }
+            else if (type == proto::MsgType::Detect && header.length == sizeof(proto::DetectMsg)) {
+                Request request;
+                if (!proto::recvAll(client->fd, &request.msg, sizeof(request.msg))) {
+                    break;
+                }
+                if (client->ring == nullptr || client->model == nullptr) {
+                    sendResult(*client, request.msg.request_id, -1, {});
+                    continue;
+                }
+                request.client = client;
+                Model* model = client->model;
+                std::lock_guard<std::mutex> lock(model->mutex);
+                model->requests.push_back(std::move(request));
+                model->cv.notify_one();
+            }
+            else {
+                m_logger->printStdoutLog(common::Logger::LogLevel::Error, "{} invalid message type {} length {}", LOG_TAG, header.type, header.length);
+                break;
+            }
+        }
+        {
+            std::lock_guard<std::mutex> lock(m_clientsMutex);
+            m_clients.erase(std::remove(m_clients.begin(), m_clients.end(), client), m_clients.end());
+        }
+        *done = true;
+    }
+
+    // Requests of all clients of the model are drained back-to-back on one NPU context
+    void modelLoop(Model* model) {
+        while (true) {
+            std::deque<Request> batch;
+            {
+                std::unique_lock<std::mutex> lock(model->mutex);
+                model->cv.wait(lock, [model]() { return model->stop || !model->requests.empty(); });
+                if (model->stop) {
+                    return;
+                }
+                batch.swap(model->requests);
+            }
+            for (auto& request : batch) {
+                std::vector<ObjDetectOutput> outputs;
+                int status = detect(*model, *request.client, request.msg, outputs);
+                sendResult(*request.client, request.msg.request_id, status, outputs);
+            }
+        }
+    }
+
+    int detect(Model& model, Client& client, const proto::DetectMsg& msg, std::vector<ObjDetectOutput>& outputs) {
+        auto format = static_cast<proto::PixelFormat>(msg.format);
+        if (msg.slot >= client.ring->getSlotCount()
+                || !proto::isValidFrame(format, msg.width, msg.height, msg.stride, client.ring->getSlotSize())) {
+            return -1;
+        }
+
+        const uint8_t* pixels = client.ring->slot(msg.slot);
+        auto input = std::make_shared<ObjDetectInput>();
+        switch (format) {
+        case proto::PixelFormat::BGR:
+            input->handleType = "opencv4";
+            // wraps the read-only slot without a copy, the client does not reuse it before the result arrives
+            input->imageHandle = std::make_shared<cv::Mat>(msg.height, msg.width, CV_8UC3, const_cast<uint8_t*>(pixels), msg.stride);
+            break;
+        case proto::PixelFormat::NV12:
+        case proto::PixelFormat::NV21:
+        case proto::PixelFormat::YUYV: {
+            YuvImageHandle handle;
+            handle.width = msg.width;
+            handle.height = msg.height;
+            handle.planes[0] = pixels;
+            handle.strides[0] = msg.stride;
+            if (format == proto::PixelFormat::YUYV) {
+                input->handleType = "yuyv";
+            }
+            else {
+                input->handleType = format == proto::PixelFormat::NV12 ? "nv12" : "nv21";
+                handle.planes[1] = pixels + static_cast<size_t>(msg.stride) * msg.height;
+                handle.strides[1] = msg.stride;
+            }
+            input->imageHandle = handle;
+            break;
+        }
+        default:
+            return -1;
+        }
+
+        ObjDetectParams params = model.baseParams;
+        params.conf_threshold = msg.conf_threshold;
+        params.nms_threshold = msg.nms_threshold;
+        params.scale_width = static_cast<float>(params.model_input_width) / static_cast<float>(msg.width);
+        params.scale_height = static_cast<float>(params.model_input_height) / static_cast<float>(msg.height);
+
+        try {
+            model.detector->pushInputData(input);
+            int ret = model.detector->runObjDetect(params);
+            outputs = model.detector->popOutputData();
+            return ret;
+        }
+        catch (const std::exception& e) {
+            m_logger->printStdoutLog(common::Logger::LogLevel::Error, "{} detection failed: {}", LOG_TAG, e.what());
+            return -1;
+        }
+    }
+
+    void sendResult(Client& client, uint64_t requestId, int status, const std::vector<ObjDetectOutput>& outputs) {
+        std::vector<uint8_t> payload(sizeof(proto::ResultMsg) + outputs.size() * sizeof(proto::ResultBox));
+        proto::ResultMsg result{requestId, status, static_cast<uint32_t>(outputs.size())};
+        std::memcpy(payload.data(), &result, sizeof(result));
+        for (size_t i = 0; i < outputs.size(); i++) {
+            proto::ResultBox box{};
+            box.left = outputs[i].bbox.left;
+            box.top = outputs[i].bbox.top;
+            box.right = outputs[i].bbox.right;
+            box.bottom = outputs[i].bbox.bottom;
+            box.score = outputs[i].score;
+            box.track_id = outputs[i].trackId;
+            std::strncpy(box.label, outputs[i].label.c_str(), proto::LABEL_SIZE - 1);
+            std::memcpy(payload.data() + sizeof(result) + i * sizeof(box), &box, sizeof(box));
+        }
+        std::lock_guard<std::mutex> lock(client.writeMutex);
+        proto::sendMsg(client.fd, proto::MsgType::Result, payload.data(), payload.size());
+    }
+
+private:
+    common::ArgParser m_args;
+    std::unique_ptr<common::Logger> m_logger{nullptr};
+    std::string m_socketPath{};
+    int m_listenFd{-1};
+    std::atomic<bool> m_stop{false};
+    static inline std::atomic<bool> s_stopRequested{false};
+    std::vector<std::unique_ptr<Model>> m_models{};
+    std::mutex m_clientsMutex;
+    std::vector<std::shared_ptr<Client>> m_clients{};
+    std::vector<ClientThread> m_clientThreads{};
+};
+
+
+} // namespace example
+
+
+#endif // __OBJDETECTSERVER_HPP__
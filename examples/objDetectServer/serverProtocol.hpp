@@ -0,0 +1,335 @@
+#ifndef __SERVER_PROTOCOL_HPP__
+#define __SERVER_PROTOCOL_HPP__
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+namespace example {
+
+/**
+ * Wire format between objDetectServer and its clients, see README.md.
+ * All messages are <MsgHeader><payload> in little-endian, packed structs.
+ * Pixels never travel over the socket: the client writes the frame into a slot of its shared-memory
+ * ring and sends the slot index; the slot stays owned by the server until the matching result arrives.
+ * The ring is a sealed memfd passed with the Hello message, the client cannot shrink it under the server's mapping.
+ */
+namespace server_protocol {
+
+constexpr uint32_t RING_MAGIC = 0x524E4E44; // "DNNR"
+constexpr uint32_t PROTOCOL_VERSION = 2;
+constexpr size_t RING_DATA_OFFSET = 64;     // the slots start here, each slot_size bytes
+constexpr size_t LABEL_SIZE = 32;
+
+enum class MsgType : uint32_t {
+    Hello = 1,      // client -> server: HelloMsg
+    HelloAck = 2,   // server -> client: HelloAckMsg
+    Detect = 3,     // client -> server: DetectMsg
+    Result = 4      // server -> client: ResultMsg + count * ResultBox
+};
+
+enum class PixelFormat : uint32_t {
+    BGR = 0,
+    NV12 = 1,
+    NV21 = 2,
+    YUYV = 3
+};
+
+#pragma pack(push, 1)
+struct MsgHeader {
+    uint32_t type;
+    uint32_t length;    // payload bytes
+};
+
+struct RingHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t slot_count;
+    uint32_t reserved;
+    uint64_t slot_size;
+};
+
+// Sent together with the ring memfd as SCM_RIGHTS ancillary data
+struct HelloMsg {
+    char shm_name[64];  // name of the client ring for the logs, e.g. "dnn_client_1234"
+    char model[32];     // name of a model loaded by the server, empty for the first one
+};
+
+struct HelloAckMsg {
+    int32_t status;     // 0 on success
+    uint32_t model_input_width;
+    uint32_t model_input_height;
+};
+
+struct DetectMsg {
+    uint64_t request_id;
+    uint32_t slot;
+    uint32_t format;    // PixelFormat
+    uint32_t width;
+    uint32_t height;
+    uint32_t stride;    // bytes per row (of the Y plane for NV12/NV21, the UV plane follows it)
+    float conf_threshold;
+    float nms_threshold;
+};
+
+struct ResultMsg {
+    uint64_t request_id;
+    int32_t status;
+    uint32_t count;
+};
+
+struct ResultBox {
+    int32_t left;
+    int32_t top;
+    int32_t right;
+    int32_t bottom;
+    float score;
+    int32_t track_id;
+    char label[LABEL_SIZE];
+};
+#pragma pack(pop)
+
+// Bytes of pixels in one row, 0 for an unknown format
+inline size_t minRowBytes(PixelFormat format, uint32_t width) {
+    switch (format) {
+    case PixelFormat::BGR: return static_cast<size_t>(width) * 3;
+    case PixelFormat::NV12:
+    case PixelFormat::NV21: return width;
+    case PixelFormat::YUYV: return static_cast<size_t>(width) * 2;
+    default: return 0;
+    }
+}
+
+// Rows of <stride> bytes a frame occupies, the interleaved chroma plane of NV12/NV21 adds height / 2
+inline size_t frameRows(PixelFormat format, uint32_t height) {
+    return (format == PixelFormat::NV12 || format == PixelFormat::NV21) ? static_cast<size_t>(height) + height / 2 : height;
+}
+
+// Bytes a frame occupies in its slot
+inline size_t frameSize(PixelFormat format, uint32_t stride, uint32_t height) {
+    return static_cast<size_t>(stride) * frameRows(format, height);
+}
+
+// The frame described by a Detect message fits a slot of <slotBytes>. Chroma subsampled formats need an
+// even width (YUYV, NV12, NV21) and height (NV12, NV21).
+inline bool isValidFrame(PixelFormat format, uint32_t width, uint32_t height, uint32_t stride, size_t slotBytes) {
+    size_t rowBytes = minRowBytes(format, width);
+    if (rowBytes == 0 || height == 0 || stride < rowBytes) {
+        return false;
+    }
+    bool subsampled = format == PixelFormat::NV12 || format == PixelFormat::NV21;
+    if ((width % 2 != 0 && (subsampled || format == PixelFormat::YUYV)) || (height % 2 != 0 && subsampled)) {
+        return false;
+    }
+    return frameSize(format, stride, height) <= slotBytes;
+}
+
+inline bool sendAll(int fd, const void* data, size_t size) {
+    const uint8_t* ptr = static_cast<const uint8_t*>(data);
+    while (size > 0) {
+        ssize_t n = ::send(fd, ptr, size, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return false;
+        }
+        ptr += n;
+        size -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+inline bool recvAll(int fd, void* data, size_t size) {
+    uint8_t* ptr = static_cast<uint8_t*>(data);
+    while (size > 0) {
+        ssize_t n = ::recv(fd, ptr, size, 0);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return false;
+        }
+        ptr += n;
+        size -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+inline bool sendMsg(int fd, MsgType type, const void* payload, size_t length) {
+    MsgHeader header{static_cast<uint32_t>(type), static_cast<uint32_t>(length)};
+    return sendAll(fd, &header, sizeof(header)) && (length == 0 || sendAll(fd, payload, length));
+}
+
+// Like sendMsg, <passFd> travels with the first byte of the payload
+inline bool sendMsgWithFd(int fd, MsgType type, const void* payload, size_t length, int passFd) {
+    MsgHeader header{static_cast<uint32_t>(type), static_cast<uint32_t>(length)};
+    if (length == 0 || !sendAll(fd, &header, sizeof(header))) {
+        return false;
+    }
+    char control[CMSG_SPACE(sizeof(int))] = {};
+    iovec iov{const_cast<void*>(payload), 1};
+    msghdr msg{};
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+    cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+    std::memcpy(CMSG_DATA(cmsg), &passFd, sizeof(int));
+    ssize_t n;
+    do {
+        n = ::sendmsg(fd, &msg, MSG_NOSIGNAL);
+    } while (n < 0 && errno == EINTR);
+    return n == 1 && sendAll(fd, static_cast<const uint8_t*>(payload) + 1, length - 1);
+}
+
+// Like recvAll for a payload sent with sendMsgWithFd, <passedFd> is -1 if no descriptor came with it
+inline bool recvAllWithFd(int fd, void* data, size_t size, int& passedFd) {
+    passedFd = -1;
+    if (size == 0) {
+        return true;
+    }
+    char control[CMSG_SPACE(sizeof(int))] = {};
+    iovec iov{data, 1};
+    msghdr msg{};
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+    ssize_t n;
+    do {
+        n = ::recvmsg(fd, &msg, MSG_CMSG_CLOEXEC);
+    } while (n < 0 && errno == EINTR);
+    for (cmsghdr* cmsg = CMSG_FIRSTHDR(&msg); n > 0 && cmsg != nullptr; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+        if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS && cmsg->cmsg_len == CMSG_LEN(sizeof(int))) {
+            std::memcpy(&passedFd, CMSG_DATA(cmsg), sizeof(int));
+        }
+    }
+    if (n == 1 && (msg.msg_flags & MSG_CTRUNC) == 0 && recvAll(fd, static_cast<uint8_t*>(data) + 1, size - 1)) {
+        return true;
+    }
+    if (passedFd >= 0) {
+        close(passedFd);
+        passedFd = -1;
+    }
+    return false;
+}
+
+/**
+ * Client-owned ring of frame slots in a sealed memfd.
+ * The client creates it (create) and passes getFd() with its Hello, the server maps it read-only (open).
+ * The size is sealed before the ring is shared, so the server's mapping can never lose its pages.
+ */
+class shmRing {
+public:
+    static constexpr int REQUIRED_SEALS = F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_SEAL;
+
+    static std::shared_ptr<shmRing> create(const std::string& name, uint32_t slotCount, uint64_t slotSize) {
+        int fd = memfd_create(name.c_str(), MFD_CLOEXEC | MFD_ALLOW_SEALING);
+        if (fd < 0) {
+            return nullptr;
+        }
+        size_t size = RING_DATA_OFFSET + static_cast<size_t>(slotCount) * slotSize;
+        if (ftruncate(fd, static_cast<off_t>(size)) != 0 || fcntl(fd, F_ADD_SEALS, REQUIRED_SEALS) != 0) {
+            close(fd);
+            return nullptr;
+        }
+        void* base = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (base == MAP_FAILED) {
+            close(fd);
+            return nullptr;
+        }
+        auto* header = static_cast<RingHeader*>(base);
+        header->magic = RING_MAGIC;
+        header->version = PROTOCOL_VERSION;
+        header->slot_count = slotCount;
+        header->reserved = 0;
+        header->slot_size = slotSize;
+        auto ring = std::shared_ptr<shmRing>(new shmRing(name, base, size, fd));
+        ring->m_slotCount = slotCount;
+        ring->m_slotSize = slotSize;
+        return ring;
+    }
+
+    // Takes ownership of <fd>, a ring the client could still resize is refused
+    static std::shared_ptr<shmRing> open(const std::string& name, int fd) {
+        if (fd < 0) {
+            return nullptr;
+        }
+        int seals = fcntl(fd, F_GET_SEALS);
+        struct stat st;
+        if (seals < 0 || (seals & REQUIRED_SEALS) != REQUIRED_SEALS
+                || fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < RING_DATA_OFFSET) {
+            close(fd);
+            return nullptr;
+        }
+        size_t size = static_cast<size_t>(st.st_size);
+        void* base = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+        close(fd);
+        if (base == MAP_FAILED) {
+            return nullptr;
+        }
+        auto ring = std::shared_ptr<shmRing>(new shmRing(name, base, size, -1));
+        // the header stays writable by the client, the geometry is validated and kept once here
+        const auto* header = static_cast<const RingHeader*>(base);
+        uint32_t slotCount = header->slot_count;
+        uint64_t slotSize = header->slot_size;
+        if (header->magic != RING_MAGIC || header->version != PROTOCOL_VERSION
+                || (slotCount > 0 && slotSize > (size - RING_DATA_OFFSET) / slotCount)) {
+            return nullptr;
+        }
+        ring->m_slotCount = slotCount;
+        ring->m_slotSize = slotSize;
+        return ring;
+    }
+
+    ~shmRing() {
+        munmap(m_base, m_size);
+        if (m_fd >= 0) {
+            close(m_fd);
+        }
+    }
+
+    shmRing(const shmRing&) = delete;
+    shmRing& operator=(const shmRing&) = delete;
+
+    uint32_t getSlotCount() const { return m_slotCount; }
+    uint64_t getSlotSize() const { return m_slotSize; }
+    const std::string& getName() const { return m_name; }
+    // The memfd of a created ring, -1 for an opened one
+    int getFd() const { return m_fd; }
+
+    uint8_t* slot(uint32_t index) const {
+        return static_cast<uint8_t*>(m_base) + RING_DATA_OFFSET + static_cast<size_t>(index) * getSlotSize();
+    }
+
+private:
+    shmRing(const std::string& name, void* base, size_t size, int fd) :
+        m_name{name}, m_base{base}, m_size{size}, m_fd{fd} {}
+
+private:
+    std::string m_name;
+    void* m_base;
+    size_t m_size;
+    int m_fd;
+    uint32_t m_slotCount{0};
+    uint64_t m_slotSize{0};
+};
+
+} // namespace server_protocol
+
+} // namespace example
+
+#endif // __SERVER_PROTOCOL_HPP__
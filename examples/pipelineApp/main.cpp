@@ -0,0 +1,99 @@
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include "common/ArgParser.hpp"
+#include "algorithms/pipeline/pipelineConfig.hpp"
+#include "algorithms/pipeline/pipelineGraph.hpp"
+
+using namespace common;
+using namespace dnn_algorithm;
+
+namespace {
+
+std::atomic<bool> g_stop{false};
+
+void onSignal(int) {
+    g_stop = true;
+}
+
+void printStats(const std::vector<PipelineNodeStats>& stats, float elapsedS) {
+    std::printf("%-14s %-11s %3s %9s %8s %7s %8s %7s %6s %6s %8s\n",
+        "node", "type", "thr", "processed", "skipped", "errors", "passed", "shed", "queue", "max_q", "busy_%");
+    for (const auto& node : stats) {
+        float busy = elapsedS > 0.f ? node.busyMs / (10.f * elapsedS * static_cast<float>(node.threads)) : 0.f;
+        std::printf("%-14s %-11s %3zu %9llu %8llu %7llu %8llu %7llu %6zu %6zu %8.1f\n",
+            node.name.c_str(), node.type.c_str(), node.threads,
+            static_cast<unsigned long long>(node.processed), static_cast<unsigned long long>(node.skipped),
+            static_cast<unsigned long long>(node.errors), static_cast<unsigned long long>(node.passed),
+            static_cast<unsigned long long>(node.shed), node.queued, node.maxQueued, busy);
+    }
+    std::fflush(stdout);
+}
+
+} // namespace
+
+
+/* Runs a pipeline graph described by a config file, see pipeline.conf and README.md.
+ * Prints the per-node counters every --stats_s seconds and once the sources are exhausted.
+ */
+int main(int argc, char* argv[])
+{
+    ArgParser parser("PipelineApp");
+    parser.addOption("--config", std::string("./pipeline.conf"), "Pipeline graph config file");
+    parser.addOption("--stats_s", int(5), "Interval of the node statistics in seconds, 0 = only at the end");
+    parser.addOption("--duration_s", int(0), "Stop after this many seconds, 0 = when the sources are exhausted");
+    parser.parseArgs(argc, argv);
+
+    std::string configPath;
+    int statsS = 5;
+    int durationS = 0;
+    parser.getOptionVal("--config", configPath);
+    parser.getOptionVal("--stats_s", statsS);
+    parser.getOptionVal("--duration_s", durationS);
+
+    std::unique_ptr<pipelineGraph> graph;
+    try {
+        graph = std::make_unique<pipelineGraph>(PipelineConfig::load(configPath));
+    }
+    catch (const std::exception& e) {
+        std::cerr << "Failed to build the pipeline: " << e.what() << std::endl;
+        return -1;
+    }
+
+    std::signal(SIGINT, onSignal);
+    std::signal(SIGTERM, onSignal);
+
+    using Clock = std::chrono::steady_clock;
+    auto start = Clock::now();
+    auto nextStats = start + std::chrono::seconds(statsS);
+    graph->start();
+    while (!g_stop && !graph->isDone()) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        auto now = Clock::now();
+        if (durationS > 0 && now - start >= std::chrono::seconds(durationS)) {
+            break;
+        }
+        if (statsS > 0 && now >= nextStats) {
+            nextStats += std::chrono::seconds(statsS);
+            printStats(graph->getStats(), std::chrono::duration<float>(now - start).count());
+        }
+    }
+    if (graph->isDone()) {
+        graph->wait();
+    }
+    else {
+        graph->stop();
+    }
+    printStats(graph->getStats(), std::chrono::duration<float>(Clock::now() - start).count());
+
+    MemoryReport report;
+    graph->reportMemory(report);
+    ModelRegistry::instance().reportMemory(report);
+    std::cout << "memory footprint:\n" << report.format() << std::endl;
+    return 0;
+}
@@ -0,0 +1,203 @@
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <opencv2/opencv.hpp>
+#include "common/ArgParser.hpp"
+#include "common/Logger.hpp"
+#include "common/MemoryReport.hpp"
+#include "algorithms/object_detect/dnnObjDetector.hpp"
+#include "dnn_engines/dnnEngine_impl/mock/mockEngine.hpp"
+#include "soakMonitor.hpp"
+
+using namespace example;
+using namespace common;
+using namespace dnn_algorithm;
+
+namespace {
+
+std::atomic<bool> g_stop{false};
+
+void onSignal(int) {
+    g_stop = true;
+}
+
+// Per-frame params refresh of the applications, including the quantization vectors that must not grow
+void refreshParams(dnnObjDetector& detector, const cv::Mat& image, float confThreshold, float nmsThreshold,
+        ObjDetectParams& params) {
+    IDnnEngine::dnnInputShape shape;
+    detector.getInputShape(shape);
+    params.model_input_width = shape.width;
+    params.model_input_height = shape.height;
+    params.model_input_channel = shape.channel;
+    params.conf_threshold = confThreshold;
+    params.nms_threshold = nmsThreshold;
+    params.scale_width = static_cast<float>(shape.width) / static_cast<float>(image.cols);
+    params.scale_height = static_cast<float>(shape.height) / static_cast<float>(image.rows);
+    params.pads = bboxRect<int>{};
+    detector.getOutputQuantParams(params.quantize_zero_points, params.quantize_scales);
+}
+
+// What the components of the run hold, compared against the RSS at every sample
+MemoryReport reportMemory(const dnnObjDetector& detector, const ObjDetectResults& results) {
+    MemoryReport report;
+    detector.reportMemory(report, "detector");
+    report.add("results", results.getMemoryBytes());
+    ModelRegistry::instance().reportMemory(report, "registry");
+    return report;
+}
+
+} // namespace
+
+
+/* Runs a detector for a long time and watches the process for per-frame leaks and latency drift.
+ * Without an NPU use --dnnType mock, the model file is then a mock spec (see mockEngine.hpp); an empty
+ * --modelPath writes the default spec. Exits with 2 when a trend is flagged, so it can gate a CI job.
+ */
+int main(int argc, char* argv[])
+{
+    ArgParser parser("SoakTest");
+    parser.addOption("--dnn, --dnnType", std::string("mock"), "DNN type: rknn or mock");
+    parser.addOption("--plugin, --pluginPath", std::string(""), "Path to the plugin library");
+    parser.addOption("--label, --labelTextPath", std::string(""), "Path to the label text file");
+    parser.addOption("--model, --modelPath", std::string(""), "Path to the model file, or the mock spec");
+    parser.addOption("--image, --imagePath", std::string(""), "Input image, a synthetic 1280x720 frame if empty");
+    parser.addOption("--duration_s", int(3600), "Length of the run in seconds");
+    parser.addOption("--interval_s", int(60), "Sampling interval in seconds");
+    parser.addOption("--fps", float(0.f), "Frame rate limit, 0 = as fast as possible");
+    parser.addOption("--conf_threshold", float(0.25), "conf_threshold");
+    parser.addOption("--nms_threshold", float(0.45), "nms_threshold");
+    parser.addOption("--warmup_samples", int(2), "Samples excluded from the trend analysis");
+    parser.addOption("--drift", float(0.25), "Tolerated p95 latency increase between the first and last quarter");
+    parser.addOption("--csv", std::string(""), "Write the samples to this CSV file");
+    parser.parseArgs(argc, argv);
+
+    std::string dnnType;
+    std::string pluginPath;
+    std::string labelTextPath;
+    std::string modelPath;
+    std::string imagePath;
+    std::string csvPath;
+    int durationS = 3600;
+    int intervalS = 60;
+    int warmupSamples = 2;
+    float fps = 0.f;
+    float confThreshold = 0.25f;
+    float nmsThreshold = 0.45f;
+    float drift = 0.25f;
+    parser.getOptionVal("--dnnType", dnnType);
+    parser.getOptionVal("--pluginPath", pluginPath);
+    parser.getOptionVal("--labelTextPath", labelTextPath);
+    parser.getOptionVal("--modelPath", modelPath);
+    parser.getOptionVal("--imagePath", imagePath);
+    parser.getOptionVal("--duration_s", durationS);
+    parser.getOptionVal("--interval_s", intervalS);
+    parser.getOptionVal("--fps", fps);
+    parser.getOptionVal("--conf_threshold", confThreshold);
+    parser.getOptionVal("--nms_threshold", nmsThreshold);
+    parser.getOptionVal("--warmup_samples", warmupSamples);
+    parser.getOptionVal("--drift", drift);
+    parser.getOptionVal("--csv", csvPath);
+
+    // the mock engine is linked into the soak test only
+    dnn_engine::mockEngine::registerMock();
+    if (dnnType == "mock" && modelPath.empty()) {
+        modelPath = "/tmp/soak_mock_model.txt";
+        std::ofstream spec(modelPath);
+        spec << "input=640x640x3\nlatency_ms=15\njitter_ms=5\ndetections=5\n";
+    }
+
+    auto image = std::make_shared<cv::Mat>();
+    if (!imagePath.empty()) {
+        *image = cv::imread(imagePath, cv::IMREAD_COLOR);
+    }
+    if (image->empty()) {
+        *image = cv::Mat(720, 1280, CV_8UC3);
+        cv::randu(*image, cv::Scalar::all(0), cv::Scalar::all(255));
+    }
+
+    std::unique_ptr<dnnObjDetector> detector;
+    try {
+        detector = dnnObjDetector::create(dnnType, pluginPath, labelTextPath, modelPath);
+    }
+    catch (const std::exception& e) {
+        std::cerr << "Failed to create the detector: " << e.what() << std::endl;
+        return -1;
+    }
+
+    std::signal(SIGINT, onSignal);
+    std::signal(SIGTERM, onSignal);
+
+    SoakLimits limits;
+    limits.warmupSamples = static_cast<size_t>(std::max(0, warmupSamples));
+    limits.latencyDriftRatio = drift;
+    SoakMonitor monitor(limits);
+    ObjDetectResults results;
+    ObjDetectParams params{};
+    auto start = SoakMonitor::Clock::now();
+    auto end = start + std::chrono::seconds(durationS);
+    auto nextSample = start + std::chrono::seconds(std::max(1, intervalS));
+    auto frameInterval = fps > 0.f ? std::chrono::duration<float>(1.f / fps) : std::chrono::duration<float>(0.f);
+    auto nextFrame = start;
+
+    std::cout << "soak run of " << durationS << " s, sampling every " << intervalS << " s" << std::endl;
+    std::printf("%9s %8s %7s %8s %8s %8s %10s %10s %12s %5s %6s\n",
+        "elapsed_s", "frames", "fps", "p50_ms", "p95_ms", "p99_ms", "rss_kb", "heap_kb", "accounted_kb", "fds", "state");
+    while (!g_stop && SoakMonitor::Clock::now() < end) {
+        if (fps > 0.f) {
+            std::this_thread::sleep_until(nextFrame);
+            nextFrame += std::chrono::duration_cast<SoakMonitor::Clock::duration>(frameInterval);
+        }
+
+        auto begin = SoakMonitor::Clock::now();
+        ObjDetectInput input = {
+            .handleType = "opencv4",
+            .imageHandle = image,
+        };
+        detector->pushInputData(std::make_shared<ObjDetectInput>(input));
+        refreshParams(*detector, *image, confThreshold, nmsThreshold, params);
+        int ret = detector->runObjDetect(params);
+        detector->popResults(results);
+        float latency_ms = std::chrono::duration<float, std::milli>(SoakMonitor::Clock::now() - begin).count();
+        monitor.addFrame(latency_ms, ret == 0);
+
+        if (SoakMonitor::Clock::now() >= nextSample) {
+            nextSample += std::chrono::seconds(std::max(1, intervalS));
+            size_t state = params.quantize_zero_points.size() + params.quantize_scales.size();
+            const auto& s = monitor.sample(state, reportMemory(*detector, results).total());
+            std::printf("%9.0f %8llu %7.1f %8.2f %8.2f %8.2f %10zu %10zu %12zu %5zu %6zu\n",
+                s.elapsedS, static_cast<unsigned long long>(s.frames), s.fps, s.p50Ms, s.p95Ms, s.p99Ms,
+                s.rssBytes >> 10, s.heapBytes >> 10, s.accountedBytes >> 10, s.openFds, s.stateElements);
+            std::fflush(stdout);
+        }
+    }
+
+    MemoryReport report = reportMemory(*detector, results);
+    size_t rss = SoakMonitor::readRss();
+    std::cout << "memory footprint:\n" << report.format()
+              << "unaccounted (code, allocator, runtime caches): " << (rss > report.total() ? (rss - report.total()) >> 10 : 0)
+              << " KB of " << (rss >> 10) << " KB RSS" << std::endl;
+
+    if (!csvPath.empty() && !monitor.writeCsv(csvPath)) {
+        std::cerr << "Failed to write " << csvPath << std::endl;
+    }
+
+    auto findings = monitor.analyze();
+    if (monitor.getSamples().size() < limits.warmupSamples + limits.minSamples) {
+        std::cout << "too few samples for a verdict (" << monitor.getSamples().size() << ")" << std::endl;
+        return 0;
+    }
+    for (const auto& finding : findings) {
+        std::cout << "FLAGGED: " << finding << std::endl;
+    }
+    if (findings.empty()) {
+        std::cout << "stable: no monotonic growth or latency drift" << std::endl;
+        return 0;
+    }
+    return 2;
+}
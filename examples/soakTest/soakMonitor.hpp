@@ -0,0 +1,209 @@
+#ifndef __SOAK_MONITOR_HPP__
+#define __SOAK_MONITOR_HPP__
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <dirent.h>
+#include <malloc.h>
+#include <unistd.h>
+
+
+namespace example {
+
+// Process and pipeline state at the end of one sampling interval
+struct SoakSample {
+    float elapsedS{0.f};
+    uint64_t frames{0};         // in this interval
+    uint64_t failures{0};
+    float fps{0.f};
+    float p50Ms{0.f};
+    float p95Ms{0.f};
+    float p99Ms{0.f};
+    float maxMs{0.f};
+    size_t rssBytes{0};
+    size_t heapBytes{0};        // allocated by malloc, in use
+    size_t accountedBytes{0};   // held by the components, see common::MemoryReport
+    size_t openFds{0};
+    size_t stateElements{0};    // per-frame state of the caller that must stay constant, e.g. the params vectors
+};
+
+struct SoakLimits {
+    size_t warmupSamples{2};        // the first samples (allocator pools, caches, lazy init) are not judged
+    size_t minSamples{4};           // judged samples needed for a verdict
+    float monotonicRatio{0.8f};     // share of non-decreasing steps that makes a growth monotonic
+    float rssGrowthBytes{8 << 20};  // tolerated growth over the run before a monotonic trend is flagged
+    float heapGrowthBytes{4 << 20};
+    float fdGrowth{4};
+    float latencyDriftRatio{0.25f}; // p95 of the last quarter against the first quarter
+};
+
+/**
+ * Collects the frame latencies of a soak run and samples the process state at intervals, then looks for
+ * the signature of per-frame leaks: a value that grows over almost every interval and in total beyond noise.
+ * Latency drift compares the p95 of the first and the last quarter of the run.
+ */
+class SoakMonitor {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    explicit SoakMonitor(const SoakLimits& limits = SoakLimits{}) : m_limits{limits}, m_start{Clock::now()} {
+        m_intervalStart = m_start;
+    }
+
+    void addFrame(float latencyMs, bool ok) {
+        m_latencies.push_back(latencyMs);
+        m_failures += ok ? 0 : 1;
+    }
+
+    const SoakSample& sample(size_t stateElements, size_t accountedBytes = 0) {
+        auto now = Clock::now();
+        SoakSample sample;
+        sample.elapsedS = std::chrono::duration<float>(now - m_start).count();
+        sample.frames = m_latencies.size();
+        sample.failures = m_failures;
+        float interval_s = std::chrono::duration<float>(now - m_intervalStart).count();
+        sample.fps = interval_s > 0.f ? static_cast<float>(sample.frames) / interval_s : 0.f;
+        if (!m_latencies.empty()) {
+            std::sort(m_latencies.begin(), m_latencies.end());
+            auto percentile = [this](size_t p) { return m_latencies[(m_latencies.size() - 1) * p / 100]; };
+            sample.p50Ms = percentile(50);
+            sample.p95Ms = percentile(95);
+            sample.p99Ms = percentile(99);
+            sample.maxMs = m_latencies.back();
+        }
+        sample.rssBytes = readRss();
+        sample.heapBytes = readHeap();
+        sample.openFds = countFds();
+        sample.stateElements = stateElements;
+        sample.accountedBytes = accountedBytes;
+
+        m_samples.push_back(sample);
+        m_latencies.clear();
+        m_failures = 0;
+        m_intervalStart = now;
+        return m_samples.back();
+    }
+
+    const std::vector<SoakSample>& getSamples() const { return m_samples; }
+
+    // @return the findings, empty if the run looks stable (or is too short to tell)
+    std::vector<std::string> analyze() const {
+        std::vector<std::string> findings;
+        if (m_samples.size() < m_limits.warmupSamples + m_limits.minSamples) {
+            return findings;
+        }
+        std::vector<SoakSample> judged(m_samples.begin() + m_limits.warmupSamples, m_samples.end());
+
+        checkGrowth(judged, "RSS", [](const SoakSample& s) { return static_cast<double>(s.rssBytes); },
+            m_limits.rssGrowthBytes, findings);
+        checkGrowth(judged, "heap", [](const SoakSample& s) { return static_cast<double>(s.heapBytes); },
+            m_limits.heapGrowthBytes, findings);
+        checkGrowth(judged, "accounted memory", [](const SoakSample& s) { return static_cast<double>(s.accountedBytes); },
+            m_limits.heapGrowthBytes, findings);
+        checkGrowth(judged, "open fds", [](const SoakSample& s) { return static_cast<double>(s.openFds); },
+            m_limits.fdGrowth, findings);
+        // must not change at all
+        checkGrowth(judged, "caller state", [](const SoakSample& s) { return static_cast<double>(s.stateElements); },
+            0.f, findings);
+
+        size_t quarter = std::max<size_t>(1, judged.size() / 4);
+        double first = 0.0;
+        double last = 0.0;
+        for (size_t i = 0; i < quarter; i++) {
+            first += judged[i].p95Ms;
+            last += judged[judged.size() - 1 - i].p95Ms;
+        }
+        if (first > 0.0 && last > first * (1.0 + m_limits.latencyDriftRatio)) {
+            char text[128];
+            std::snprintf(text, sizeof(text), "p95 latency drift: %.2f ms -> %.2f ms",
+                first / quarter, last / quarter);
+            findings.emplace_back(text);
+        }
+        return findings;
+    }
+
+    bool writeCsv(const std::string& path) const {
+        std::ofstream file(path);
+        if (!file.is_open()) {
+            return false;
+        }
+        file << "elapsed_s,frames,failures,fps,p50_ms,p95_ms,p99_ms,max_ms,rss_kb,heap_kb,accounted_kb,open_fds,state_elements\n";
+        for (const auto& s : m_samples) {
+            file << s.elapsedS << ',' << s.frames << ',' << s.failures << ',' << s.fps << ',' << s.p50Ms << ','
+                 << s.p95Ms << ',' << s.p99Ms << ',' << s.maxMs << ',' << (s.rssBytes >> 10) << ','
+                 << (s.heapBytes >> 10) << ',' << (s.accountedBytes >> 10) << ',' << s.openFds << ',' << s.stateElements << '\n';
+        }
+        return file.good();
+    }
+
+    static size_t readRss() {
+        std::ifstream statm("/proc/self/statm");
+        size_t pages = 0;
+        size_t resident = 0;
+        statm >> pages >> resident;
+        return resident * static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    }
+
+    static size_t readHeap() {
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+        struct mallinfo2 info = mallinfo2();
+        return info.uordblks + info.hblkhd;
+#elif defined(__GLIBC__)
+        struct mallinfo info = mallinfo();
+        return static_cast<size_t>(static_cast<unsigned int>(info.uordblks)) + static_cast<unsigned int>(info.hblkhd);
+#else
+        return 0;
+#endif
+    }
+
+    static size_t countFds() {
+        DIR* dir = opendir("/proc/self/fd");
+        if (dir == nullptr) {
+            return 0;
+        }
+        size_t count = 0;
+        while (struct dirent* entry = readdir(dir)) {
+            count += entry->d_name[0] != '.' ? 1 : 0;
+        }
+        closedir(dir);
+        // the descriptor of the directory itself
+        return count > 0 ? count - 1 : 0;
+    }
+
+private:
+    template <typename Getter>
+    void checkGrowth(const std::vector<SoakSample>& samples, const char* name, Getter value, float tolerance,
+            std::vector<std::string>& findings) const {
+        size_t rising = 0;
+        for (size_t i = 1; i < samples.size(); i++) {
+            rising += value(samples[i]) >= value(samples[i - 1]) ? 1 : 0;
+        }
+        double growth = value(samples.back()) - value(samples.front());
+        bool monotonic = static_cast<float>(rising) >= m_limits.monotonicRatio * static_cast<float>(samples.size() - 1);
+        if (growth > tolerance && monotonic) {
+            double hours = (samples.back().elapsedS - samples.front().elapsedS) / 3600.0;
+            char text[160];
+            std::snprintf(text, sizeof(text), "%s grows monotonically: %.0f -> %.0f (%.0f per hour)",
+                name, value(samples.front()), value(samples.back()), hours > 0.0 ? growth / hours : growth);
+            findings.emplace_back(text);
+        }
+    }
+
+private:
+    SoakLimits m_limits;
+    Clock::time_point m_start;
+    Clock::time_point m_intervalStart;
+    std::vector<float> m_latencies{};
+    uint64_t m_failures{0};
+    std::vector<SoakSample> m_samples{};
+};
+
+} // namespace example
+
+
+#endif // __SOAK_MONITOR_HPP__
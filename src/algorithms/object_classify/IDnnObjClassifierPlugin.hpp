@@ -0,0 +1,62 @@
+#ifndef __IDNN_OBJCLASSIFIER_PLUGIN_HPP__
+#define __IDNN_OBJCLASSIFIER_PLUGIN_HPP__
+
+#include "dnn_engines/IDnnEngine.hpp"
+#include "algorithms/object_detect/IDnnObjDetectorPlugin.hpp"
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace dnn_algorithm {
+
+using namespace dnn_engine;
+
+struct ObjClassifyOutput {
+    int classId{-1};
+    float score{0.0};
+    std::string label{};
+};
+
+struct ObjClassifyParams {
+    size_t model_input_width;
+    size_t model_input_height;
+    size_t model_input_channel;
+    size_t model_input_batch{1};
+    float crop_expand{0.0};             // grow each detection box by this fraction of its size before cropping
+    float min_detect_score{0.0};        // detections below this score are not classified
+    bool apply_softmax{true};           // the model outputs logits
+    // quantization params
+    std::vector<int32_t> quantize_zero_points;
+    std::vector<float> quantize_scales;
+};
+
+class IDnnObjClassifierPlugin {
+public:
+    /**
+     * Fill one batched input tensor with the crops of <frame>.
+     * crops are in the pixel coordinates of the image held by <frame>, crops.size() <= params.model_input_batch.
+     */
+    virtual int preProcess(const ObjClassifyParams& params, const ObjDetectInput& frame,
+                    const std::vector<bboxRect<int>>& crops, IDnnEngine::dnnInput& outputData) = 0;
+    /**
+     * Decode the first <cropCount> batch entries of the model outputs, appending one result per crop.
+     */
+    virtual int postProcess(const std::string& labelTextPath, const ObjClassifyParams& params, size_t cropCount,
+                    std::vector<IDnnEngine::dnnOutput>& inputData, std::vector<ObjClassifyOutput>& outputData) = 0;
+
+    IDnnObjClassifierPlugin() = default; // reserved for plugin interface
+    virtual ~IDnnObjClassifierPlugin() = default;
+};
+
+} // namespace dnn_algorithm
+
+
+#define CREATE_CLASSIFIER_PLUGIN_INSTANCE(PLUGIN_CLASS) \
+    extern "C" dnn_algorithm::IDnnObjClassifierPlugin* createClassifier() { \
+        return new PLUGIN_CLASS(); \
+    } \
+    extern "C" void destroyClassifier(dnn_algorithm::IDnnObjClassifierPlugin* plugin) { \
+        delete plugin; \
+    }
+
+#endif // __IDNN_OBJCLASSIFIER_PLUGIN_HPP__
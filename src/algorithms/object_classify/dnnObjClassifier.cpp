@@ -0,0 +1,287 @@
+#include "dnnObjClassifier.hpp"
+#include "algorithms/object_detect/imageTiler.hpp"
+#include "algorithms/object_detect/outputDecode.hpp"
+#include "algorithms/object_detect/yuvLetterbox.hpp"
+#include "common/TaskScheduler.hpp"
+#include <opencv2/opencv.hpp>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <fstream>
+#include <dlfcn.h>
+
+namespace dnn_algorithm {
+
+
+dnnObjClassifier::dnnObjClassifier(const std::string& dnnType, const std::string& pluginPath, const std::string& labelTextPath):
+                                m_logger{std::make_unique<Logger>("dnnObjClassifier")},
+                                m_dnnType{dnnType},
+                                m_labelTextPath{labelTextPath} {
+
+    // The plugin is optional, the default pre/post-processing handles plain classification models
+    if (pluginPath.empty()) {
+        return;
+    }
+
+    m_pluginLibraryHandle = std::shared_ptr<void>(dlopen(pluginPath.c_str(), RTLD_LAZY), dlclose);
+    if (m_pluginLibraryHandle == nullptr) {
+        m_logger->printStdoutLog(Logger::LogLevel::Error, "Failed to open plugin library: {}", dlerror());
+        throw std::runtime_error(dlerror());
+    }
+
+    auto create = reinterpret_cast<IDnnObjClassifierPlugin* (*)()>(dlsym(m_pluginLibraryHandle.get(), "createClassifier"));
+    if (create == nullptr) {
+        m_logger->printStdoutLog(Logger::LogLevel::Error, "Failed to load symbol createClassifier: {}", dlerror());
+        throw std::runtime_error(dlerror());
+    }
+
+    m_dnnPluginHandle.reset(create());
+    if (m_dnnPluginHandle == nullptr) {
+        m_logger->printStdoutLog(Logger::LogLevel::Error, "Failed to create plugin instance.");
+        throw std::runtime_error("Failed to create plugin instance.");
+    }
+}
+
+dnnObjClassifier::~dnnObjClassifier() {
+    // The plugin instance must be destroyed before its library is unloaded
+    m_dnnPluginHandle.reset();
+    m_pluginLibraryHandle.reset();
+}
+
+void dnnObjClassifier::loadModel(const std::string& modelPath) {
+    // Shared with the other users of the model, the engine gets its own context
+    m_dnnEngine = ModelRegistry::instance().acquire(m_dnnType, modelPath);
+}
+
+void dnnObjClassifier::reportMemory(MemoryReport& report, const std::string& prefix) const {
+    if (m_dnnEngine != nullptr) {
+        m_dnnEngine->reportMemory(report, prefix + ".model");
+    }
+    report.add(prefix + ".session.input", m_inputTensor.buf.capacity());
+}
+
+int dnnObjClassifier::initLabelMap() {
+    if (m_labelMapInited || m_labelTextPath.empty()) {
+        return 0;
+    }
+
+    std::ifstream labelFile(m_labelTextPath);
+    if (!labelFile.is_open()) {
+        m_logger->printStdoutLog(Logger::LogLevel::Error, "Failed to open label map file: {}", m_labelTextPath);
+        return -1;
+    }
+
+    std::string line;
+    while (std::getline(labelFile, line)) {
+        m_labelMap.push_back(line);
+    }
+    m_labelMapInited = true;
+    return 0;
+}
+
+int dnnObjClassifier::defaultPreProcess(const ObjClassifyParams& params, const ObjDetectInput& frame,
+        const std::vector<bboxRect<int>>& crops, IDnnEngine::dnnInput& outputData) {
+    const int width = static_cast<int>(params.model_input_width);
+    const int height = static_cast<int>(params.model_input_height);
+    const size_t entry_size = static_cast<size_t>(width) * height * 3;
+
+    outputData.index = 0;
+    outputData.shape.width = params.model_input_width;
+    outputData.shape.height = params.model_input_height;
+    outputData.shape.channel = params.model_input_channel;
+    outputData.shape.batch = params.model_input_batch;
+    outputData.size = entry_size * params.model_input_batch;
+    if (outputData.buf.size() != outputData.size) {
+        outputData.buf.resize(outputData.size);
+    }
+    outputData.dataType = "UINT8";
+
+    yuv_letterbox::YuvFormat yuv_format;
+    bool is_yuv = yuv_letterbox::parseYuvFormat(frame.handleType, yuv_format);
+    // The crops are independent, each one writes its own batch entry
+    std::atomic<bool> failed{false};
+    common::TaskScheduler::instance().parallelFor(crops.size(), [&](size_t i) {
+        uint8_t* entry = outputData.buf.data() + i * entry_size;
+        ObjDetectInput crop_input;
+        bboxRect<int> crop_rect;
+        if (!imageTiler::makeTileInput(frame, crops[i], crop_input, crop_rect)) {
+            failed = true;
+            return;
+        }
+
+        if (is_yuv) {
+            // Colour conversion and resize in one pass, the crop is stretched to the model input
+            const auto& yuv_crop = std::any_cast<const YuvImageHandle&>(crop_input.imageHandle);
+            if (yuv_letterbox::convertToLetterboxRgb(yuv_crop, yuv_format, entry, width, height, width, height, 0, 0) != 0) {
+                failed = true;
+            }
+        }
+        else {
+            // Resize the crop straight into the batch entry, then swap to RGB in place
+            auto crop_image = std::any_cast<std::shared_ptr<cv::Mat>>(crop_input.imageHandle);
+            cv::Mat entry_image(height, width, CV_8UC3, entry);
+            cv::resize(*crop_image, entry_image, entry_image.size());
+            cv::cvtColor(entry_image, entry_image, cv::COLOR_BGR2RGB);
+        }
+    });
+    if (failed) {
+        return -1;
+    }
+    return 0;
+}
+
+int dnnObjClassifier::defaultPostProcess(const ObjClassifyParams& params, size_t cropCount,
+        std::vector<IDnnEngine::dnnOutput>& inputData, std::vector<ObjClassifyOutput>& outputData) {
+    if (inputData.empty() || inputData[0].buf == nullptr) {
+        return -1;
+    }
+
+    // The element type comes from the engine, as in the detector plugins
+    const auto& output = inputData[0];
+    auto output_type = output_decode::parseOutputType(output.dataType);
+    size_t elem_size = 0;
+    switch (output_type) {
+    case output_decode::OutputType::INT8: elem_size = sizeof(int8_t); break;
+    case output_decode::OutputType::FP16: elem_size = sizeof(uint16_t); break;
+    case output_decode::OutputType::FP32: elem_size = sizeof(float); break;
+    default:
+        m_logger->printStdoutLog(Logger::LogLevel::Error, "Unsupported output dataType: {}", output.dataType);
+        return -1;
+    }
+    size_t class_num = output.size / elem_size / std::max<size_t>(1, params.model_input_batch);
+    if (class_num == 0) {
+        return -1;
+    }
+    int32_t zp = params.quantize_zero_points.empty() ? 0 : params.quantize_zero_points[0];
+    float scale = params.quantize_scales.empty() ? 1.0f : params.quantize_scales[0];
+    auto score_at = [&](size_t idx) {
+        switch (output_type) {
+        case output_decode::OutputType::INT8:
+            return (static_cast<float>(static_cast<const int8_t*>(output.buf)[idx]) - zp) * scale;
+        case output_decode::OutputType::FP16:
+            return output_decode::fp16ToFp32(static_cast<const uint16_t*>(output.buf)[idx]);
+        default:
+            return static_cast<const float*>(output.buf)[idx];
+        }
+    };
+
+    std::vector<float> scores(class_num);
+    for (size_t b = 0; b < cropCount; b++) {
+        for (size_t k = 0; k < class_num; k++) {
+            scores[k] = score_at(b * class_num + k);
+        }
+
+        auto max_it = std::max_element(scores.begin(), scores.end());
+        ObjClassifyOutput result;
+        result.classId = static_cast<int>(std::distance(scores.begin(), max_it));
+        result.score = *max_it;
+        if (params.apply_softmax) {
+            float sum = 0.f;
+            for (auto score : scores) {
+                sum += std::exp(score - *max_it);
+            }
+            result.score = 1.0f / sum;
+        }
+        if (result.classId < static_cast<int>(m_labelMap.size())) {
+            result.label = m_labelMap[result.classId];
+        }
+        outputData.push_back(result);
+    }
+    return 0;
+}
+
+int dnnObjClassifier::runCascade(const ObjClassifyParams& params, const ObjDetectInput& frame,
+        const std::vector<ObjDetectOutput>& detections, std::vector<ObjClassifyOutput>& outputData) {
+    outputData.assign(detections.size(), ObjClassifyOutput{});
+    if (detections.empty()) {
+        return 0;
+    }
+
+    size_t frame_width = 0;
+    size_t frame_height = 0;
+    if (!imageTiler::getFrameSize(frame, frame_width, frame_height)) {
+        m_logger->printStdoutLog(Logger::LogLevel::Error, "Unsupported frame handleType: {}", frame.handleType);
+        return -1;
+    }
+
+    if (m_dnnPluginHandle == nullptr && initLabelMap() != 0) {
+        return -1;
+    }
+
+    // Crop rectangles in the pixels of the (possibly reduced) decoded frame
+    const int width = static_cast<int>(frame_width);
+    const int height = static_cast<int>(frame_height);
+    if (width < 2 || height < 2) {
+        return 0;
+    }
+    int downscale = std::max(1, frame.decodeDownscale);
+    std::vector<size_t> det_indices;
+    std::vector<bboxRect<int>> crops;
+    for (size_t i = 0; i < detections.size(); i++) {
+        const auto& det = detections[i];
+        if (det.score < params.min_detect_score) {
+            continue;
+        }
+        float expand_w = (det.bbox.right - det.bbox.left) * params.crop_expand / 2.0f;
+        float expand_h = (det.bbox.bottom - det.bbox.top) * params.crop_expand / 2.0f;
+        float left = (det.bbox.left - expand_w) / downscale;
+        float top = (det.bbox.top - expand_h) / downscale;
+        float right = (det.bbox.right + expand_w) / downscale;
+        float bottom = (det.bbox.bottom + expand_h) / downscale;
+        if (right <= left || bottom <= top || right <= 0.f || bottom <= 0.f || left >= width || top >= height) {
+            continue;
+        }
+        // left/top first so that [left + 2, width] is never empty, even for a box on the right or bottom edge
+        bboxRect<int> crop;
+        crop.left = static_cast<int>(std::clamp(left, 0.f, static_cast<float>(width - 2))) & ~1;
+        crop.top = static_cast<int>(std::clamp(top, 0.f, static_cast<float>(height - 2))) & ~1;
+        crop.right = std::max(static_cast<int>(std::min(right, static_cast<float>(width))), crop.left + 2);
+        crop.bottom = std::max(static_cast<int>(std::min(bottom, static_cast<float>(height))), crop.top + 2);
+        det_indices.push_back(i);
+        crops.push_back(crop);
+    }
+
+    const size_t batch = std::max<size_t>(1, params.model_input_batch);
+    std::vector<ObjClassifyOutput> batch_results;
+    for (size_t begin = 0; begin < crops.size(); begin += batch) {
+        size_t end = std::min(crops.size(), begin + batch);
+        std::vector<bboxRect<int>> batch_crops(crops.begin() + begin, crops.begin() + end);
+
+        int ret = m_dnnPluginHandle != nullptr
+                ? m_dnnPluginHandle->preProcess(params, frame, batch_crops, m_inputTensor)
+                : defaultPreProcess(params, frame, batch_crops, m_inputTensor);
+        if (ret != 0) {
+            return ret;
+        }
+
+        // the output buffers still hold the previous batch when a step fails
+        ret = m_dnnEngine->pushInputData(m_inputTensor);
+        if (ret == 0) {
+            ret = m_dnnEngine->runInference();
+        }
+        std::vector<IDnnEngine::dnnOutput> dnn_output_vector{};
+        if (ret == 0) {
+            ret = m_dnnEngine->popOutputData(dnn_output_vector);
+        }
+        if (ret != 0) {
+            m_logger->printStdoutLog(Logger::LogLevel::Error, "Classifier inference failed: {}", ret);
+            return ret;
+        }
+
+        batch_results.clear();
+        ret = m_dnnPluginHandle != nullptr
+                ? m_dnnPluginHandle->postProcess(m_labelTextPath, params, batch_crops.size(), dnn_output_vector, batch_results)
+                : defaultPostProcess(params, batch_crops.size(), dnn_output_vector, batch_results);
+        if (ret != 0) {
+            return ret;
+        }
+
+        for (size_t i = 0; i < batch_results.size() && begin + i < end; i++) {
+            outputData[det_indices[begin + i]] = std::move(batch_results[i]);
+        }
+    }
+    return 0;
+}
+
+
+} // namespace dnn_algorithm
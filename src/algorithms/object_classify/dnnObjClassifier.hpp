@@ -0,0 +1,80 @@
+#ifndef __DNN_OBJCLASSIFIER_HPP__
+#define __DNN_OBJCLASSIFIER_HPP__
+
+#include "IDnnObjClassifierPlugin.hpp"
+#include "dnn_engines/IDnnEngine.hpp"
+#include "dnn_engines/ModelRegistry.hpp"
+#include "common/Logger.hpp"
+#include "common/MemoryReport.hpp"
+#include <memory>
+#include <string>
+#include <vector>
+
+
+namespace dnn_algorithm {
+
+using namespace common;
+using namespace dnn_engine;
+
+/**
+ * @brief Detector -> classifier cascade.
+ *
+ * Classifies the boxes of an object detector with a second model. The crops are resized straight
+ * from the source frame into a batched input tensor, so all boxes of a frame go through
+ * ceil(boxes / model batch) inferences without intermediate cv::Mat copies.
+ * Without a plugin, crops are stretched to the packed RGB model input and the outputs are
+ * decoded as one score vector per batch entry (argmax, optional softmax).
+ */
+class dnnObjClassifier {
+public:
+    dnnObjClassifier(const std::string& dnnType, const std::string& pluginPath, const std::string& labelTextPath);
+
+    virtual ~dnnObjClassifier();
+
+    void loadModel(const std::string& modelPath);
+
+    int getInputShape(IDnnEngine::dnnInputShape& shape) {
+        return m_dnnEngine->getInputShape(shape);
+    }
+
+    int getOutputQuantParams(std::vector<int32_t>& zeroPoints, std::vector<float>& scales) {
+        return m_dnnEngine->getOutputQuantParams(zeroPoints, scales);
+    }
+
+    /**
+     * @brief Classify the detections of one frame.
+     * @param params Classifier parameters.
+     * @param frame The frame the detections come from.
+     * @param detections Detections in original image coordinates.
+     * @param[out] outputData One result per detection, classId -1 for skipped detections.
+     */
+    int runCascade(const ObjClassifyParams& params, const ObjDetectInput& frame,
+            const std::vector<ObjDetectOutput>& detections, std::vector<ObjClassifyOutput>& outputData);
+
+    // The engine breakdown as <prefix>.model, the batched crop tensor as <prefix>.session.input
+    void reportMemory(MemoryReport& report, const std::string& prefix = "classifier") const;
+
+private:
+    int defaultPreProcess(const ObjClassifyParams& params, const ObjDetectInput& frame,
+            const std::vector<bboxRect<int>>& crops, IDnnEngine::dnnInput& outputData);
+    int defaultPostProcess(const ObjClassifyParams& params, size_t cropCount,
+            std::vector<IDnnEngine::dnnOutput>& inputData, std::vector<ObjClassifyOutput>& outputData);
+    int initLabelMap();
+
+private:
+    std::unique_ptr<Logger> m_logger{nullptr};
+    std::string m_dnnType;
+    std::shared_ptr<IDnnEngine> m_dnnEngine{nullptr};
+    std::shared_ptr<void> m_pluginLibraryHandle{nullptr};
+    std::shared_ptr<IDnnObjClassifierPlugin> m_dnnPluginHandle{nullptr};
+    std::string m_labelTextPath;
+    std::vector<std::string> m_labelMap;
+    bool m_labelMapInited{false};
+    IDnnEngine::dnnInput m_inputTensor{};
+};
+
+
+} // namespace dnn_algorithm
+
+
+#endif // __DNN_OBJCLASSIFIER_HPP__
@@ -11,9 +11,28 @@ namespace dnn_algorithm {
 
 using namespace dnn_engine;
 
+class ObjDetectResults;
+
+// Raw camera frame, used as imageHandle with handleType "nv12", "nv21" or "yuyv".
+// The plane pointers are borrowed from the capture buffer: they must stay valid until
+// runObjDetect() returns, unless <owner> keeps the buffer alive.
+struct YuvImageHandle {
+    size_t width{0};
+    size_t height{0};
+    // NV12/NV21: planes[0] is Y, planes[1] is the interleaved UV (NV12) or VU (NV21) plane.
+    // YUYV: planes[0] is the packed Y0 U Y1 V plane, planes[1] is unused.
+    const uint8_t* planes[2]{nullptr, nullptr};
+    size_t strides[2]{0, 0}; // bytes per row of each plane
+    std::shared_ptr<void> owner{nullptr};
+};
+
 struct ObjDetectInput {
+    // handleType can be "opencv4" (std::shared_ptr<cv::Mat>, BGR), "nv12", "nv21", "yuyv" (YuvImageHandle)
     std::string handleType{"opencv4"};
     std::any imageHandle;
+    // The image handle was decoded at 1/decodeDownscale of the original resolution
+    // (DCT-scaled JPEG decode), ObjDetectParams still refer to the original image size.
+    int decodeDownscale{1};
 };
 
 template <typename T>
@@ -30,6 +49,10 @@ struct ObjDetectOutput {
     bboxRect<int> bbox{};
     float score{0.0};
     std::string label{};
+    // index of the label in the model's label file, -1 if the plugin does not report it
+    int classId{-1};
+    // set by the object tracker, -1 for untracked detections
+    int trackId{-1};
 };
 
 struct ObjDetectParams {
@@ -46,11 +69,27 @@ struct ObjDetectParams {
     std::vector<float> quantize_scales;
 };
 
+// Model information handed to the plugin once the model is loaded
+struct ObjDetectModelDesc {
+    std::string modelPath{};
+    IDnnEngine::dnnInputShape inputShape{};
+    std::vector<IDnnEngine::dnnOutputDesc> outputs{};
+};
+
 class IDnnObjDetectorPlugin {
 public:
+    // Called after the model is loaded, plugins that adapt to the model layout configure themselves here
+    virtual int configure(const ObjDetectModelDesc& /*modelDesc*/) { return 0; }
+    // Parse the label file ahead of the first postProcess, which otherwise loads it lazily
+    virtual int loadLabels(const std::string& /*labelTextPath*/) { return 0; }
     virtual int preProcess(ObjDetectParams& params, ObjDetectInput& inputData, IDnnEngine::dnnInput& outputData) = 0;
     virtual int postProcess(const std::string& labelTextPath, const ObjDetectParams& params,
                     std::vector<IDnnEngine::dnnOutput>& inputData, std::vector<ObjDetectOutput>& outputData) = 0;
+    // Columnar postProcess: float boxes in original image coordinates and class ids, no label strings;
+    // the labels resolve through the LabelTable of the model. Only called when supportsResults() is true.
+    virtual bool supportsResults() const { return false; }
+    virtual int postProcessResults(const ObjDetectParams& /*params*/, std::vector<IDnnEngine::dnnOutput>& /*inputData*/,
+                    ObjDetectResults& /*outputData*/) { return -1; }
     
     IDnnObjDetectorPlugin() = default; // reserved for plugin interface
     virtual ~IDnnObjDetectorPlugin() = default;
@@ -0,0 +1,74 @@
+#ifndef __BBOX_UTILS_HPP__
+#define __BBOX_UTILS_HPP__
+
+#include "IDnnObjDetectorPlugin.hpp"
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <vector>
+
+namespace dnn_algorithm {
+
+namespace bbox_utils {
+
+// Intersection over union, bbox edges are inclusive pixel coordinates
+template <typename T>
+inline float calculateOverlap(const bboxRect<T>& bbox1, const bboxRect<T>& bbox2) {
+    float w = fmax(0.f, fmin(bbox1.right, bbox2.right) - fmax(bbox1.left, bbox2.left) + 1.0);
+    float h = fmax(0.f, fmin(bbox1.bottom, bbox2.bottom) - fmax(bbox1.top, bbox2.top) + 1.0);
+    float i = w * h;
+    float u = (bbox1.right - bbox1.left + 1.0) * (bbox1.bottom - bbox1.top + 1.0)
+            + (bbox2.right - bbox2.left + 1.0) * (bbox2.bottom - bbox2.top + 1.0) - i;
+
+    return u <= 0.f ? 0.f : (i / u);
+}
+
+// Intersection over the area of the smaller box, 1.0 when one box contains the other
+template <typename T>
+inline float calculateOverlapOfSmaller(const bboxRect<T>& bbox1, const bboxRect<T>& bbox2) {
+    float w = fmax(0.f, fmin(bbox1.right, bbox2.right) - fmax(bbox1.left, bbox2.left) + 1.0);
+    float h = fmax(0.f, fmin(bbox1.bottom, bbox2.bottom) - fmax(bbox1.top, bbox2.top) + 1.0);
+    float a1 = (bbox1.right - bbox1.left + 1.0) * (bbox1.bottom - bbox1.top + 1.0);
+    float a2 = (bbox2.right - bbox2.left + 1.0) * (bbox2.bottom - bbox2.top + 1.0);
+    float smaller = fmin(a1, a2);
+    return smaller <= 0.f ? 0.f : (w * h / smaller);
+}
+
+/**
+ * Class-aware greedy suppression of duplicated detections, highest score first.
+ * Uses the overlap of the smaller box so that a box truncated by a tile border
+ * is merged into the complete box of the neighbouring tile.
+ */
+inline void mergeDuplicates(std::vector<ObjDetectOutput>& detections, float threshold) {
+    std::vector<size_t> order(detections.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&detections](size_t a, size_t b) {
+        return detections[a].score > detections[b].score;
+    });
+
+    std::vector<bool> suppressed(detections.size(), false);
+    std::vector<ObjDetectOutput> merged;
+    for (size_t i = 0; i < order.size(); i++) {
+        size_t n = order[i];
+        if (suppressed[n]) {
+            continue;
+        }
+        for (size_t j = i + 1; j < order.size(); j++) {
+            size_t m = order[j];
+            if (suppressed[m] || detections[m].label != detections[n].label) {
+                continue;
+            }
+            if (calculateOverlapOfSmaller(detections[n].bbox, detections[m].bbox) > threshold) {
+                suppressed[m] = true;
+            }
+        }
+        merged.push_back(std::move(detections[n]));
+    }
+    detections.swap(merged);
+}
+
+} // namespace bbox_utils
+
+} // namespace dnn_algorithm
+
+#endif // __BBOX_UTILS_HPP__
@@ -1,5 +1,11 @@
 #include "dnnObjDetector.hpp"
 #include "IDnnObjDetectorPlugin.hpp"
+#include "bboxUtils.hpp"
+#include "common/TaskScheduler.hpp"
+#include "common/CpuTopology.hpp"
+#include <algorithm>
+#include <chrono>
+#include <future>
 #include <dlfcn.h>
 
 namespace dnn_algorithm {
@@ -7,12 +13,8 @@ namespace dnn_algorithm {
 
 dnnObjDetector::dnnObjDetector(const std::string& dnnType, const std::string& pluginPath, const std::string& labelTextPath):
                                 m_logger{std::make_unique<Logger>("dnnObjDetector")},
-                                m_dnnEngine{IDnnEngine::create(dnnType)},
+                                m_dnnType{dnnType},
                                 m_labelTextPath{labelTextPath} {
-    if (!m_dnnEngine) {
-        m_logger->printStdoutLog(Logger::LogLevel::Error, "Failed to create DNN engine.");
-        throw std::runtime_error("Failed to create DNN engine.");
-    }
 
     if (pluginPath.empty()) {
         m_logger->printStdoutLog(Logger::LogLevel::Error, "pluginPath is empty.");
@@ -20,28 +22,33 @@ dnnObjDetector::dnnObjDetector(const std::string& dnnType, const std::string& pl
     }
 
     // Dynamically load the algorithm plugin library
-    m_pluginLibraryHandle = std::shared_ptr<void>(dlopen(pluginPath.c_str(), RTLD_LAZY), dlclose);
-
-    if (m_pluginLibraryHandle == nullptr) {
-        m_logger->printStdoutLog(Logger::LogLevel::Error, "Failed to open plugin library: {}", dlerror());
-        throw std::runtime_error(dlerror());
+    void* library = dlopen(pluginPath.c_str(), RTLD_LAZY);
+    if (library == nullptr) {
+        std::string error = dlerror();
+        m_logger->printStdoutLog(Logger::LogLevel::Error, "Failed to open plugin library: {}", error);
+        throw std::runtime_error(error);
     }
+    m_pluginLibraryHandle = std::shared_ptr<void>(library, dlclose);
+
+    m_dnnPluginHandle = createPlugin();
+}
 
+std::shared_ptr<IDnnObjDetectorPlugin> dnnObjDetector::createPlugin() {
     // Retrieve the create interface from the plugin library
     auto create = reinterpret_cast<IDnnObjDetectorPlugin* (*)()>(dlsym(m_pluginLibraryHandle.get(), "create"));
     if (create == nullptr) {
-        m_logger->printStdoutLog(Logger::LogLevel::Error, "Failed to load symbol create: {}", dlerror());
-        throw std::runtime_error(dlerror());
+        std::string error = dlerror();
+        m_logger->printStdoutLog(Logger::LogLevel::Error, "Failed to load symbol create: {}", error);
+        throw std::runtime_error(error);
     }
 
     // Call the create interface to obtain the algorithm object from the plugin library
-    m_dnnPluginHandle.reset(create());
-
-    if (m_dnnPluginHandle == nullptr) {
+    std::shared_ptr<IDnnObjDetectorPlugin> plugin(create());
+    if (plugin == nullptr) {
         m_logger->printStdoutLog(Logger::LogLevel::Error, "Failed to create plugin instance.");
         throw std::runtime_error("Failed to create plugin instance.");
     }
-
+    return plugin;
 }
 
 
@@ -59,14 +66,369 @@ dnnObjDetector::~dnnObjDetector() {
         m_dnnPluginHandle.reset();
     }
 
-    if (m_pluginLibraryHandle != nullptr) {
-        dlclose(m_pluginLibraryHandle.get());
-        m_pluginLibraryHandle.reset();
+    // The library is closed by the last slot holding it, a retired slot may still be draining
+    m_activeSlot.reset();
+    m_standbySlot.reset();
+    m_pluginLibraryHandle.reset();
+}
+
+namespace {
+
+using StartupClock = std::chrono::steady_clock;
+
+float elapsedMs(StartupClock::time_point begin) {
+    return std::chrono::duration<float, std::milli>(StartupClock::now() - begin).count();
+}
+
+} // namespace
+
+std::unique_ptr<dnnObjDetector> dnnObjDetector::create(const std::string& dnnType, const std::string& pluginPath,
+        const std::string& labelTextPath, const std::string& modelPath, int warmupRuns) {
+    auto start = StartupClock::now();
+    auto& scheduler = common::TaskScheduler::instance();
+
+    // The model I/O and the runtime init run on the pool, the plugin and the labels on this thread
+    float model_load_ms = 0.f;
+    auto engine_ready = scheduler.submit([&dnnType, &modelPath, &model_load_ms]() {
+        auto begin = StartupClock::now();
+        auto engine = ModelRegistry::instance().acquire(dnnType, modelPath);
+        model_load_ms = elapsedMs(begin);
+        return engine;
+    });
+
+    std::unique_ptr<dnnObjDetector> detector;
+    float plugin_load_ms = 0.f;
+    float label_load_ms = 0.f;
+    try {
+        auto begin = StartupClock::now();
+        detector = std::make_unique<dnnObjDetector>(dnnType, pluginPath, labelTextPath);
+        plugin_load_ms = elapsedMs(begin);
+        begin = StartupClock::now();
+        detector->loadLabels();
+        label_load_ms = elapsedMs(begin);
+    }
+    catch (...) {
+        // the task refers to this frame, it has to finish before unwinding
+        try {
+            scheduler.wait(engine_ready);
+        }
+        catch (const std::exception&) {
+        }
+        throw;
+    }
+
+    std::shared_ptr<IDnnEngine> engine = scheduler.wait(engine_ready);
+    auto& stats = detector->m_startupStats;
+    stats.pluginLoadMs = plugin_load_ms;
+    stats.labelLoadMs = label_load_ms;
+    stats.modelLoadMs = model_load_ms;
+    engine->getLoadStats(stats.engineLoad);
+
+    auto begin = StartupClock::now();
+    detector->attachEngine(engine, modelPath);
+    stats.configureMs = elapsedMs(begin);
+
+    begin = StartupClock::now();
+    if (detector->warmup(warmupRuns) != 0) {
+        throw std::runtime_error("Warmup inference failed.");
     }
+    stats.warmupMs = elapsedMs(begin);
+    stats.warmupRuns = warmupRuns;
+    stats.totalMs = elapsedMs(start);
+
+    detector->m_logger->printStdoutLog(Logger::LogLevel::Info,
+        "ready in {:.1f} ms: plugin {:.1f} ms, labels {:.1f} ms, model {:.1f} ms (read {:.1f}, init {:.1f}, query {:.1f}), "
+        "configure {:.1f} ms, {} warmup runs {:.1f} ms", stats.totalMs, stats.pluginLoadMs, stats.labelLoadMs,
+        stats.modelLoadMs, stats.engineLoad.readMs, stats.engineLoad.initMs, stats.engineLoad.queryMs,
+        stats.configureMs, stats.warmupRuns, stats.warmupMs);
+    return detector;
 }
 
 void dnnObjDetector::loadModel(const std::string& modelPath) {
-    m_dnnEngine->loadModel(modelPath);
+    auto start = StartupClock::now();
+    // Shared with the other users of the model, the engine gets its own context
+    attachEngine(ModelRegistry::instance().acquire(m_dnnType, modelPath), modelPath);
+    m_startupStats.modelLoadMs = elapsedMs(start);
+    m_dnnEngine->getLoadStats(m_startupStats.engineLoad);
+
+    auto begin = StartupClock::now();
+    loadLabels();
+    m_startupStats.labelLoadMs = elapsedMs(begin);
+}
+
+std::shared_ptr<dnnObjDetector::modelSlot> dnnObjDetector::makeSlot(std::shared_ptr<IDnnObjDetectorPlugin> plugin,
+        std::shared_ptr<IDnnEngine> engine, const std::string& modelPath) {
+    auto slot = std::make_shared<modelSlot>();
+    slot->library = m_pluginLibraryHandle;
+    slot->modelPath = modelPath;
+    if (!m_labelTextPath.empty()) {
+        slot->labelTable = LabelTable::fromFile(m_labelTextPath);
+    }
+    engine->getInputShape(slot->inputShape);
+    engine->getOutputQuantParams(slot->zeroPoints, slot->scales);
+    if (plugin != nullptr) {
+        ObjDetectModelDesc model_desc;
+        model_desc.modelPath = modelPath;
+        model_desc.inputShape = slot->inputShape;
+        engine->getOutputDescs(model_desc.outputs);
+        if (plugin->configure(model_desc) != 0) {
+            m_logger->printStdoutLog(Logger::LogLevel::Error, "The plugin does not support the model: {}", modelPath);
+            throw std::runtime_error("The plugin does not support the model.");
+        }
+    }
+    slot->plugin = std::move(plugin);
+    slot->engine = std::move(engine);
+    return slot;
+}
+
+void dnnObjDetector::attachEngine(std::shared_ptr<IDnnEngine> engine, const std::string& modelPath) {
+    auto slot = makeSlot(m_dnnPluginHandle, std::move(engine), modelPath);
+    m_dnnEngine = slot->engine;
+    std::lock_guard<std::mutex> lock(m_slotMutex);
+    m_activeSlot = std::move(slot);
+}
+
+std::string dnnObjDetector::getModelPath() const {
+    std::lock_guard<std::mutex> lock(m_slotMutex);
+    return m_activeSlot != nullptr ? m_activeSlot->modelPath : std::string{};
+}
+
+// A complete slot with its own plugin instance, loaded on the calling thread
+std::shared_ptr<dnnObjDetector::modelSlot> dnnObjDetector::loadSlot(const std::string& modelPath, int warmupRuns) {
+    auto engine = ModelRegistry::instance().acquire(m_dnnType, modelPath);
+    std::shared_ptr<IDnnObjDetectorPlugin> plugin = m_pluginLibraryHandle != nullptr ? createPlugin() : nullptr;
+    if (plugin != nullptr && !m_labelTextPath.empty() && plugin->loadLabels(m_labelTextPath) != 0) {
+        m_logger->printStdoutLog(Logger::LogLevel::Error, "Failed to load the labels: {}", m_labelTextPath);
+    }
+    auto slot = makeSlot(std::move(plugin), std::move(engine), modelPath);
+    if (warmupEngine(*slot->engine, warmupRuns) != 0) {
+        throw std::runtime_error("Warmup inference failed.");
+    }
+    return slot;
+}
+
+void dnnObjDetector::loadStandbyModel(const std::string& modelPath, int warmupRuns) {
+    auto slot = loadSlot(modelPath, warmupRuns);
+
+    std::shared_ptr<modelSlot> replaced;
+    std::lock_guard<std::mutex> lock(m_slotMutex);
+    replaced = std::move(m_standbySlot);
+    m_standbySlot = std::move(slot);
+    m_standbyReady = true;
+    m_logger->printStdoutLog(Logger::LogLevel::Info, "standby model ready: {}", modelPath);
+}
+
+std::shared_future<void> dnnObjDetector::loadStandbyModelAsync(const std::string& modelPath, int warmupRuns) {
+    // Low: only pool workers pick it up, threads waiting on the frame path never run it inline
+    return common::TaskScheduler::instance().submit([this, modelPath, warmupRuns]() {
+        loadStandbyModel(modelPath, warmupRuns);
+    }, common::TaskScheduler::Priority::Low).share();
+}
+
+int dnnObjDetector::addModelVariant(const std::string& modelPath, int warmupRuns) {
+    auto slot = loadSlot(modelPath, warmupRuns);
+
+    std::lock_guard<std::mutex> lock(m_slotMutex);
+    if (m_variants.empty() && m_activeSlot != nullptr) {
+        m_variants.push_back(m_activeSlot);
+    }
+    m_variants.push_back(std::move(slot));
+    int index = static_cast<int>(m_variants.size()) - 1;
+    m_logger->printStdoutLog(Logger::LogLevel::Info, "model variant {}: {} ({}x{})", index, modelPath,
+        m_variants.back()->inputShape.width, m_variants.back()->inputShape.height);
+    return index;
+}
+
+size_t dnnObjDetector::getVariantCount() const {
+    std::lock_guard<std::mutex> lock(m_slotMutex);
+    return m_variants.size();
+}
+
+int dnnObjDetector::variantOf(const std::shared_ptr<modelSlot>& slot) const {
+    auto it = std::find(m_variants.begin(), m_variants.end(), slot);
+    return it != m_variants.end() ? static_cast<int>(it - m_variants.begin()) : -1;
+}
+
+int dnnObjDetector::getActiveVariant() const {
+    std::lock_guard<std::mutex> lock(m_slotMutex);
+    return variantOf(m_activeSlot);
+}
+
+int dnnObjDetector::selectVariant(int index) {
+    std::lock_guard<std::mutex> lock(m_slotMutex);
+    if (index < 0 || static_cast<size_t>(index) >= m_variants.size()) {
+        return -1;
+    }
+    // a new model version loaded with loadStandbyModel takes precedence
+    if (m_standbySlot != nullptr && variantOf(m_standbySlot) < 0) {
+        return -1;
+    }
+    if (m_variants[index] == m_activeSlot) {
+        m_standbySlot.reset();
+        m_standbyReady = false;
+        return 0;
+    }
+    m_standbySlot = m_variants[index];
+    m_standbyReady = true;
+    return 0;
+}
+
+void dnnObjDetector::enableQualityControl(const QualityControlParams& qualityParams) {
+    m_qualityController = std::make_unique<qualityController>(qualityParams);
+}
+
+void dnnObjDetector::disableQualityControl() {
+    m_qualityController.reset();
+}
+
+bool dnnObjDetector::getQualityStats(QualityControlStats& stats) const {
+    if (m_qualityController == nullptr) {
+        return false;
+    }
+    stats = m_qualityController->getStats();
+    return true;
+}
+
+void dnnObjDetector::reportMemory(MemoryReport& report, const std::string& prefix) const {
+    std::vector<std::pair<std::string, std::shared_ptr<modelSlot>>> slots;
+    {
+        std::lock_guard<std::mutex> lock(m_slotMutex);
+        auto addSlot = [&slots](const std::string& name, const std::shared_ptr<modelSlot>& slot) {
+            bool listed = std::any_of(slots.begin(), slots.end(), [&slot](const auto& item) { return item.second == slot; });
+            if (slot != nullptr && !listed) {
+                slots.emplace_back(name, slot);
+            }
+        };
+        addSlot("active", m_activeSlot);
+        addSlot("standby", m_standbySlot);
+        for (size_t i = 0; i < m_variants.size(); i++) {
+            addSlot("variant" + std::to_string(i), m_variants[i]);
+        }
+    }
+    for (const auto& [name, slot] : slots) {
+        slot->engine->reportMemory(report, prefix + "." + name);
+        if (slot->labelTable != nullptr) {
+            report.add(prefix + "." + name + ".labels", slot->labelTable->getMemoryBytes());
+        }
+    }
+
+    if (m_dataInput != nullptr) {
+        report.add(prefix + ".session.input", imageTiler::getFrameBytes(*m_dataInput));
+    }
+    report.add(prefix + ".session.outputs", m_dataOutputVector.capacity() * sizeof(ObjDetectOutput)
+            + m_results.getMemoryBytes() + m_trackInput.getMemoryBytes());
+    if (m_nativeConverter != nullptr) {
+        report.add(prefix + ".session.native_input", m_nativeConverter->getMemoryBytes());
+    }
+}
+
+void dnnObjDetector::adaptQuality(float processMs) {
+    int active = -1;
+    int count = 0;
+    {
+        std::lock_guard<std::mutex> lock(m_slotMutex);
+        active = variantOf(m_activeSlot);
+        count = static_cast<int>(m_variants.size());
+    }
+    if (active < 0 || count < 2) {
+        return;
+    }
+    int level = m_qualityController->update(processMs, m_queueDepth, active, count);
+    if (level != active && selectVariant(level) == 0) {
+        const auto& stats = m_qualityController->getStats();
+        m_logger->printStdoutLog(Logger::LogLevel::Info, "quality {} -> {}: p95 {:.1f} ms, {:.0f}% deadline misses, {} queued",
+            active, level, stats.p95_ms, stats.miss_rate * 100.f, stats.queue_depth);
+    }
+}
+
+// Called between frames by the thread running runObjDetect
+void dnnObjDetector::switchToStandby() {
+    if (!m_standbyReady) {
+        return;
+    }
+
+    std::shared_ptr<modelSlot> retired;
+    {
+        std::lock_guard<std::mutex> lock(m_slotMutex);
+        if (m_standbySlot == nullptr) {
+            return;
+        }
+        retired = std::move(m_activeSlot);
+        m_activeSlot = std::move(m_standbySlot);
+        m_standbyReady = false;
+    }
+    m_dnnEngine = m_activeSlot->engine;
+    m_dnnPluginHandle = m_activeSlot->plugin;
+    m_logger->printStdoutLog(Logger::LogLevel::Info, "switched to model {}", m_activeSlot->modelPath);
+
+    if (retired != nullptr) {
+        // rknn_destroy and the plugin teardown stay off the frame path: Low tasks are not run inline by waiters
+        common::TaskScheduler::instance().post([retired]() mutable {
+            if (retired->engine != nullptr) {
+                retired->engine->waitInferenceAsync();
+            }
+            retired.reset();
+        }, common::TaskScheduler::Priority::Low);
+    }
+}
+
+// The caller's params describe the model it was set up for, follow a switched model
+void dnnObjDetector::syncParams(ObjDetectParams& params) const {
+    if (m_activeSlot == nullptr) {
+        return;
+    }
+    const auto& shape = m_activeSlot->inputShape;
+    if (params.model_input_width != shape.width || params.model_input_height != shape.height) {
+        if (params.model_input_width > 0 && params.model_input_height > 0) {
+            params.scale_width *= static_cast<float>(shape.width) / static_cast<float>(params.model_input_width);
+            params.scale_height *= static_cast<float>(shape.height) / static_cast<float>(params.model_input_height);
+        }
+        params.model_input_width = shape.width;
+        params.model_input_height = shape.height;
+        params.model_input_channel = shape.channel;
+    }
+    if (params.quantize_zero_points != m_activeSlot->zeroPoints || params.quantize_scales != m_activeSlot->scales) {
+        params.quantize_zero_points = m_activeSlot->zeroPoints;
+        params.quantize_scales = m_activeSlot->scales;
+    }
+}
+
+void dnnObjDetector::loadLabels() {
+    if (m_dnnPluginHandle == nullptr || m_labelTextPath.empty()) {
+        return;
+    }
+    if (m_dnnPluginHandle->loadLabels(m_labelTextPath) != 0) {
+        m_logger->printStdoutLog(Logger::LogLevel::Error, "Failed to load the labels: {}", m_labelTextPath);
+    }
+}
+
+int dnnObjDetector::warmup(int runs) {
+    if (m_dnnEngine == nullptr) {
+        return -1;
+    }
+    return warmupEngine(*m_dnnEngine, runs);
+}
+
+int dnnObjDetector::warmupEngine(IDnnEngine& engine, int runs) {
+    IDnnEngine::dnnInput input_tensor{};
+    engine.getInputShape(input_tensor.shape);
+    input_tensor.size = input_tensor.shape.width * input_tensor.shape.height * input_tensor.shape.channel;
+    input_tensor.buf.assign(input_tensor.size, 0);
+    std::vector<IDnnEngine::dnnOutput> output_tensors{};
+    for (int i = 0; i < runs; i++) {
+        int ret = engine.pushInputData(input_tensor);
+        if (ret == 0) {
+            ret = engine.runInference();
+        }
+        if (ret == 0) {
+            ret = engine.popOutputData(output_tensors);
+        }
+        if (ret != 0) {
+            m_logger->printStdoutLog(Logger::LogLevel::Error, "Warmup inference failed: {}", ret);
+            return ret;
+        }
+    }
+    return 0;
 }
 
 void dnnObjDetector::pushInputData(std::shared_ptr<ObjDetectInput> dataInput) {
@@ -74,9 +436,45 @@ void dnnObjDetector::pushInputData(std::shared_ptr<ObjDetectInput> dataInput) {
 }
 
 std::vector<ObjDetectOutput>& dnnObjDetector::popOutputData() {
+    if (m_outputsBuilt) {
+        return m_dataOutputVector;
+    }
+    // The label strings are only copied for callers of the array-of-structs API
+    auto label_table = m_activeSlot != nullptr ? m_activeSlot->labelTable : nullptr;
+    m_dataOutputVector.clear();
+    for (size_t i = 0; i < m_results.size(); i++) {
+        ObjDetectOutput output;
+        output.bbox.left = static_cast<int>(m_results.left()[i]);
+        output.bbox.top = static_cast<int>(m_results.top()[i]);
+        output.bbox.right = static_cast<int>(m_results.right()[i]);
+        output.bbox.bottom = static_cast<int>(m_results.bottom()[i]);
+        output.score = m_results.score()[i];
+        output.classId = m_results.classId()[i];
+        output.trackId = m_results.trackId()[i];
+        auto label = label_table != nullptr ? label_table->label(output.classId) : std::string_view{};
+        output.label = label.empty() ? std::to_string(output.classId) : std::string(label);
+        m_dataOutputVector.push_back(std::move(output));
+    }
+    m_outputsBuilt = true;
     return m_dataOutputVector;
 }
 
+void dnnObjDetector::popResults(ObjDetectResults& results) {
+    results.clear();
+    results.setLabelTable(m_activeSlot != nullptr ? m_activeSlot->labelTable : nullptr);
+    if (m_columnar) {
+        results.append(m_results);
+    }
+    else {
+        results.append(m_dataOutputVector);
+    }
+}
+
+std::shared_ptr<const LabelTable> dnnObjDetector::getLabelTable() const {
+    std::lock_guard<std::mutex> lock(m_slotMutex);
+    return m_activeSlot != nullptr ? m_activeSlot->labelTable : nullptr;
+}
+
 int dnnObjDetector::defaultPreProcess(ObjDetectInput& inputData, IDnnEngine::dnnInput& outputData) {
     return 0;
 }
@@ -86,34 +484,391 @@ int dnnObjDetector::defaultPostProcess(const std::string& labelTextPath, const O
     return 0;
 }
 
+void dnnObjDetector::enableTracking(const ObjTrackParams& trackParams, int detectInterval, float minTrackConfidence) {
+    m_tracker = std::make_unique<objTracker>(trackParams);
+    m_detectInterval = std::max(1, detectInterval);
+    m_minTrackConfidence = minTrackConfidence;
+    m_framesSinceDetect = 0;
+}
+
+void dnnObjDetector::disableTracking() {
+    m_tracker.reset();
+    m_detectInterval = 1;
+}
+
+void dnnObjDetector::enableMotionGate(const MotionGateParams& gateParams) {
+    m_motionGate = std::make_unique<motionGate>(gateParams);
+}
+
+void dnnObjDetector::disableMotionGate() {
+    m_motionGate.reset();
+    m_lastFrameSkipped = false;
+}
+
+void dnnObjDetector::enableTiling(const ObjDetectTileParams& tileParams) {
+    m_tileParams = std::make_unique<ObjDetectTileParams>(tileParams);
+}
+
+void dnnObjDetector::disableTiling() {
+    m_tileParams.reset();
+}
+
+void dnnObjDetector::enableNativeInput(const NativeInputParams& inputParams) {
+    m_nativeInputParams = std::make_unique<NativeInputParams>(inputParams);
+    m_nativeConverter.reset();
+    m_nativeConverterEngine = nullptr;
+}
+
+void dnnObjDetector::disableNativeInput() {
+    m_nativeInputParams.reset();
+    m_nativeConverter.reset();
+    m_nativeConverterEngine = nullptr;
+}
+
+// (Re)build the converter when the active model changed
+void dnnObjDetector::prepareNativeInput() {
+    if (m_nativeInputParams == nullptr || m_nativeConverterEngine == m_dnnEngine.get()) {
+        return;
+    }
+    m_nativeConverterEngine = m_dnnEngine.get();
+    m_nativeConverter.reset();
+    IDnnEngine::dnnInputDesc desc;
+    if (m_dnnEngine->getInputDesc(desc) != 0) {
+        m_logger->printStdoutLog(Logger::LogLevel::Warn, "The engine has no pass-through input, native input disabled for this model.");
+        return;
+    }
+    auto converter = std::make_shared<const nativeInputConverter>(desc, *m_nativeInputParams);
+    if (!converter->isValid()) {
+        m_logger->printStdoutLog(Logger::LogLevel::Warn, "Unsupported native input {} {}, native input disabled for this model.",
+            desc.layout, desc.dataType);
+        return;
+    }
+    m_logger->printStdoutLog(Logger::LogLevel::Info, "native input: {} {}, zero point {}, scale {}, {} bytes",
+        desc.layout, desc.dataType, desc.zeroPoint, desc.scale, desc.size);
+    m_nativeConverter = std::move(converter);
+}
+
+void dnnObjDetector::toNativeInput(IDnnEngine::dnnInput& tensor) const {
+    // the pre-processing just wrote packed RGB, a reused tensor may still carry the flag of the previous frame
+    tensor.passThrough = false;
+    if (m_nativeConverter == nullptr) {
+        return;
+    }
+    // the buffers alternate between the tensor and the scratch of this thread, neither is reallocated per frame
+    thread_local std::vector<uint8_t> scratch;
+    m_nativeConverter->convert(tensor, scratch);
+}
+
+bool dnnObjDetector::isDetectFrame() const {
+    if (m_tracker == nullptr || m_framesSinceDetect == 0) {
+        return true;
+    }
+    if (m_framesSinceDetect >= m_detectInterval) {
+        return true;
+    }
+    // Re-detect early when the tracks are losing confidence
+    return m_tracker->getMinConfidence() < m_minTrackConfidence;
+}
+
 int dnnObjDetector::runObjDetect(ObjDetectParams& params) {
+    switchToStandby();
+    syncParams(params);
+
+    // Static scene: keep the previous outputs
+    m_lastFrameSkipped = m_motionGate != nullptr && m_dataInput != nullptr && !m_motionGate->checkFrame(*m_dataInput);
+    if (m_lastFrameSkipped) {
+        return 0;
+    }
+
+    if (!isDetectFrame()) {
+        if (m_columnar) {
+            m_tracker->predict(m_results);
+            m_outputsBuilt = false;
+        }
+        else {
+            m_tracker->predict(m_dataOutputVector);
+        }
+        m_framesSinceDetect++;
+        return 0;
+    }
+
+    bool columnar = useResults();
+    if (columnar != m_columnar && m_tracker != nullptr) {
+        // tracks started from columns carry no label strings, and the other way round no class ids
+        m_tracker->reset();
+    }
+    m_columnar = columnar;
+    m_outputsBuilt = !m_columnar;
+
+    auto begin = StartupClock::now();
+    int ret = runDetect(params);
+    if (ret == 0 && m_qualityController != nullptr) {
+        adaptQuality(elapsedMs(begin));
+    }
+    if (ret == 0 && m_tracker != nullptr) {
+        if (m_columnar) {
+            std::swap(m_trackInput, m_results);
+            m_tracker->update(m_trackInput, m_results);
+        }
+        else {
+            std::vector<ObjDetectOutput> detections;
+            detections.swap(m_dataOutputVector);
+            m_tracker->update(detections, m_dataOutputVector);
+        }
+        m_framesSinceDetect = 1;
+    }
+    return ret;
+}
+
+void dnnObjDetector::initParams(ObjDetectParams& params, size_t origWidth, size_t origHeight) {
+    IDnnEngine::dnnInputShape shape;
+    m_dnnEngine->getInputShape(shape);
+    params.model_input_width = shape.width;
+    params.model_input_height = shape.height;
+    params.model_input_channel = shape.channel;
+    params.scale_width = static_cast<float>(shape.width) / static_cast<float>(std::max<size_t>(1, origWidth));
+    params.scale_height = static_cast<float>(shape.height) / static_cast<float>(std::max<size_t>(1, origHeight));
+    m_dnnEngine->getOutputQuantParams(params.quantize_zero_points, params.quantize_scales);
+}
+
+int dnnObjDetector::preProcess(ObjDetectParams& params, ObjDetectInput& inputData, IDnnEngine::dnnInput& tensor) {
+    if (m_dnnPluginHandle == nullptr) {
+        m_logger->printStdoutLog(Logger::LogLevel::Error, "pluginLibraryHandle is nullptr.");
+        return -1;
+    }
+    prepareNativeInput();
+    common::CpuAffinity::ScopedStage stage(common::CpuAffinity::Stage::PreProcess);
+    int ret = m_dnnPluginHandle->preProcess(params, inputData, tensor);
+    toNativeInput(tensor);
+    return ret;
+}
+
+int dnnObjDetector::infer(IDnnEngine::dnnInput& tensor, std::vector<IDnnEngine::dnnOutput>& outputs,
+        std::vector<std::vector<uint8_t>>& storage) {
+    int ret = runEngine(tensor, outputs);
+    if (ret != 0) {
+        return ret;
+    }
+    // the engine reuses its output buffers on the next run
+    storage.resize(outputs.size());
+    for (size_t i = 0; i < outputs.size(); i++) {
+        const auto* data = static_cast<const uint8_t*>(outputs[i].buf);
+        storage[i].assign(data, data + outputs[i].size);
+        outputs[i].buf = storage[i].data();
+    }
+    return 0;
+}
+
+int dnnObjDetector::postProcess(ObjDetectParams& params, std::vector<IDnnEngine::dnnOutput>& outputs,
+        std::vector<ObjDetectOutput>& outputData) {
+    if (m_dnnPluginHandle == nullptr) {
+        m_logger->printStdoutLog(Logger::LogLevel::Error, "pluginLibraryHandle is nullptr.");
+        return -1;
+    }
+    common::CpuAffinity::ScopedStage stage(common::CpuAffinity::Stage::PostProcess);
+    return m_dnnPluginHandle->postProcess(m_labelTextPath, params, outputs, outputData);
+}
+
+int dnnObjDetector::runDetect(ObjDetectParams& params) {
+    prepareNativeInput();
+    if (m_tileParams != nullptr) {
+        return runTiledDetect(params);
+    }
+
+    if (m_columnar) {
+        m_results.clear();
+        return detectOnce(params, *m_dataInput, m_results);
+    }
+    m_dataOutputVector.clear();
+    return detectOnce(params, *m_dataInput, m_dataOutputVector);
+}
+
+// Plugins that decode into columns skip the label strings, tiling merges boxes by label and stays on the structs
+bool dnnObjDetector::useResults() const {
+    return m_tileParams == nullptr && m_dnnPluginHandle != nullptr && m_dnnPluginHandle->supportsResults();
+}
+
+int dnnObjDetector::runEngine(IDnnEngine::dnnInput& tensor, std::vector<IDnnEngine::dnnOutput>& outputs) {
+    int ret = m_dnnEngine->pushInputData(tensor);
+    if (ret == 0) {
+        ret = m_dnnEngine->runInference();
+    }
+    if (ret == 0) {
+        ret = m_dnnEngine->popOutputData(outputs);
+    }
+    if (ret != 0) {
+        m_logger->printStdoutLog(Logger::LogLevel::Error, "Inference failed: {}", ret);
+        outputs.clear();
+        return ret;
+    }
+    m_logger->printStdoutLog(Logger::LogLevel::Debug, "dnn_output_vector.size(): {}", outputs.size());
+    for (const auto& dnn_output : outputs) {
+        m_logger->printStdoutLog(Logger::LogLevel::Debug, "dnn_output.index: {}, dnn_output.size: {}, dnn_output.dataType: {}",
+                dnn_output.index, dnn_output.size, dnn_output.dataType);
+    }
+    return 0;
+}
+
+int dnnObjDetector::inferOnce(ObjDetectParams& params, ObjDetectInput& inputData, std::vector<IDnnEngine::dnnOutput>& outputs) {
+    IDnnEngine::dnnInput dnn_input_tensor{};
+    {
+        // Keep the CPU stages of the caller thread on the big cores
+        common::CpuAffinity::ScopedStage stage(common::CpuAffinity::Stage::PreProcess);
+        int ret = m_dnnPluginHandle->preProcess(params, inputData, dnn_input_tensor);
+        if (ret != 0) {
+            m_logger->printStdoutLog(Logger::LogLevel::Error, "preProcess failed: {}", ret);
+            return ret;
+        }
+        toNativeInput(dnn_input_tensor);
+    }
+    return runEngine(dnn_input_tensor, outputs);
+}
+
+int dnnObjDetector::detectOnce(ObjDetectParams& params, ObjDetectInput& inputData, ObjDetectResults& outputData) {
+    std::vector<IDnnEngine::dnnOutput> dnn_output_vector{};
+    int ret = inferOnce(params, inputData, dnn_output_vector);
+    if (ret != 0) {
+        return ret;
+    }
+    common::CpuAffinity::ScopedStage stage(common::CpuAffinity::Stage::PostProcess);
+    return m_dnnPluginHandle->postProcessResults(params, dnn_output_vector, outputData);
+}
+
+int dnnObjDetector::detectOnce(ObjDetectParams& params, ObjDetectInput& inputData, std::vector<ObjDetectOutput>& outputData) {
     // In case the algorithm plugin is not provided
     if ((m_pluginLibraryHandle == nullptr) || (m_dnnPluginHandle == nullptr)) {
         m_logger->printStdoutLog(Logger::LogLevel::Error, "pluginLibraryHandle is nullptr.");
         IDnnEngine::dnnInput dnn_input_tensor{};
-        defaultPreProcess(*m_dataInput, dnn_input_tensor);
-        m_dnnEngine->pushInputData(dnn_input_tensor);
-        m_dnnEngine->runInference();
+        defaultPreProcess(inputData, dnn_input_tensor);
         std::vector<IDnnEngine::dnnOutput> dnn_output_vector{};
-        m_dnnEngine->popOutputData(dnn_output_vector);
+        int ret = runEngine(dnn_input_tensor, dnn_output_vector);
+        if (ret != 0) {
+            return ret;
+        }
         return defaultPostProcess(m_labelTextPath, params,
-                    dnn_output_vector, m_dataOutputVector);
+                    dnn_output_vector, outputData);
     }
 
-    IDnnEngine::dnnInput dnn_input_tensor{};
-    m_dnnPluginHandle->preProcess(params, *m_dataInput, dnn_input_tensor);
-    m_dnnEngine->pushInputData(dnn_input_tensor);
-    m_dnnEngine->runInference();
     std::vector<IDnnEngine::dnnOutput> dnn_output_vector{};
-    m_dnnEngine->popOutputData(dnn_output_vector);
-    m_logger->printStdoutLog(Logger::LogLevel::Info, "dnn_output_vector.size(): {}", dnn_output_vector.size());
-    for (const auto& dnn_output : dnn_output_vector) {
-        m_logger->printStdoutLog(Logger::LogLevel::Info, "dnn_output.index: {}, dnn_output.size: {}", dnn_output.index, dnn_output.size);
-        m_logger->printStdoutLog(Logger::LogLevel::Info, "dnn_output.dataType: {}", dnn_output.dataType);
+    int ret = inferOnce(params, inputData, dnn_output_vector);
+    if (ret != 0) {
+        return ret;
     }
-    m_dataOutputVector.clear();
+    common::CpuAffinity::ScopedStage stage(common::CpuAffinity::Stage::PostProcess);
     return m_dnnPluginHandle->postProcess(m_labelTextPath, params,
-                dnn_output_vector, m_dataOutputVector);
+                dnn_output_vector, outputData);
+}
+
+int dnnObjDetector::runTiledDetect(ObjDetectParams& params) {
+    size_t frame_width = 0;
+    size_t frame_height = 0;
+    if (!imageTiler::getFrameSize(*m_dataInput, frame_width, frame_height) || m_dnnPluginHandle == nullptr) {
+        m_logger->printStdoutLog(Logger::LogLevel::Error, "Tiling is not supported for this input, fall back to the full frame.");
+        m_dataOutputVector.clear();
+        return detectOnce(params, *m_dataInput, m_dataOutputVector);
+    }
+
+    size_t tile_width = m_tileParams->tile_width > 0 ? m_tileParams->tile_width : params.model_input_width;
+    size_t tile_height = m_tileParams->tile_height > 0 ? m_tileParams->tile_height : params.model_input_height;
+    // Tile sizes and ROIs are given in original image pixels, the handle may hold a reduced decode
+    int downscale = std::max(1, m_dataInput->decodeDownscale);
+    const ObjDetectTileParams* tile_params = m_tileParams.get();
+    ObjDetectTileParams decoded_params;
+    if (downscale > 1 && !m_tileParams->roi_regions.empty()) {
+        decoded_params = *m_tileParams;
+        for (auto& region : decoded_params.roi_regions) {
+            // outward rounding, the scaled region still covers the original one
+            region.left = region.left / downscale;
+            region.top = region.top / downscale;
+            region.right = (region.right + downscale - 1) / downscale;
+            region.bottom = (region.bottom + downscale - 1) / downscale;
+        }
+        tile_params = &decoded_params;
+    }
+    auto tiles = imageTiler::computeTiles(frame_width, frame_height,
+            std::max<size_t>(1, tile_width / downscale), std::max<size_t>(1, tile_height / downscale), *tile_params);
+
+    // The tiles that succeed are still merged, the first failure is returned
+    int ret = 0;
+    auto keep_first_error = [&ret](int status) {
+        if (ret == 0 && status != 0) {
+            ret = status;
+        }
+    };
+
+    std::vector<ObjDetectOutput> merged;
+    if (m_tileParams->include_full_frame) {
+        ObjDetectParams frame_params = params;
+        keep_first_error(detectOnce(frame_params, *m_dataInput, merged));
+    }
+
+    // Pre-process the next tile while the engine runs the current one
+    // <region> receives the frame region the tile input covers after the YUV alignment
+    auto prepare = [this, &params](const bboxRect<int>& tile, ObjDetectParams& tileParams, IDnnEngine::dnnInput& tensor,
+            bboxRect<int>& region) {
+        ObjDetectInput tile_input;
+        if (!imageTiler::makeTileInput(*m_dataInput, tile, tile_input, region)) {
+            return -1;
+        }
+        tileParams = params;
+        tileParams.scale_width = static_cast<float>(params.model_input_width) / (region.right - region.left);
+        tileParams.scale_height = static_cast<float>(params.model_input_height) / (region.bottom - region.top);
+        int ret = m_dnnPluginHandle->preProcess(tileParams, tile_input, tensor);
+        toNativeInput(tensor);
+        return ret;
+    };
+
+    ObjDetectParams cur_params = params;
+    ObjDetectParams next_params = params;
+    IDnnEngine::dnnInput cur_tensor{};
+    IDnnEngine::dnnInput next_tensor{};
+    bboxRect<int> cur_region{};
+    bboxRect<int> next_region{};
+    auto& scheduler = common::TaskScheduler::instance();
+    common::CpuAffinity::ScopedStage stage(common::CpuAffinity::Stage::PostProcess);
+    std::future<int> next_ready;
+    int cur_status = tiles.empty() ? 0 : prepare(tiles[0], cur_params, cur_tensor, cur_region);
+
+    for (size_t i = 0; i < tiles.size(); i++) {
+        if (i + 1 < tiles.size()) {
+            next_ready = scheduler.submit([&prepare, &tiles, &next_params, &next_tensor, &next_region, i]() {
+                return prepare(tiles[i + 1], next_params, next_tensor, next_region);
+            }, common::TaskScheduler::Priority::High);
+        }
+
+        std::vector<IDnnEngine::dnnOutput> dnn_output_vector{};
+        std::vector<ObjDetectOutput> tile_outputs;
+        if (cur_status == 0) {
+            cur_status = runEngine(cur_tensor, dnn_output_vector);
+        }
+        if (cur_status == 0) {
+            cur_status = m_dnnPluginHandle->postProcess(m_labelTextPath, cur_params, dnn_output_vector, tile_outputs);
+        }
+        if (cur_status != 0) {
+            m_logger->printStdoutLog(Logger::LogLevel::Error, "Tile {} of {} failed: {}", i, tiles.size(), cur_status);
+            keep_first_error(cur_status);
+        }
+        for (auto& output : tile_outputs) {
+            // back to original image coordinates
+            output.bbox.left = (output.bbox.left + cur_region.left) * downscale;
+            output.bbox.right = (output.bbox.right + cur_region.left) * downscale;
+            output.bbox.top = (output.bbox.top + cur_region.top) * downscale;
+            output.bbox.bottom = (output.bbox.bottom + cur_region.top) * downscale;
+            merged.push_back(std::move(output));
+        }
+
+        if (next_ready.valid()) {
+            // only the High tile preparations may run inline here, a standby load or teardown must not stall the frame
+            cur_status = scheduler.wait(next_ready, common::TaskScheduler::Priority::High);
+            std::swap(cur_tensor, next_tensor);
+            std::swap(cur_params, next_params);
+            std::swap(cur_region, next_region);
+        }
+    }
+
+    bbox_utils::mergeDuplicates(merged, m_tileParams->merge_threshold);
+    m_dataOutputVector.swap(merged);
+    return ret;
 }
 
 
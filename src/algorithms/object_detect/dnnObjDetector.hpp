@@ -2,9 +2,20 @@
 #define __DNN_OBJDETECTOR_HPP__
 
 #include "IDnnObjDetectorPlugin.hpp"
+#include "motionGate.hpp"
+#include "imageTiler.hpp"
+#include "objDetectResults.hpp"
+#include "qualityController.hpp"
+#include "nativeInput.hpp"
 #include "dnn_engines/IDnnEngine.hpp"
+#include "dnn_engines/ModelRegistry.hpp"
+#include "algorithms/object_track/objTracker.hpp"
 #include "common/Logger.hpp"
+#include "common/MemoryReport.hpp"
+#include <atomic>
+#include <future>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <vector>
 
@@ -14,14 +25,100 @@ namespace dnn_algorithm {
 using namespace common;
 using namespace dnn_engine;
 
+// Wall time of the startup phases, in ms
+struct ObjDetectStartupStats {
+    float pluginLoadMs{0.f};    // dlopen and plugin instance
+    float labelLoadMs{0.f};     // label file parsing
+    float modelLoadMs{0.f};     // model registry acquire, overlaps the two phases above in create()
+    IDnnEngine::dnnLoadStats engineLoad{};  // breakdown of a model the registry had to load, zero on a cache hit
+    float configureMs{0.f};     // plugin configure()
+    float warmupMs{0.f};
+    int warmupRuns{0};
+    float totalMs{0.f};         // until the detector is ready
+};
+
 class dnnObjDetector {
 public:
     dnnObjDetector(const std::string& dnnType, const std::string& pluginPath, const std::string& labelTextPath);
 
     virtual ~dnnObjDetector();
 
+    /**
+     * @brief Build a ready detector: the model is loaded on the TaskScheduler while the plugin is opened and the
+     * labels are parsed, then <warmupRuns> inferences on a blank input take the cold start off the first frame.
+     * @throw std::runtime_error / std::invalid_argument if a step fails.
+     */
+    static std::unique_ptr<dnnObjDetector> create(const std::string& dnnType, const std::string& pluginPath,
+            const std::string& labelTextPath, const std::string& modelPath, int warmupRuns = 1);
+
     void loadModel(const std::string& modelPath);
 
+    // Run <runs> inferences on a blank input, returns the first error
+    int warmup(int runs);
+
+    // True once a model is loaded
+    bool isReady() const { return m_dnnEngine != nullptr; }
+
+    /**
+     * @brief Load a new model version into a standby slot while the current one keeps serving runObjDetect.
+     * The standby gets its own plugin instance, labels and warmup on the calling thread. The next runObjDetect
+     * switches to it between frames (adapting the model size and quantization fields of its params), and the
+     * previous model is released on the TaskScheduler once its pending asynchronous runs have drained.
+     * A standby that was not picked up yet is replaced.
+     * @throw like create() if the model cannot be loaded, the active model is untouched then.
+     */
+    void loadStandbyModel(const std::string& modelPath, int warmupRuns = 1);
+
+    // loadStandbyModel() as a low priority TaskScheduler task, the future rethrows load errors.
+    // The detector must outlive the task.
+    std::shared_future<void> loadStandbyModelAsync(const std::string& modelPath, int warmupRuns = 1);
+
+    bool hasStandbyModel() const { return m_standbyReady; }
+
+    // Path of the model serving runObjDetect
+    std::string getModelPath() const;
+
+    /**
+     * @brief Keep another variant of the model resident, e.g. a smaller input size or a lighter backbone.
+     * Variants are ordered from the best to the cheapest: the model loaded first is variant 0 and every call
+     * appends one. Each variant has its own plugin instance; a switch goes through the standby slot, so
+     * runObjDetect adapts the model size, scale and quantization fields of its params to the variant.
+     * @return The index of the variant.
+     * @throw like create() if the model cannot be loaded.
+     */
+    int addModelVariant(const std::string& modelPath, int warmupRuns = 1);
+
+    size_t getVariantCount() const;
+
+    // -1 if the active model is not one of the variants
+    int getActiveVariant() const;
+
+    // Switch to the variant on the next runObjDetect. Returns -1 for an unknown index or while a standby model is pending.
+    int selectVariant(int index);
+
+    /**
+     * @brief Let a qualityController switch between the variants: one step down when the processing time, the
+     * deadline misses or the reported queue depth show overload, one step up after a calm period.
+     */
+    void enableQualityControl(const QualityControlParams& qualityParams);
+
+    void disableQualityControl();
+
+    // Frames waiting for this detector, fed to the quality controller
+    void reportQueueDepth(size_t depth) { m_queueDepth = depth; }
+
+    // State of the quality controller, from the thread running runObjDetect. false if it is not enabled.
+    bool getQualityStats(QualityControlStats& stats) const;
+
+    /**
+     * @brief Add the memory of the detector to <report>: per resident model (active, standby, variants) the engine
+     * breakdown and the labels, then the session buffers (input frame, outputs, native input tables).
+     * Call it from the thread running runObjDetect or between runs.
+     */
+    void reportMemory(MemoryReport& report, const std::string& prefix = "detector") const;
+
+    const ObjDetectStartupStats& getStartupStats() const { return m_startupStats; }
+
     int getInputShape(IDnnEngine::dnnInputShape& shape) {
         return m_dnnEngine->getInputShape(shape);
     }
@@ -34,9 +131,111 @@ public:
 
     std::vector<ObjDetectOutput>& popOutputData();
 
+    /**
+     * @brief The outputs of the last runObjDetect in columnar form.
+     * <results> is cleared and takes the label table of the model that produced the outputs.
+     */
+    void popResults(ObjDetectResults& results);
+
+    // Labels of the active model, nullptr without a label file
+    std::shared_ptr<const LabelTable> getLabelTable() const;
+
     int runObjDetect(ObjDetectParams& params);
 
+    // The stages of runObjDetect as separate calls, for pipelines that run them on different threads.
+    // They use the active model as is: standby switches, tracking, the motion gate and tiling only apply to
+    // runObjDetect. preProcess and postProcess only use the plugin and infer only the engine, so the three may
+    // overlap on different frames (as in the tiled path); none of them may run concurrently with itself.
+
+    // Model size, scale and quantization fields of <params> for a frame of <origWidth> x <origHeight>
+    void initParams(ObjDetectParams& params, size_t origWidth, size_t origHeight);
+
+    int preProcess(ObjDetectParams& params, ObjDetectInput& inputData, IDnnEngine::dnnInput& tensor);
+
+    // The outputs are copied into <storage>, they stay valid across later inferences
+    int infer(IDnnEngine::dnnInput& tensor, std::vector<IDnnEngine::dnnOutput>& outputs,
+            std::vector<std::vector<uint8_t>>& storage);
+
+    int postProcess(ObjDetectParams& params, std::vector<IDnnEngine::dnnOutput>& outputs,
+            std::vector<ObjDetectOutput>& outputData);
+
+    /**
+     * @brief Track objects between detections.
+     * The full detection only runs every <detectInterval> frames, or earlier when the confidence of a track
+     * falls below <minTrackConfidence>; the frames in between return the tracks predicted by the tracker.
+     */
+    void enableTracking(const ObjTrackParams& trackParams, int detectInterval, float minTrackConfidence);
+
+    void disableTracking();
+
+    /**
+     * @brief Skip the inference on static frames.
+     * When the motion gate reports an unchanged scene, runObjDetect re-emits the previous outputs.
+     */
+    void enableMotionGate(const MotionGateParams& gateParams);
+
+    void disableMotionGate();
+
+    /**
+     * @brief Detect on overlapping model-sized tiles instead of the letterboxed frame.
+     * Keeps small objects in high-resolution frames; tiles outside the ROI regions are skipped,
+     * duplicates across tile seams are merged.
+     */
+    void enableTiling(const ObjDetectTileParams& tileParams);
+
+    void disableTiling();
+
+    /**
+     * @brief Hand the engine its native input tensor (IDnnEngine::getInputDesc) instead of packed RGB.
+     * The plugin output is normalized, quantized and laid out in one table-driven pass and submitted with
+     * pass-through, so the runtime skips its own conversion. <inputParams> must match the normalization the
+     * model was converted with. Engines or models without a pass-through input keep the regular path.
+     */
+    void enableNativeInput(const NativeInputParams& inputParams);
+
+    void disableNativeInput();
+
+    // true if the last runObjDetect call was skipped by the motion gate
+    bool isLastFrameSkipped() const { return m_lastFrameSkipped; }
+
 private:
+    int runDetect(ObjDetectParams& params);
+    int runTiledDetect(ObjDetectParams& params);
+    int detectOnce(ObjDetectParams& params, ObjDetectInput& inputData, std::vector<ObjDetectOutput>& outputData);
+    int detectOnce(ObjDetectParams& params, ObjDetectInput& inputData, ObjDetectResults& outputData);
+    // Pre-processing and inference of a frame with the plugin, the outputs are valid until the next inference
+    int inferOnce(ObjDetectParams& params, ObjDetectInput& inputData, std::vector<IDnnEngine::dnnOutput>& outputs);
+    // push, run and pop on the engine, stops at the first failure and clears <outputs>
+    int runEngine(IDnnEngine::dnnInput& tensor, std::vector<IDnnEngine::dnnOutput>& outputs);
+    bool useResults() const;
+    bool isDetectFrame() const;
+    // A loaded model with the plugin instance configured for it
+    struct modelSlot {
+        std::shared_ptr<void> library{nullptr};    // declared first so the plugin code outlives the plugin
+        std::shared_ptr<IDnnObjDetectorPlugin> plugin{nullptr};
+        std::shared_ptr<IDnnEngine> engine{nullptr};
+        std::string modelPath{};
+        std::shared_ptr<const LabelTable> labelTable{nullptr};
+        IDnnEngine::dnnInputShape inputShape{};
+        std::vector<int32_t> zeroPoints{};
+        std::vector<float> scales{};
+    };
+
+    std::shared_ptr<IDnnObjDetectorPlugin> createPlugin();
+    std::shared_ptr<modelSlot> loadSlot(const std::string& modelPath, int warmupRuns);
+    // Called with m_slotMutex held
+    int variantOf(const std::shared_ptr<modelSlot>& slot) const;
+    void adaptQuality(float processMs);
+    void prepareNativeInput();
+    void toNativeInput(IDnnEngine::dnnInput& tensor) const;
+    std::shared_ptr<modelSlot> makeSlot(std::shared_ptr<IDnnObjDetectorPlugin> plugin,
+            std::shared_ptr<IDnnEngine> engine, const std::string& modelPath);
+    void attachEngine(std::shared_ptr<IDnnEngine> engine, const std::string& modelPath);
+    void switchToStandby();
+    void syncParams(ObjDetectParams& params) const;
+    void loadLabels();
+    int warmupEngine(IDnnEngine& engine, int runs);
+
     int defaultPreProcess(ObjDetectInput& inputData, IDnnEngine::dnnInput& outputData);
     int defaultPostProcess(const std::string& labelTextPath, const ObjDetectParams& params,
             std::vector<IDnnEngine::dnnOutput>& inputData, std::vector<ObjDetectOutput>& outputData);
@@ -44,11 +243,37 @@ private:
 private:
     std::shared_ptr<void> m_pluginLibraryHandle{nullptr};
     std::shared_ptr<IDnnObjDetectorPlugin> m_dnnPluginHandle{nullptr};
-    std::unique_ptr<IDnnEngine> m_dnnEngine{nullptr};
+    std::shared_ptr<IDnnEngine> m_dnnEngine{nullptr};
     std::unique_ptr<Logger> m_logger{nullptr};
+    std::string m_dnnType;
     std::shared_ptr<ObjDetectInput> m_dataInput{nullptr};
     std::vector<ObjDetectOutput> m_dataOutputVector;
+    // Outputs of plugins that decode into columns; m_dataOutputVector is then only built on popOutputData()
+    ObjDetectResults m_results{};
+    ObjDetectResults m_trackInput{};
+    bool m_columnar{false};
+    bool m_outputsBuilt{true};
     std::string m_labelTextPath;
+    std::unique_ptr<objTracker> m_tracker{nullptr};
+    int m_detectInterval{1};
+    float m_minTrackConfidence{0.0};
+    int m_framesSinceDetect{0};
+    std::unique_ptr<motionGate> m_motionGate{nullptr};
+    bool m_lastFrameSkipped{false};
+    std::unique_ptr<ObjDetectTileParams> m_tileParams{nullptr};
+    std::unique_ptr<NativeInputParams> m_nativeInputParams{nullptr};
+    // built for the engine of the active model, read concurrently by the tile pre-processing
+    std::shared_ptr<const nativeInputConverter> m_nativeConverter{nullptr};
+    const IDnnEngine* m_nativeConverterEngine{nullptr};
+    ObjDetectStartupStats m_startupStats{};
+    // m_activeSlot is only replaced by the thread running runObjDetect, under m_slotMutex
+    mutable std::mutex m_slotMutex;
+    std::shared_ptr<modelSlot> m_activeSlot{nullptr};
+    std::shared_ptr<modelSlot> m_standbySlot{nullptr};
+    std::atomic<bool> m_standbyReady{false};
+    std::vector<std::shared_ptr<modelSlot>> m_variants{};   // under m_slotMutex
+    std::unique_ptr<qualityController> m_qualityController{nullptr};
+    std::atomic<size_t> m_queueDepth{0};
 
 };
 
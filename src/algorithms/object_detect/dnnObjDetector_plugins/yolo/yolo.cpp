@@ -0,0 +1,388 @@
+#include "yolo.hpp"
+#include "algorithms/object_detect/outputDecode.hpp"
+#include "algorithms/object_detect/objDetectResults.hpp"
+#include "algorithms/object_detect/letterbox.hpp"
+#include "algorithms/object_detect/postProcessExecutor.hpp"
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+namespace dnn_algorithm {
+
+namespace {
+
+const std::vector<float> YOLOV5_ANCHORS = {
+    10, 13, 16, 30, 33, 23,
+    30, 61, 62, 45, 59, 119,
+    116, 90, 156, 198, 373, 326
+};
+
+const std::vector<float> YOLOV7_ANCHORS = {
+    12, 16, 19, 36, 40, 28,
+    36, 75, 76, 55, 72, 146,
+    142, 110, 192, 243, 459, 401
+};
+
+std::string trim(const std::string& str) {
+    size_t first = str.find_first_not_of(" \t\r\n");
+    if (first == std::string::npos) {
+        return "";
+    }
+    size_t last = str.find_last_not_of(" \t\r\n");
+    return str.substr(first, last - first + 1);
+}
+
+} // namespace
+
+bool yolo::getGridSize(const IDnnEngine::dnnOutputDesc& desc, int& channel, int& gridH, int& gridW) {
+    if (desc.dims.size() != 4) {
+        return false;
+    }
+    if (desc.layout == "NHWC") {
+        gridH = static_cast<int>(desc.dims[1]);
+        gridW = static_cast<int>(desc.dims[2]);
+        channel = static_cast<int>(desc.dims[3]);
+    }
+    else {
+        channel = static_cast<int>(desc.dims[1]);
+        gridH = static_cast<int>(desc.dims[2]);
+        gridW = static_cast<int>(desc.dims[3]);
+    }
+    return channel > 0 && gridH > 0 && gridW > 0;
+}
+
+// Optional "<model>.yolo" key=value file next to the model
+int yolo::loadSidecar(const std::string& sidecarPath, std::string& family, std::vector<float>& anchors) {
+    std::ifstream sidecar(sidecarPath);
+    if (!sidecar.is_open()) {
+        return 0;
+    }
+
+    std::cout << "loading yolo config: " << sidecarPath << std::endl;
+    std::string line;
+    while (std::getline(sidecar, line)) {
+        line = trim(line);
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+        size_t pos = line.find('=');
+        if (pos == std::string::npos) {
+            std::cerr << "Invalid line in yolo config: " << line << std::endl;
+            return -1;
+        }
+        std::string key = trim(line.substr(0, pos));
+        std::string value = trim(line.substr(pos + 1));
+        if (key == "family") {
+            family = value;
+        }
+        else if (key == "anchors") {
+            anchors.clear();
+            std::stringstream ss(value);
+            std::string item;
+            while (std::getline(ss, item, ',')) {
+                anchors.push_back(std::stof(item));
+            }
+        }
+        else if (key == "reg_max") {
+            m_config.reg_max = std::stoi(value);
+        }
+        else {
+            std::cerr << "Unknown key in yolo config: " << key << std::endl;
+        }
+    }
+    return 0;
+}
+
+int yolo::configure(const ObjDetectModelDesc& modelDesc) {
+    m_configured = false;
+    m_config = yolo_decoder::YoloConfig{};
+    if (modelDesc.outputs.empty() || modelDesc.inputShape.height == 0) {
+        std::cerr << "The model descriptor is empty." << std::endl;
+        return -1;
+    }
+
+    std::string family;
+    std::vector<float> anchors;
+    if (loadSidecar(modelDesc.modelPath + ".yolo", family, anchors) != 0) {
+        return -1;
+    }
+
+    if (family.empty()) {
+        // v8 heads start with the 4 * reg_max DFL box tensor, v5/v7 heads carry anchors * (5 + classes) channels
+        int channel = 0;
+        int grid_h = 0;
+        int grid_w = 0;
+        if (!getGridSize(modelDesc.outputs[0], channel, grid_h, grid_w)) {
+            std::cerr << "Unsupported output dims of the model." << std::endl;
+            return -1;
+        }
+        family = (channel == 4 * m_config.reg_max && modelDesc.outputs.size() > 3) ? "v8" : "v5";
+    }
+
+    int ret = -1;
+    if (family == "v5" || family == "v7") {
+        if (anchors.empty()) {
+            anchors = family == "v7" ? YOLOV7_ANCHORS : YOLOV5_ANCHORS;
+        }
+        ret = configureAnchorBased(modelDesc, anchors);
+    }
+    else if (family == "v8") {
+        ret = configureAnchorFree(modelDesc);
+    }
+    else {
+        std::cerr << "Unknown yolo family: " << family << std::endl;
+    }
+    if (ret != 0) {
+        return ret;
+    }
+
+    m_config.num_outputs = modelDesc.outputs.size();
+    m_configured = true;
+    std::cout << "yolo " << family << ": " << m_config.heads.size() << " heads, "
+              << m_config.num_classes << " classes" << std::endl;
+    return 0;
+}
+
+int yolo::configureAnchorBased(const ObjDetectModelDesc& modelDesc, const std::vector<float>& anchors) {
+    m_config.family = yolo_decoder::YoloFamily::ANCHOR_BASED;
+    if (anchors.size() != modelDesc.outputs.size() * 6) {
+        std::cerr << "Expected 6 anchor values per output, got " << anchors.size() << std::endl;
+        return -1;
+    }
+
+    for (size_t i = 0; i < modelDesc.outputs.size(); i++) {
+        int channel = 0;
+        yolo_decoder::YoloHead head;
+        if (!getGridSize(modelDesc.outputs[i], channel, head.grid_h, head.grid_w) || modelDesc.outputs[i].layout != "NCHW"
+                || channel % yolo_decoder::YOLO_ANCHORS_NUM != 0) {
+            std::cerr << "Unsupported anchor-based output " << i << std::endl;
+            return -1;
+        }
+        int num_classes = channel / yolo_decoder::YOLO_ANCHORS_NUM - 5;
+        if (num_classes <= 0 || (i > 0 && num_classes != m_config.num_classes)) {
+            std::cerr << "Inconsistent class count in output " << i << std::endl;
+            return -1;
+        }
+        m_config.num_classes = num_classes;
+        head.stride = static_cast<int>(modelDesc.inputShape.height) / head.grid_h;
+        head.box_output = static_cast<int>(i);
+        m_config.heads.push_back(head);
+    }
+
+    // anchors are listed from the smallest stride up
+    std::sort(m_config.heads.begin(), m_config.heads.end(),
+            [](const yolo_decoder::YoloHead& a, const yolo_decoder::YoloHead& b) { return a.stride < b.stride; });
+    for (size_t i = 0; i < m_config.heads.size(); i++) {
+        std::copy(anchors.begin() + i * 6, anchors.begin() + (i + 1) * 6, m_config.heads[i].anchors.begin());
+    }
+    return 0;
+}
+
+int yolo::configureAnchorFree(const ObjDetectModelDesc& modelDesc) {
+    m_config.family = yolo_decoder::YoloFamily::ANCHOR_FREE;
+    const auto& outputs = modelDesc.outputs;
+
+    // Per head: box (4 * reg_max), cls (classes) and an optional score sum (1 channel)
+    int channel = 0;
+    int grid_h = 0;
+    int grid_w = 0;
+    size_t group = 2;
+    if (outputs.size() >= 3 && outputs.size() % 3 == 0 && getGridSize(outputs[2], channel, grid_h, grid_w) && channel == 1) {
+        group = 3;
+    }
+    if (outputs.size() % group != 0) {
+        std::cerr << "Unsupported anchor-free output count: " << outputs.size() << std::endl;
+        return -1;
+    }
+
+    for (size_t i = 0; i < outputs.size(); i += group) {
+        int box_channel = 0;
+        int cls_channel = 0;
+        yolo_decoder::YoloHead head;
+        if (!getGridSize(outputs[i], box_channel, head.grid_h, head.grid_w)
+                || !getGridSize(outputs[i + 1], cls_channel, grid_h, grid_w)
+                || outputs[i].layout != "NCHW" || outputs[i + 1].layout != "NCHW"
+                || grid_h != head.grid_h || grid_w != head.grid_w || box_channel % 4 != 0) {
+            std::cerr << "Unsupported anchor-free head at output " << i << std::endl;
+            return -1;
+        }
+        if (box_channel / 4 > 64 || (i > 0 && (box_channel / 4 != m_config.reg_max || cls_channel != m_config.num_classes))) {
+            std::cerr << "Inconsistent anchor-free head at output " << i << std::endl;
+            return -1;
+        }
+        m_config.reg_max = box_channel / 4;
+        m_config.num_classes = cls_channel;
+        head.stride = static_cast<int>(modelDesc.inputShape.height) / head.grid_h;
+        head.box_output = static_cast<int>(i);
+        head.cls_output = static_cast<int>(i + 1);
+        head.sum_output = group == 3 ? static_cast<int>(i + 2) : -1;
+        m_config.heads.push_back(head);
+    }
+    return 0;
+}
+
+int yolo::preProcess(ObjDetectParams& params, ObjDetectInput& inputData, IDnnEngine::dnnInput& outputData) {
+    return letterbox::preProcess(params, inputData, outputData);
+}
+
+int yolo::postProcess(const std::string& labelTextPath, const ObjDetectParams& params,
+        std::vector<IDnnEngine::dnnOutput>& inputData, std::vector<ObjDetectOutput>& outputData) {
+    if (!m_configured) {
+        std::cerr << "The yolo plugin is not configured with the model outputs." << std::endl;
+        return -1;
+    }
+    if (inputData.size() != m_config.num_outputs || labelTextPath.empty()) {
+        throw std::invalid_argument("The size of inputData does not match the model outputs or labelTextPath is empty.");
+    }
+
+    int ret = initLabelMap(labelTextPath);
+    if (ret == 0) {
+        ret = decodeOutputs(params, inputData);
+    }
+    if (ret != 0) {
+        return ret;
+    }
+
+    return runNms(params, [this, &outputData](float left, float top, float right, float bottom, float score, int id) {
+        ObjDetectOutput output_box;
+        output_box.bbox.left = static_cast<int>(left);
+        output_box.bbox.top = static_cast<int>(top);
+        output_box.bbox.right = static_cast<int>(right);
+        output_box.bbox.bottom = static_cast<int>(bottom);
+        output_box.score = score;
+        output_box.label = id < static_cast<int>(m_labelMap.size()) ? m_labelMap[id] : std::to_string(id);
+        output_box.classId = id;
+        outputData.push_back(output_box);
+    });
+}
+
+int yolo::postProcessResults(const ObjDetectParams& params, std::vector<IDnnEngine::dnnOutput>& inputData,
+        ObjDetectResults& outputData) {
+    if (!m_configured) {
+        std::cerr << "The yolo plugin is not configured with the model outputs." << std::endl;
+        return -1;
+    }
+    if (inputData.size() != m_config.num_outputs) {
+        throw std::invalid_argument("The size of inputData does not match the model outputs.");
+    }
+
+    int ret = decodeOutputs(params, inputData);
+    if (ret != 0) {
+        return ret;
+    }
+    return runNms(params, [&outputData](float left, float top, float right, float bottom, float score, int id) {
+        outputData.push(left, top, right, bottom, score, id);
+    });
+}
+
+int yolo::decodeOutputs(const ObjDetectParams& params, const std::vector<IDnnEngine::dnnOutput>& inputData) {
+    const std::string& data_type = inputData[0].dataType;
+    for (const auto& output : inputData) {
+        if (output.dataType != data_type) {
+            throw std::invalid_argument("Mixed output dataTypes are not supported.");
+        }
+    }
+
+    m_candidates.clear();
+    switch (output_decode::parseOutputType(data_type)) {
+    case output_decode::OutputType::INT8: {
+        if (params.quantize_zero_points.size() < inputData.size() || params.quantize_scales.size() < inputData.size()) {
+            throw std::invalid_argument("Missing quantization params for the int8 outputs.");
+        }
+        std::vector<output_decode::int8Decoder> decoders;
+        for (size_t i = 0; i < inputData.size(); i++) {
+            decoders.push_back({params.quantize_zero_points[i], params.quantize_scales[i]});
+        }
+        decodeAll(decoders, inputData, params.conf_threshold);
+        break;
+    }
+    case output_decode::OutputType::FP16:
+        decodeAll(std::vector<output_decode::fp16Decoder>(inputData.size()), inputData, params.conf_threshold);
+        break;
+    case output_decode::OutputType::FP32:
+        decodeAll(std::vector<output_decode::fp32Decoder>(inputData.size()), inputData, params.conf_threshold);
+        break;
+    default:
+        throw std::invalid_argument("Unsupported output dataType: " + data_type);
+    }
+    return 0;
+}
+
+template <typename Decoder>
+void yolo::decodeAll(const std::vector<Decoder>& decoders, const std::vector<IDnnEngine::dnnOutput>& inputData,
+        float confThreshold) {
+    std::vector<const void*> bufs;
+    for (const auto& output : inputData) {
+        bufs.push_back(output.buf);
+    }
+
+    m_headScratch.resize(m_config.heads.size());
+    postProcessExecutor::instance().parallelFor(m_config.heads.size(), [&](size_t i) {
+        auto& scratch = m_headScratch[i];
+        scratch.candidates.clear();
+        yolo_decoder::decodeHead(m_config, m_config.heads[i], decoders, bufs, confThreshold,
+                scratch.cells, scratch.cellMarks, scratch.candidates);
+    });
+
+    for (const auto& scratch : m_headScratch) {
+        const auto& head = scratch.candidates;
+        m_candidates.boxes.insert(m_candidates.boxes.end(), head.boxes.begin(), head.boxes.end());
+        m_candidates.scores.insert(m_candidates.scores.end(), head.scores.begin(), head.scores.end());
+        m_candidates.classIds.insert(m_candidates.classIds.end(), head.classIds.begin(), head.classIds.end());
+    }
+}
+
+// Class-aware NMS over the candidates, then back to original image coordinates
+template <typename Emit>
+int yolo::runNms(const ObjDetectParams& params, Emit&& emit) {
+    const auto& boxes = m_candidates.boxes;
+    const auto& scores = m_candidates.scores;
+    const auto& class_ids = m_candidates.classIds;
+    std::vector<int> kept = postProcessExecutor::instance().classAwareNms(boxes, scores, class_ids,
+            params.nms_threshold, MAX_OBJ_NUM);
+
+    float max_w = static_cast<float>(params.model_input_width);
+    float max_h = static_cast<float>(params.model_input_height);
+    for (int n : kept) {
+        float x1 = boxes[n * 4 + 0] - params.pads.left;
+        float y1 = boxes[n * 4 + 1] - params.pads.top;
+        float x2 = x1 + boxes[n * 4 + 2];
+        float y2 = y1 + boxes[n * 4 + 3];
+        emit(std::clamp(x1, 0.f, max_w) / params.scale_width, std::clamp(y1, 0.f, max_h) / params.scale_height,
+             std::clamp(x2, 0.f, max_w) / params.scale_width, std::clamp(y2, 0.f, max_h) / params.scale_height,
+             scores[n], class_ids[n]);
+    }
+    return 0;
+}
+
+// Load the label list file
+int yolo::initLabelMap(const std::string& labelMapPath) {
+    if (m_labelMapInited) {
+        return 0;
+    }
+
+    if (labelMapPath.empty()) {
+        return -1;
+    }
+
+    std::cout << "loading label path: " << labelMapPath << std::endl;
+
+    std::ifstream labelFile(labelMapPath);
+    if (!labelFile.is_open()) {
+        std::cerr << "Failed to open label map file: " << labelMapPath << std::endl;
+        return -1;
+    }
+
+    std::string line;
+    while (std::getline(labelFile, line)) {
+        m_labelMap.push_back(line);
+    }
+
+    labelFile.close();
+    m_labelMapInited = true;
+    return 0;
+}
+
+
+} // namespace dnn_algorithm
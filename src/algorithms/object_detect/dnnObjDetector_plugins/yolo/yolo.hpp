@@ -0,0 +1,80 @@
+#ifndef __YOLO_HPP__
+#define __YOLO_HPP__
+
+#include "algorithms/object_detect/IDnnObjDetectorPlugin.hpp"
+#include "yoloDecoder.hpp"
+#include <string>
+#include <vector>
+#include <cstdint>
+
+
+namespace dnn_algorithm {
+
+/**
+ * Generic YOLO plugin covering the anchor-based (v5, v7) and the anchor-free DFL (v8) heads.
+ * The head layout, class count and strides are taken from the model outputs in configure();
+ * an optional sidecar file "<model>.yolo" with key=value lines overrides the detection:
+ *   family=v5|v7|v8
+ *   anchors=10,13,16,30,33,23,30,61,62,45,59,119,116,90,156,198,373,326
+ *   reg_max=16
+ */
+class yolo : public IDnnObjDetectorPlugin
+{
+public:
+    static constexpr int MAX_OBJ_NUM = 64;
+
+    yolo() = default;
+    ~yolo() = default;
+
+    int configure(const ObjDetectModelDesc& modelDesc) override;
+    int loadLabels(const std::string& labelTextPath) override {
+        return initLabelMap(labelTextPath);
+    }
+    int preProcess(ObjDetectParams& params, ObjDetectInput& inputData, IDnnEngine::dnnInput& outputData) override;
+    int postProcess(const std::string& labelTextPath, const ObjDetectParams& params,
+            std::vector<IDnnEngine::dnnOutput>& inputData, std::vector<ObjDetectOutput>& outputData)  override;
+    bool supportsResults() const override { return true; }
+    int postProcessResults(const ObjDetectParams& params, std::vector<IDnnEngine::dnnOutput>& inputData,
+            ObjDetectResults& outputData) override;
+
+private:
+    int initLabelMap(const std::string& labelMapPath);
+    int loadSidecar(const std::string& sidecarPath, std::string& family, std::vector<float>& anchors);
+    int configureAnchorBased(const ObjDetectModelDesc& modelDesc, const std::vector<float>& anchors);
+    int configureAnchorFree(const ObjDetectModelDesc& modelDesc);
+
+    // Candidates of all heads into m_candidates
+    int decodeOutputs(const ObjDetectParams& params, const std::vector<IDnnEngine::dnnOutput>& inputData);
+
+    template <typename Decoder>
+    void decodeAll(const std::vector<Decoder>& decoders, const std::vector<IDnnEngine::dnnOutput>& inputData,
+            float confThreshold);
+
+    // <emit> receives every kept box in original image coordinates
+    template <typename Emit>
+    int runNms(const ObjDetectParams& params, Emit&& emit);
+
+    static bool getGridSize(const IDnnEngine::dnnOutputDesc& desc, int& channel, int& gridH, int& gridW);
+
+private:
+    yolo_decoder::YoloConfig m_config{};
+    bool m_configured{false};
+    // Per-head scratch, the heads are decoded concurrently
+    struct HeadScratch {
+        yolo_decoder::YoloCandidates candidates{};
+        std::vector<uint32_t> cells{};
+        std::vector<uint8_t> cellMarks{};
+    };
+    std::vector<HeadScratch> m_headScratch{};
+    yolo_decoder::YoloCandidates m_candidates{};
+    std::vector<std::string> m_labelMap;
+    bool m_labelMapInited{false};
+};
+
+
+
+} // namespace dnn_algorithm
+
+CREATE_PLUGIN_INSTANCE(dnn_algorithm::yolo)
+
+#endif // __YOLO_HPP__
@@ -0,0 +1,265 @@
+#ifndef __YOLO_DECODER_HPP__
+#define __YOLO_DECODER_HPP__
+
+#include "algorithms/object_detect/outputDecode.hpp"
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace dnn_algorithm {
+
+/**
+ * Output head decoders of the YOLO family.
+ *
+ * Anchor-based heads (YOLOv5/v7): one NCHW tensor per stride with
+ * anchors * (5 + classes) channels, sigmoid already applied in the model.
+ * Anchor-free heads (YOLOv8): per stride a box tensor with 4 * reg_max DFL bins, a class tensor
+ * and optionally a score-sum tensor used to reject empty cells early.
+ *
+ * The kernels are templates on the element decoder (int8/fp16/fp32), the class count and the
+ * number of DFL bins; common values are instantiated with compile-time constants so the inner
+ * loops have constant trip counts, any other value uses the runtime count.
+ */
+namespace yolo_decoder {
+
+enum class YoloFamily {
+    ANCHOR_BASED, // v5, v7
+    ANCHOR_FREE   // v8
+};
+
+struct YoloHead {
+    int stride{8};
+    int grid_h{0};
+    int grid_w{0};
+    std::array<float, 6> anchors{}; // anchor-based: 3 (w, h) pairs in input pixels
+    int box_output{-1};             // anchor-based: the only tensor of the head
+    int cls_output{-1};             // anchor-free
+    int sum_output{-1};             // anchor-free, optional
+};
+
+struct YoloConfig {
+    YoloFamily family{YoloFamily::ANCHOR_BASED};
+    int num_classes{80};
+    int reg_max{16};
+    std::vector<YoloHead> heads{};
+    size_t num_outputs{0};
+};
+
+// Decoded boxes before NMS, in letterboxed model input pixels
+struct YoloCandidates {
+    std::vector<float> boxes{}; // x, y, w, h
+    std::vector<float> scores{};
+    std::vector<int> classIds{};
+
+    void clear() {
+        boxes.clear();
+        scores.clear();
+        classIds.clear();
+    }
+
+    void push(float x, float y, float w, float h, float score, int classId) {
+        boxes.push_back(x);
+        boxes.push_back(y);
+        boxes.push_back(w);
+        boxes.push_back(h);
+        scores.push_back(score);
+        classIds.push_back(classId);
+    }
+};
+
+constexpr int YOLO_ANCHORS_NUM = 3;
+
+template <typename Decoder, int NUM_CLASSES>
+void decodeAnchorHead(const Decoder& decoder, const void* buf, const YoloHead& head, int numClasses,
+        float confThreshold, std::vector<uint32_t>& cells, YoloCandidates& candidates) {
+    using raw_type = typename Decoder::raw_type;
+    using key_type = typename Decoder::key_type;
+    const int nc = NUM_CLASSES > 0 ? NUM_CLASSES : numClasses;
+    const int prop_size = 5 + nc;
+    const int grid_len = head.grid_h * head.grid_w;
+    const key_type thres = decoder.keyThreshold(confThreshold);
+    const raw_type* input = static_cast<const raw_type*>(buf);
+
+    for (int a = 0; a < YOLO_ANCHORS_NUM; a++) {
+        cells.clear();
+        const raw_type* conf_plane = input + (prop_size * a + 4) * grid_len;
+        decoder.scan(conf_plane, grid_len, thres, cells);
+
+        for (auto cell : cells) {
+            const raw_type* in_ptr = input + (prop_size * a) * grid_len + cell;
+            const raw_type* cls_ptr = in_ptr + 5 * grid_len;
+            key_type max_key = decoder.key(cls_ptr[0]);
+            int max_id = 0;
+            for (int k = 1; k < nc; k++) {
+                key_type prob = decoder.key(cls_ptr[k * grid_len]);
+                if (prob > max_key) {
+                    max_key = prob;
+                    max_id = k;
+                }
+            }
+            if (!(max_key > thres)) {
+                continue;
+            }
+
+            int i = cell / head.grid_w;
+            int j = cell % head.grid_w;
+            float box_x = decoder.toFloat(in_ptr[0]) * 2.0f - 0.5f;
+            float box_y = decoder.toFloat(in_ptr[grid_len]) * 2.0f - 0.5f;
+            float box_w = decoder.toFloat(in_ptr[2 * grid_len]) * 2.0f;
+            float box_h = decoder.toFloat(in_ptr[3 * grid_len]) * 2.0f;
+            box_x = (box_x + j) * head.stride;
+            box_y = (box_y + i) * head.stride;
+            box_w = box_w * box_w * head.anchors[a * 2];
+            box_h = box_h * box_h * head.anchors[a * 2 + 1];
+            float score = decoder.toFloat(cls_ptr[max_id * grid_len]) * decoder.toFloat(conf_plane[cell]);
+            candidates.push(box_x - box_w / 2.0f, box_y - box_h / 2.0f, box_w, box_h, score, max_id);
+        }
+    }
+}
+
+template <typename Decoder, int REG_MAX>
+inline float dflDistance(const Decoder& decoder, const typename Decoder::raw_type* bins, int gridLen, int regMax) {
+    const int n = REG_MAX > 0 ? REG_MAX : regMax;
+    float values[64];
+    float max_val = -1e30f;
+    for (int k = 0; k < n && k < 64; k++) {
+        values[k] = decoder.toFloat(bins[k * gridLen]);
+        max_val = values[k] > max_val ? values[k] : max_val;
+    }
+    float sum = 0.f;
+    float expectation = 0.f;
+    for (int k = 0; k < n && k < 64; k++) {
+        float e = std::exp(values[k] - max_val);
+        sum += e;
+        expectation += e * k;
+    }
+    return expectation / sum;
+}
+
+template <typename Decoder, int NUM_CLASSES, int REG_MAX>
+void decodeDflHead(const Decoder& boxDecoder, const Decoder& clsDecoder, const Decoder* sumDecoder,
+        const void* boxBuf, const void* clsBuf, const void* sumBuf, const YoloHead& head, int numClasses, int regMax,
+        float confThreshold, std::vector<uint32_t>& cells, std::vector<uint8_t>& cellMarks, YoloCandidates& candidates) {
+    using raw_type = typename Decoder::raw_type;
+    using key_type = typename Decoder::key_type;
+    const int nc = NUM_CLASSES > 0 ? NUM_CLASSES : numClasses;
+    const int reg_max = REG_MAX > 0 ? REG_MAX : regMax;
+    const int grid_len = head.grid_h * head.grid_w;
+    const key_type thres = clsDecoder.keyThreshold(confThreshold);
+    const raw_type* box_input = static_cast<const raw_type*>(boxBuf);
+    const raw_type* cls_input = static_cast<const raw_type*>(clsBuf);
+
+    cells.clear();
+    if (sumDecoder != nullptr && sumBuf != nullptr) {
+        // the score-sum plane bounds every class score of the cell
+        sumDecoder->scan(static_cast<const raw_type*>(sumBuf), grid_len, sumDecoder->keyThreshold(confThreshold), cells);
+    }
+    else {
+        cellMarks.assign(grid_len, 0);
+        std::vector<uint32_t> class_cells;
+        for (int k = 0; k < nc; k++) {
+            class_cells.clear();
+            clsDecoder.scan(cls_input + k * grid_len, grid_len, thres, class_cells);
+            for (auto cell : class_cells) {
+                cellMarks[cell] = 1;
+            }
+        }
+        for (int cell = 0; cell < grid_len; cell++) {
+            if (cellMarks[cell]) {
+                cells.push_back(cell);
+            }
+        }
+    }
+
+    for (auto cell : cells) {
+        key_type max_key = clsDecoder.key(cls_input[cell]);
+        int max_id = 0;
+        for (int k = 1; k < nc; k++) {
+            key_type prob = clsDecoder.key(cls_input[k * grid_len + cell]);
+            if (prob > max_key) {
+                max_key = prob;
+                max_id = k;
+            }
+        }
+        if (!(max_key > thres)) {
+            continue;
+        }
+
+        float dist[4];
+        for (int side = 0; side < 4; side++) {
+            dist[side] = dflDistance<Decoder, REG_MAX>(boxDecoder, box_input + side * reg_max * grid_len + cell, grid_len, reg_max);
+        }
+        float cx = (cell % head.grid_w) + 0.5f;
+        float cy = (cell / head.grid_w) + 0.5f;
+        float x1 = (cx - dist[0]) * head.stride;
+        float y1 = (cy - dist[1]) * head.stride;
+        float x2 = (cx + dist[2]) * head.stride;
+        float y2 = (cy + dist[3]) * head.stride;
+        candidates.push(x1, y1, x2 - x1, y2 - y1, clsDecoder.toFloat(cls_input[max_id * grid_len + cell]), max_id);
+    }
+}
+
+/**
+ * @brief Decode one head, dispatching to the kernel specialized for the class count and layout.
+ * @param decoders One element decoder per model output.
+ * @param bufs One buffer per model output.
+ */
+template <typename Decoder>
+void decodeHead(const YoloConfig& config, const YoloHead& head, const std::vector<Decoder>& decoders,
+        const std::vector<const void*>& bufs, float confThreshold, std::vector<uint32_t>& cells,
+        std::vector<uint8_t>& cellMarks, YoloCandidates& candidates) {
+    const int nc = config.num_classes;
+    if (config.family == YoloFamily::ANCHOR_BASED) {
+        const auto& dec = decoders[head.box_output];
+        const void* buf = bufs[head.box_output];
+        switch (nc) {
+        case 1:
+            decodeAnchorHead<Decoder, 1>(dec, buf, head, nc, confThreshold, cells, candidates);
+            break;
+        case 2:
+            decodeAnchorHead<Decoder, 2>(dec, buf, head, nc, confThreshold, cells, candidates);
+            break;
+        case 80:
+            decodeAnchorHead<Decoder, 80>(dec, buf, head, nc, confThreshold, cells, candidates);
+            break;
+        default:
+            decodeAnchorHead<Decoder, 0>(dec, buf, head, nc, confThreshold, cells, candidates);
+            break;
+        }
+        return;
+    }
+
+    const auto& box_dec = decoders[head.box_output];
+    const auto& cls_dec = decoders[head.cls_output];
+    const Decoder* sum_dec = head.sum_output >= 0 ? &decoders[head.sum_output] : nullptr;
+    const void* sum_buf = head.sum_output >= 0 ? bufs[head.sum_output] : nullptr;
+    const void* box_buf = bufs[head.box_output];
+    const void* cls_buf = bufs[head.cls_output];
+    const int rm = config.reg_max;
+    if (rm == 16) {
+        switch (nc) {
+        case 1:
+            decodeDflHead<Decoder, 1, 16>(box_dec, cls_dec, sum_dec, box_buf, cls_buf, sum_buf, head, nc, rm, confThreshold, cells, cellMarks, candidates);
+            break;
+        case 2:
+            decodeDflHead<Decoder, 2, 16>(box_dec, cls_dec, sum_dec, box_buf, cls_buf, sum_buf, head, nc, rm, confThreshold, cells, cellMarks, candidates);
+            break;
+        case 80:
+            decodeDflHead<Decoder, 80, 16>(box_dec, cls_dec, sum_dec, box_buf, cls_buf, sum_buf, head, nc, rm, confThreshold, cells, cellMarks, candidates);
+            break;
+        default:
+            decodeDflHead<Decoder, 0, 16>(box_dec, cls_dec, sum_dec, box_buf, cls_buf, sum_buf, head, nc, rm, confThreshold, cells, cellMarks, candidates);
+            break;
+        }
+        return;
+    }
+    decodeDflHead<Decoder, 0, 0>(box_dec, cls_dec, sum_dec, box_buf, cls_buf, sum_buf, head, nc, rm, confThreshold, cells, cellMarks, candidates);
+}
+
+} // namespace yolo_decoder
+
+} // namespace dnn_algorithm
+
+#endif // __YOLO_DECODER_HPP__
@@ -14,7 +14,6 @@ namespace dnn_algorithm {
 /**
  * TUDO: 
  * 1. Change some of the parameters of the post process functions to member variables.
- * 2. Extract the series of static member functions(such as nms), from the yolov5 class and refactor them into a separate utility class.
  */
 class yolov5 : public IDnnObjDetectorPlugin
 {
@@ -30,47 +29,40 @@ public:
     yolov5() = default;
     ~yolov5() = default;
 
+    int loadLabels(const std::string& labelTextPath) override {
+        return initLabelMap(labelTextPath);
+    }
     int preProcess(ObjDetectParams& params, ObjDetectInput& inputData, IDnnEngine::dnnInput& outputData) override;
     int postProcess(const std::string& labelTextPath, const ObjDetectParams& params,
             std::vector<IDnnEngine::dnnOutput>& inputData, std::vector<ObjDetectOutput>& outputData)  override;
+    bool supportsResults() const override { return true; }
+    int postProcessResults(const ObjDetectParams& params, std::vector<IDnnEngine::dnnOutput>& inputData,
+            ObjDetectResults& outputData) override;
 
 private:
+    // Candidates decoded from one output head
+    struct HeadCandidates {
+        std::vector<float> boxes{};
+        std::vector<float> scores{};
+        std::vector<int> classIds{};
+    };
+
     int initLabelMap(const std::string& labelMapPath);
-    int runPostProcess(const ObjDetectParams& params, std::vector<IDnnEngine::dnnOutput>& inputData,
-            std::vector<ObjDetectOutput>& outputData);
+    // Decode and NMS, <emit> receives every kept box in original image coordinates
+    template <typename Emit>
+    int runPostProcess(const ObjDetectParams& params, std::vector<IDnnEngine::dnnOutput>& inputData, Emit&& emit);
 
     int doProcess(const int idx, const ObjDetectParams& params, int stride, IDnnEngine::dnnOutput& inputData,
         std::vector<float>& bboxes, std::vector<float>& objScores, std::vector<int>& classId);
 
-    static void inverseSortWithIndices(std::vector<float> &input, std::vector<int> &indices);
-
-    static int nms(int validCount, std::vector<float> &filterBoxes, std::vector<int> classIds,
-            std::vector<int> &order, int filterId, float threshold);
+    template <typename Decoder>
+    int decodeHead(const Decoder& decoder, const int idx, const ObjDetectParams& params, int stride, IDnnEngine::dnnOutput& inputData,
+        std::vector<float>& bboxes, std::vector<float>& objScores, std::vector<int>& classId);
 
-    static inline int clamp(float val, int min, int max) {
+    static inline float clamp(float val, float min, float max) {
         return val > min ? (val < max ? val : max) : min;
     }
 
-    template <typename T>
-    static float calculateOverlap(const bboxRect<T>& bbox1, const bboxRect<T>& bbox2) {
-        float w = fmax(0.f, fmin(bbox1.right, bbox2.right) - fmax(bbox1.left, bbox2.left) + 1.0);
-        float h = fmax(0.f, fmin(bbox1.bottom, bbox2.bottom) - fmax(bbox1.top, bbox2.top) + 1.0);
-        float i = w * h;
-        float u = (bbox1.right - bbox1.left + 1.0) * (bbox1.bottom - bbox1.top + 1.0)
-                + (bbox2.right - bbox2.left + 1.0) * (bbox2.bottom - bbox2.top + 1.0) - i;
-
-        return u <= 0.f ? 0.f : (i / u);
-    }
-
-
-    static int8_t qauntFP32ToAffine(float fp32, int8_t zp, float scale);
-
-    static float deqauntAffineToFP32(int8_t qnt, int32_t zp, float scale) { return ((float)qnt - (float)zp) * scale; }
-
-    static inline int32_t clip(int32_t val, int32_t min, int32_t max) {
-        float f = val <= min ? min : (val >= max ? max : val);
-        return f;
-    }
 
 private:
     // YoloPostProcess m_yoloPostProcess;
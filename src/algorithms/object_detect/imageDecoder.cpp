@@ -0,0 +1,118 @@
+#include "imageDecoder.hpp"
+#include <algorithm>
+#include <fstream>
+
+namespace dnn_algorithm {
+
+bool imageDecoder::probeJpegSize(const std::string& imagePath, size_t& width, size_t& height) {
+    std::ifstream file(imagePath, std::ios::binary);
+    if (!file.is_open()) {
+        return false;
+    }
+
+    // SOI marker
+    unsigned char soi[2];
+    if (!file.read(reinterpret_cast<char*>(soi), 2) || soi[0] != 0xFF || soi[1] != 0xD8) {
+        return false;
+    }
+
+    // Walk the marker segments until the first start-of-frame
+    while (file) {
+        unsigned char marker[2];
+        if (!file.read(reinterpret_cast<char*>(marker), 2) || marker[0] != 0xFF) {
+            return false;
+        }
+        while (marker[1] == 0xFF) { // fill bytes
+            if (!file.read(reinterpret_cast<char*>(&marker[1]), 1)) {
+                return false;
+            }
+        }
+
+        unsigned char len_bytes[2];
+        if (!file.read(reinterpret_cast<char*>(len_bytes), 2)) {
+            return false;
+        }
+        size_t segment_len = (static_cast<size_t>(len_bytes[0]) << 8) | len_bytes[1];
+        if (segment_len < 2) {
+            return false;
+        }
+
+        // SOF0..SOF15, except DHT(C4), JPG(C8) and DAC(CC)
+        bool is_sof = marker[1] >= 0xC0 && marker[1] <= 0xCF &&
+                      marker[1] != 0xC4 && marker[1] != 0xC8 && marker[1] != 0xCC;
+        if (is_sof) {
+            unsigned char sof[5]; // precision, height(2), width(2)
+            if (!file.read(reinterpret_cast<char*>(sof), 5)) {
+                return false;
+            }
+            height = (static_cast<size_t>(sof[1]) << 8) | sof[2];
+            width = (static_cast<size_t>(sof[3]) << 8) | sof[4];
+            return width > 0 && height > 0;
+        }
+
+        file.seekg(segment_len - 2, std::ios::cur);
+    }
+    return false;
+}
+
+int imageDecoder::selectDownscale(size_t imageWidth, size_t imageHeight, size_t modelWidth, size_t modelHeight) {
+    if (imageWidth == 0 || imageHeight == 0 || modelWidth == 0 || modelHeight == 0) {
+        return 1;
+    }
+
+    // The letterbox keeps the aspect ratio, so only the limiting dimension has to be covered
+    float letterbox_scale = std::min(static_cast<float>(modelWidth) / imageWidth,
+                                     static_cast<float>(modelHeight) / imageHeight);
+    for (int downscale : {8, 4, 2}) {
+        if (downscale * letterbox_scale <= 1.0f) {
+            return downscale;
+        }
+    }
+    return 1;
+}
+
+int imageDecoder::decode(const std::string& imagePath, size_t modelWidth, size_t modelHeight, DecodedImage& decoded) {
+    size_t width = 0;
+    size_t height = 0;
+    int downscale = 1;
+    if (probeJpegSize(imagePath, width, height)) {
+        downscale = selectDownscale(width, height, modelWidth, modelHeight);
+    }
+
+    int flags = cv::IMREAD_COLOR;
+    switch (downscale) {
+    case 2:
+        flags = cv::IMREAD_REDUCED_COLOR_2;
+        break;
+    case 4:
+        flags = cv::IMREAD_REDUCED_COLOR_4;
+        break;
+    case 8:
+        flags = cv::IMREAD_REDUCED_COLOR_8;
+        break;
+    default:
+        break;
+    }
+
+    auto image = std::make_shared<cv::Mat>(cv::imread(imagePath, flags));
+    if (image->empty()) {
+        return -1;
+    }
+
+    if (downscale == 1) {
+        width = image->cols;
+        height = image->rows;
+    }
+    else if ((image->cols > image->rows) != (width > height) && width != height) {
+        // EXIF orientation was applied by the decoder, the header size is transposed
+        std::swap(width, height);
+    }
+
+    decoded.image = image;
+    decoded.origWidth = width;
+    decoded.origHeight = height;
+    decoded.downscale = downscale;
+    return 0;
+}
+
+} // namespace dnn_algorithm
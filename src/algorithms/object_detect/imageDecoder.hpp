@@ -0,0 +1,54 @@
+#ifndef __IMAGE_DECODER_HPP__
+#define __IMAGE_DECODER_HPP__
+
+#include "IDnnObjDetectorPlugin.hpp"
+#include <opencv2/opencv.hpp>
+#include <memory>
+#include <string>
+
+namespace dnn_algorithm {
+
+/**
+ * @brief Decodes still images at the lowest resolution that still covers the model input.
+ *
+ * JPEG decoders can scale the image down by 1/2, 1/4 or 1/8 while running the inverse DCT,
+ * which is several times cheaper than a full decode followed by cv::resize.
+ * The decoded image is tagged with the reduction factor (ObjDetectInput::decodeDownscale),
+ * so the letterbox in preProcess and the bbox back-projection in postProcess keep working
+ * in the coordinates of the original full-resolution image.
+ */
+class imageDecoder {
+public:
+    struct DecodedImage {
+        std::shared_ptr<cv::Mat> image{nullptr};
+        size_t origWidth{0};  // full-resolution width of the encoded image
+        size_t origHeight{0}; // full-resolution height of the encoded image
+        int downscale{1};     // 1, 2, 4 or 8
+    };
+
+    /**
+     * @brief Decode an image file for a model with the given input size.
+     * @param imagePath Path to the image file.
+     * @param modelWidth Model input width.
+     * @param modelHeight Model input height.
+     * @param[out] decoded The decoded image and its original size.
+     * @return 0 on success, -1 if the image can not be decoded.
+     */
+    static int decode(const std::string& imagePath, size_t modelWidth, size_t modelHeight, DecodedImage& decoded);
+
+    /**
+     * @brief Read the image size from the JPEG header (SOFn marker) without decoding any pixels.
+     * @return true if the file is a JPEG and the size was found.
+     */
+    static bool probeJpegSize(const std::string& imagePath, size_t& width, size_t& height);
+
+    /**
+     * @brief Pick the largest DCT scaling denominator (1, 2, 4, 8) that does not make the
+     * image smaller than the letterboxed content of the model input.
+     */
+    static int selectDownscale(size_t imageWidth, size_t imageHeight, size_t modelWidth, size_t modelHeight);
+};
+
+} // namespace dnn_algorithm
+
+#endif // __IMAGE_DECODER_HPP__
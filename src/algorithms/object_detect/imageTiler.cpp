@@ -0,0 +1,160 @@
+#include "imageTiler.hpp"
+#include "yuvLetterbox.hpp"
+#include <opencv2/opencv.hpp>
+#include <algorithm>
+#include <cmath>
+#include <memory>
+
+namespace dnn_algorithm {
+
+bool imageTiler::getFrameSize(const ObjDetectInput& inputData, size_t& width, size_t& height) {
+    yuv_letterbox::YuvFormat yuv_format;
+    if (yuv_letterbox::parseYuvFormat(inputData.handleType, yuv_format)) {
+        const auto& yuv_image = std::any_cast<const YuvImageHandle&>(inputData.imageHandle);
+        width = yuv_image.width;
+        height = yuv_image.height;
+        return true;
+    }
+
+    if (inputData.handleType.compare("opencv4") == 0) {
+        auto image = std::any_cast<std::shared_ptr<cv::Mat>>(inputData.imageHandle);
+        if (image == nullptr) {
+            return false;
+        }
+        width = image->cols;
+        height = image->rows;
+        return true;
+    }
+    return false;
+}
+
+size_t imageTiler::getFrameBytes(const ObjDetectInput& inputData) {
+    yuv_letterbox::YuvFormat yuv_format;
+    if (yuv_letterbox::parseYuvFormat(inputData.handleType, yuv_format)) {
+        const auto& yuv_image = std::any_cast<const YuvImageHandle&>(inputData.imageHandle);
+        size_t bytes = yuv_image.strides[0] * yuv_image.height;
+        if (yuv_format != yuv_letterbox::YuvFormat::YUYV) {
+            bytes += yuv_image.strides[1] * ((yuv_image.height + 1) / 2);
+        }
+        return bytes;
+    }
+
+    if (inputData.handleType.compare("opencv4") == 0) {
+        auto image = std::any_cast<std::shared_ptr<cv::Mat>>(inputData.imageHandle);
+        return image != nullptr ? image->total() * image->elemSize() : 0;
+    }
+    return 0;
+}
+
+// Tile origins along one axis, the last tile is aligned with the end of the range
+static std::vector<int> tileOrigins(int begin, int end, int tileSize, float overlap) {
+    std::vector<int> origins;
+    if (end - begin <= tileSize) {
+        origins.push_back(begin);
+        return origins;
+    }
+    int step = std::max(1, static_cast<int>(std::lround(tileSize * (1.0f - overlap))));
+    for (int pos = begin; ; pos += step) {
+        if (pos + tileSize >= end) {
+            origins.push_back(end - tileSize);
+            break;
+        }
+        origins.push_back(pos);
+    }
+    return origins;
+}
+
+std::vector<bboxRect<int>> imageTiler::computeTiles(size_t frameWidth, size_t frameHeight,
+        size_t tileWidth, size_t tileHeight, const ObjDetectTileParams& params) {
+    std::vector<bboxRect<int>> tiles;
+    int frame_w = static_cast<int>(frameWidth);
+    int frame_h = static_cast<int>(frameHeight);
+    int tile_w = std::min(frame_w, static_cast<int>(tileWidth));
+    int tile_h = std::min(frame_h, static_cast<int>(tileHeight));
+    if (tile_w <= 0 || tile_h <= 0) {
+        return tiles;
+    }
+    float overlap = std::clamp(params.overlap, 0.0f, 0.9f);
+
+    std::vector<bboxRect<int>> regions = params.roi_regions;
+    if (regions.empty()) {
+        regions.push_back(bboxRect<int>{0, frame_w, 0, frame_h});
+    }
+
+    for (const auto& region : regions) {
+        // Tile each region separately, clamped to the frame; keep even origins for chroma-subsampled frames
+        int left = std::clamp(region.left, 0, frame_w);
+        int right = std::clamp(region.right, 0, frame_w);
+        int top = std::clamp(region.top, 0, frame_h);
+        int bottom = std::clamp(region.bottom, 0, frame_h);
+        if (right <= left || bottom <= top) {
+            continue;
+        }
+        int span_left = std::max(0, std::min(left, right - tile_w));
+        int span_top = std::max(0, std::min(top, bottom - tile_h));
+        int span_right = std::max(right, span_left + tile_w);
+        int span_bottom = std::max(bottom, span_top + tile_h);
+
+        for (int y : tileOrigins(span_top, span_bottom, tile_h, overlap)) {
+            for (int x : tileOrigins(span_left, span_right, tile_w, overlap)) {
+                bboxRect<int> tile{x & ~1, (x & ~1) + tile_w, y & ~1, (y & ~1) + tile_h};
+                bool duplicated = std::any_of(tiles.begin(), tiles.end(), [&tile](const bboxRect<int>& t) {
+                    return t.left == tile.left && t.top == tile.top;
+                });
+                if (!duplicated) {
+                    tiles.push_back(tile);
+                }
+            }
+        }
+    }
+    return tiles;
+}
+
+bool imageTiler::makeTileInput(const ObjDetectInput& inputData, const bboxRect<int>& tile, ObjDetectInput& tileInput,
+        bboxRect<int>& alignedTile) {
+    tileInput.handleType = inputData.handleType;
+    tileInput.decodeDownscale = 1;
+    alignedTile = tile;
+
+    yuv_letterbox::YuvFormat yuv_format;
+    if (yuv_letterbox::parseYuvFormat(inputData.handleType, yuv_format)) {
+        YuvImageHandle yuv_tile = std::any_cast<YuvImageHandle>(inputData.imageHandle);
+        // Keep the tile on whole chroma pairs: even left and width, even top for the 4:2:0 chroma rows
+        size_t x = static_cast<size_t>(tile.left) & ~static_cast<size_t>(1);
+        size_t y = static_cast<size_t>(tile.top);
+        if (yuv_format != yuv_letterbox::YuvFormat::YUYV) {
+            y &= ~static_cast<size_t>(1);
+        }
+        size_t width = (static_cast<size_t>(tile.right) - x) & ~static_cast<size_t>(1);
+        if (tile.right <= tile.left || width == 0 || static_cast<size_t>(tile.bottom) <= y) {
+            return false;
+        }
+        if (yuv_format == yuv_letterbox::YuvFormat::YUYV) {
+            yuv_tile.planes[0] += yuv_tile.strides[0] * y + x * 2;
+        }
+        else {
+            yuv_tile.planes[0] += yuv_tile.strides[0] * y + x;
+            yuv_tile.planes[1] += yuv_tile.strides[1] * (y / 2) + x;
+        }
+        yuv_tile.width = width;
+        yuv_tile.height = tile.bottom - y;
+        tileInput.imageHandle = yuv_tile;
+        alignedTile.left = static_cast<int>(x);
+        alignedTile.right = static_cast<int>(x + width);
+        alignedTile.top = static_cast<int>(y);
+        return true;
+    }
+
+    if (inputData.handleType.compare("opencv4") == 0) {
+        auto image = std::any_cast<std::shared_ptr<cv::Mat>>(inputData.imageHandle);
+        if (image == nullptr) {
+            return false;
+        }
+        cv::Rect roi(tile.left, tile.top, tile.right - tile.left, tile.bottom - tile.top);
+        tileInput.imageHandle = std::make_shared<cv::Mat>((*image)(roi));
+        return true;
+    }
+    return false;
+}
+
+} // namespace dnn_algorithm
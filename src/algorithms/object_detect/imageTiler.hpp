@@ -0,0 +1,55 @@
+#ifndef __IMAGE_TILER_HPP__
+#define __IMAGE_TILER_HPP__
+
+#include "IDnnObjDetectorPlugin.hpp"
+#include <vector>
+
+namespace dnn_algorithm {
+
+struct ObjDetectTileParams {
+    size_t tile_width{0};               // tile size in frame pixels, 0 = model input width
+    size_t tile_height{0};              // tile size in frame pixels, 0 = model input height
+    float overlap{0.2};                 // fraction of the tile shared with its neighbour
+    bool include_full_frame{false};     // also detect on the letterboxed full frame (large objects)
+    float merge_threshold{0.6};         // overlap of the smaller box above which seam duplicates are merged
+    // static regions of interest in frame pixels, tiles outside all of them are not processed;
+    // empty means the whole frame
+    std::vector<bboxRect<int>> roi_regions{};
+};
+
+/**
+ * @brief Splits a frame into overlapping model-sized tiles without copying pixels.
+ * Tiles of BGR frames are cv::Mat ROI headers, tiles of YUV frames are offset plane pointers.
+ */
+class imageTiler {
+public:
+    /**
+     * @brief Get the size of the image held by an ObjDetectInput.
+     * @return false if the handle type is not supported.
+     */
+    static bool getFrameSize(const ObjDetectInput& inputData, size_t& width, size_t& height);
+
+    // Bytes of the image held by an ObjDetectInput, 0 if the handle type is not supported
+    static size_t getFrameBytes(const ObjDetectInput& inputData);
+
+    /**
+     * @brief Compute the tile grid covering the frame (or the ROI regions).
+     * Tile sizes and ROI regions are in the pixels of <frameWidth> x <frameHeight>, dnnObjDetector converts
+     * them from original image pixels for reduced decodes.
+     */
+    static std::vector<bboxRect<int>> computeTiles(size_t frameWidth, size_t frameHeight,
+            size_t tileWidth, size_t tileHeight, const ObjDetectTileParams& params);
+
+    /**
+     * @brief Create the input of one tile, sharing the pixels of the frame.
+     * @param[out] alignedTile The frame region <tileInput> actually covers: YUV tiles start on an even column
+     * (and an even row for NV12/NV21) and have an even width. Scale and offset detections with it.
+     * @return false if the handle type is not supported.
+     */
+    static bool makeTileInput(const ObjDetectInput& inputData, const bboxRect<int>& tile, ObjDetectInput& tileInput,
+            bboxRect<int>& alignedTile);
+};
+
+} // namespace dnn_algorithm
+
+#endif // __IMAGE_TILER_HPP__
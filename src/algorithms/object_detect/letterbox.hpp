@@ -0,0 +1,123 @@
+#ifndef __LETTERBOX_HPP__
+#define __LETTERBOX_HPP__
+
+#include "IDnnObjDetectorPlugin.hpp"
+#include "yuvLetterbox.hpp"
+#include <opencv2/opencv.hpp>
+#include <algorithm>
+#include <any>
+#include <cmath>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+
+namespace dnn_algorithm {
+
+namespace letterbox {
+
+// Fused letterbox of NV12/NV21/YUYV camera frames
+inline int preProcessYuv(ObjDetectParams& params, yuv_letterbox::YuvFormat format, ObjDetectInput& inputData, IDnnEngine::dnnInput& outputData) {
+    auto yuv_image = std::any_cast<YuvImageHandle>(inputData.imageHandle);
+    if (yuv_image.width == 0 || yuv_image.height == 0) {
+        throw std::invalid_argument("inputData.imageHandle is empty.");
+    }
+
+    int target_width = static_cast<int>(params.model_input_width);
+    int target_height = static_cast<int>(params.model_input_height);
+    float min_scale = std::min(params.scale_width, params.scale_height); // params.scale_width = model_input_width/orig_image_width
+    params.scale_width = min_scale;
+    params.scale_height = min_scale;
+    int resized_width = std::min(target_width, static_cast<int>(std::lround(yuv_image.width * min_scale)));
+    int resized_height = std::min(target_height, static_cast<int>(std::lround(yuv_image.height * min_scale)));
+
+    int pad_width = target_width - resized_width;
+    int pad_height = target_height - resized_height;
+    params.pads.left = pad_width / 2;
+    params.pads.right = pad_width - params.pads.left;
+    params.pads.top = pad_height / 2;
+    params.pads.bottom = pad_height - params.pads.top;
+
+    outputData.index = 0;
+    outputData.shape.width = params.model_input_width;
+    outputData.shape.height = params.model_input_height;
+    outputData.shape.channel = params.model_input_channel;
+    outputData.size = static_cast<size_t>(target_width) * target_height * 3;
+    if (outputData.buf.size() != outputData.size) {
+        outputData.buf.resize(outputData.size);
+    }
+    outputData.dataType = "UINT8";
+    return yuv_letterbox::convertToLetterboxRgb(yuv_image, format, outputData.buf.data(), target_width, target_height,
+            resized_width, resized_height, params.pads.left, params.pads.top);
+}
+
+/**
+ * Letterbox pre-processing of the YOLO family: BGR (opencv4) or YUV camera frames are resized
+ * with the aspect ratio kept, padded with grey and written as packed RGB into <outputData>.
+ * Updates the scale and pads of <params> for the bbox back-projection.
+ */
+inline int preProcess(ObjDetectParams& params, ObjDetectInput& inputData, IDnnEngine::dnnInput& outputData) {
+    // Camera frames are converted and letterboxed in one pass
+    yuv_letterbox::YuvFormat yuv_format;
+    if (yuv_letterbox::parseYuvFormat(inputData.handleType, yuv_format)) {
+        return preProcessYuv(params, yuv_format, inputData, outputData);
+    }
+
+    // Otherwise only BGR images in OpenCV 4 format are processed
+    if (inputData.handleType.compare("opencv4") != 0) {
+        throw std::invalid_argument("Only opencv4, nv12, nv21 and yuyv are supported.");
+    }
+
+    auto orig_image_ptr = std::any_cast<std::shared_ptr<cv::Mat>>(inputData.imageHandle);
+    if (orig_image_ptr == nullptr) {
+        throw std::invalid_argument("inputData.imageHandle is nullptr.");
+    }
+    cv::Mat orig_image = *orig_image_ptr;
+    cv::Mat rgb_image;
+    cv::cvtColor(orig_image, rgb_image, cv::COLOR_BGR2RGB);
+
+    // Resize the original image to match the model input dimensions
+    cv::Size target_size(params.model_input_width, params.model_input_height);
+    cv::Mat padded_image(target_size.height, target_size.width, CV_8UC3);
+    float min_scale = std::min(params.scale_width, params.scale_height); // params.scale_width = model_input_width/orig_image_width
+    params.scale_width = min_scale;
+    params.scale_height = min_scale;
+    cv::Mat resized_image;
+    if (inputData.decodeDownscale > 1) {
+        // The image was decoded at reduced resolution, scale it relative to the original image size
+        float resize_scale = min_scale * inputData.decodeDownscale;
+        int resized_width = std::min(target_size.width, static_cast<int>(std::lround(rgb_image.cols * resize_scale)));
+        int resized_height = std::min(target_size.height, static_cast<int>(std::lround(rgb_image.rows * resize_scale)));
+        cv::resize(rgb_image, resized_image, cv::Size(resized_width, resized_height));
+    }
+    else {
+        cv::resize(rgb_image, resized_image, cv::Size(), min_scale, min_scale);
+    }
+
+    // Pad the resized image with gray to match the model input size along the insufficient dimension
+    int pad_width = target_size.width - resized_image.cols;
+    int pad_height = target_size.height - resized_image.rows;
+    params.pads.left = pad_width / 2;
+    params.pads.right = pad_width - params.pads.left;
+    params.pads.top = pad_height / 2;
+    params.pads.bottom = pad_height - params.pads.top;
+    cv::copyMakeBorder(resized_image, padded_image, params.pads.top, params.pads.bottom, params.pads.left, params.pads.right, cv::BORDER_CONSTANT, cv::Scalar(128, 128, 128));
+
+    // The output of the preprocessing is the image resized and padded to match the model input size
+    outputData.index = 0;
+    outputData.shape.width = params.model_input_width;
+    outputData.shape.height = params.model_input_height;
+    outputData.shape.channel = params.model_input_channel;
+    outputData.size = padded_image.total() * padded_image.elemSize();
+    if (outputData.buf.size() != outputData.size) {
+        outputData.buf.resize(outputData.size);
+    }
+    outputData.dataType = "UINT8";
+    std::memcpy(outputData.buf.data(), padded_image.data, outputData.size);
+    return 0;
+}
+
+} // namespace letterbox
+
+} // namespace dnn_algorithm
+
+#endif // __LETTERBOX_HPP__
@@ -0,0 +1,141 @@
+#include "motionGate.hpp"
+#include "yuvLetterbox.hpp"
+#include <opencv2/opencv.hpp>
+#include <algorithm>
+#include <cmath>
+#include <memory>
+
+namespace dnn_algorithm {
+
+motionGate::motionGate(const MotionGateParams& params) : m_params{params} {
+    m_params.analysis_width = std::max(8, m_params.analysis_width);
+    m_params.background_rate = std::clamp(m_params.background_rate, 0.0f, 1.0f);
+}
+
+void motionGate::reset() {
+    m_frameWidth = 0;
+    m_frameHeight = 0;
+    m_background.clear();
+    m_framesSinceProcessed = 0;
+}
+
+void motionGate::buildMask() {
+    m_mask.assign(static_cast<size_t>(m_thumbWidth) * m_thumbHeight, m_params.include_regions.empty() ? 1 : 0);
+
+    auto fill = [this](const bboxRect<float>& region, uint8_t value) {
+        int x0 = std::max(0, static_cast<int>(std::floor(region.left * m_thumbWidth)));
+        int x1 = std::min(m_thumbWidth, static_cast<int>(std::ceil(region.right * m_thumbWidth)));
+        int y0 = std::max(0, static_cast<int>(std::floor(region.top * m_thumbHeight)));
+        int y1 = std::min(m_thumbHeight, static_cast<int>(std::ceil(region.bottom * m_thumbHeight)));
+        for (int y = y0; y < y1; y++) {
+            std::fill(m_mask.begin() + y * m_thumbWidth + x0, m_mask.begin() + y * m_thumbWidth + x1, value);
+        }
+    };
+
+    for (const auto& region : m_params.include_regions) {
+        fill(region, 1);
+    }
+    for (const auto& region : m_params.exclude_regions) {
+        fill(region, 0);
+    }
+    m_maskedPixels = std::count(m_mask.begin(), m_mask.end(), 1);
+}
+
+bool motionGate::sampleLuma(const ObjDetectInput& inputData) {
+    size_t width = 0;
+    size_t height = 0;
+    std::shared_ptr<cv::Mat> bgr_image{nullptr};
+    YuvImageHandle yuv_image;
+    yuv_letterbox::YuvFormat yuv_format;
+    bool is_yuv = yuv_letterbox::parseYuvFormat(inputData.handleType, yuv_format);
+
+    if (is_yuv) {
+        yuv_image = std::any_cast<YuvImageHandle>(inputData.imageHandle);
+        // the luma plane is read through planes[0] and strides[0], reject frames that cannot back them
+        if (yuv_image.planes[0] == nullptr || (yuv_format != yuv_letterbox::YuvFormat::YUYV && yuv_image.planes[1] == nullptr)
+                || !yuv_letterbox::isValidFrame(yuv_image, yuv_format)) {
+            return false;
+        }
+        width = yuv_image.width;
+        height = yuv_image.height;
+    }
+    else if (inputData.handleType.compare("opencv4") == 0) {
+        bgr_image = std::any_cast<std::shared_ptr<cv::Mat>>(inputData.imageHandle);
+        if (bgr_image == nullptr || bgr_image->empty()) {
+            return false;
+        }
+        width = bgr_image->cols;
+        height = bgr_image->rows;
+    }
+    else {
+        return false;
+    }
+
+    if (width == 0 || height == 0) {
+        return false;
+    }
+
+    if (width != m_frameWidth || height != m_frameHeight) {
+        // New stream geometry: restart the background model
+        m_frameWidth = width;
+        m_frameHeight = height;
+        m_thumbWidth = std::min(static_cast<int>(width), m_params.analysis_width);
+        m_thumbHeight = std::max(1, static_cast<int>(std::lround(static_cast<double>(height) * m_thumbWidth / width)));
+        m_luma.resize(static_cast<size_t>(m_thumbWidth) * m_thumbHeight);
+        m_background.clear();
+        buildMask();
+    }
+
+    for (int ty = 0; ty < m_thumbHeight; ty++) {
+        size_t sy = (static_cast<size_t>(ty) * 2 + 1) * height / (m_thumbHeight * 2);
+        uint8_t* dst = m_luma.data() + static_cast<size_t>(ty) * m_thumbWidth;
+        for (int tx = 0; tx < m_thumbWidth; tx++) {
+            size_t sx = (static_cast<size_t>(tx) * 2 + 1) * width / (m_thumbWidth * 2);
+            if (is_yuv) {
+                const uint8_t* row = yuv_image.planes[0] + yuv_image.strides[0] * sy;
+                dst[tx] = yuv_format == yuv_letterbox::YuvFormat::YUYV ? row[sx * 2] : row[sx];
+            }
+            else {
+                const uint8_t* px = bgr_image->ptr<uint8_t>(static_cast<int>(sy)) + sx * 3;
+                dst[tx] = static_cast<uint8_t>((29 * px[0] + 150 * px[1] + 77 * px[2]) >> 8);
+            }
+        }
+    }
+    return true;
+}
+
+bool motionGate::checkFrame(const ObjDetectInput& inputData) {
+    if (!sampleLuma(inputData)) {
+        // Unknown or invalid input, never gate it: the detector reports the error
+        return true;
+    }
+
+    if (m_background.empty()) {
+        m_background.assign(m_luma.begin(), m_luma.end());
+        m_framesSinceProcessed = 0;
+        return true;
+    }
+
+    size_t changed = 0;
+    const float rate = m_params.background_rate;
+    for (size_t i = 0; i < m_luma.size(); i++) {
+        float diff = m_luma[i] - m_background[i];
+        if (m_mask[i] && std::fabs(diff) > m_params.pixel_threshold) {
+            changed++;
+        }
+        m_background[i] += rate * diff;
+    }
+
+    bool motion = m_maskedPixels > 0 && changed >= std::max<size_t>(1, static_cast<size_t>(m_params.changed_ratio * m_maskedPixels));
+    bool skip_limit = m_params.max_skip_frames > 0 && m_framesSinceProcessed >= m_params.max_skip_frames;
+    if (motion || skip_limit) {
+        m_framesSinceProcessed = 0;
+        return true;
+    }
+
+    m_framesSinceProcessed++;
+    m_skippedFrames++;
+    return false;
+}
+
+} // namespace dnn_algorithm
@@ -0,0 +1,62 @@
+#ifndef __MOTION_GATE_HPP__
+#define __MOTION_GATE_HPP__
+
+#include "IDnnObjDetectorPlugin.hpp"
+#include <cstdint>
+#include <vector>
+
+namespace dnn_algorithm {
+
+struct MotionGateParams {
+    int analysis_width{64};             // width of the downscaled luma copy, the height keeps the aspect ratio
+    int pixel_threshold{20};            // luma difference to the background that marks a pixel as changed
+    float changed_ratio{0.003};         // fraction of changed pixels (inside the mask) that counts as motion
+    int max_skip_frames{25};            // force a detection after this many skipped frames, 0 = no limit
+    float background_rate{0.05};        // running-average background update rate, 1.0 = previous frame difference
+    // regions in normalized [0, 1] frame coordinates
+    std::vector<bboxRect<float>> include_regions{}; // empty means the whole frame
+    std::vector<bboxRect<float>> exclude_regions{};
+};
+
+/**
+ * @brief Cheap pre-inference gate that detects static scenes.
+ *
+ * Compares a heavily downscaled luma copy of each frame against a running-average
+ * background model. Only nearest-neighbour samples of the frame are read, so the cost is
+ * independent of the input resolution; YUV frames are sampled straight from the Y plane.
+ */
+class motionGate {
+public:
+    explicit motionGate(const MotionGateParams& params = MotionGateParams{});
+
+    /**
+     * @brief Update the background model with the frame.
+     * @return true if the frame has to be processed (scene changed, first frame, skip limit reached, or an unsupported or invalid frame).
+     */
+    bool checkFrame(const ObjDetectInput& inputData);
+
+    void reset();
+
+    size_t getSkippedFrames() const { return m_skippedFrames; }
+
+private:
+    bool sampleLuma(const ObjDetectInput& inputData);
+    void buildMask();
+
+private:
+    MotionGateParams m_params;
+    size_t m_frameWidth{0};
+    size_t m_frameHeight{0};
+    int m_thumbWidth{0};
+    int m_thumbHeight{0};
+    std::vector<uint8_t> m_luma;
+    std::vector<float> m_background;
+    std::vector<uint8_t> m_mask;
+    size_t m_maskedPixels{0};
+    int m_framesSinceProcessed{0};
+    size_t m_skippedFrames{0};
+};
+
+} // namespace dnn_algorithm
+
+#endif // __MOTION_GATE_HPP__
@@ -0,0 +1,217 @@
+#ifndef __NATIVE_INPUT_HPP__
+#define __NATIVE_INPUT_HPP__
+
+#include "IDnnObjDetectorPlugin.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace dnn_algorithm {
+
+// The normalization the model was converted with (mean_values / std_values of the conversion config), RGB order
+struct NativeInputParams {
+    float mean[3]{0.f, 0.f, 0.f};
+    float std[3]{1.f, 1.f, 1.f};
+};
+
+/**
+ * @brief Converts the packed RGB (HWC, uint8) output of the plugin pre-processing into the native input tensor
+ * of the engine (IDnnEngine::getInputDesc), which is then submitted with dnnInput::passThrough.
+ *
+ * Normalization and quantization of a uint8 channel value only have 256 outcomes, they are tabulated once per
+ * model; the per-frame work is one table lookup and one store per element, in the target layout (NHWC with row
+ * stride, NCHW or NC1HWC2). This replaces the conversion the runtime would otherwise run on the CPU.
+ * convert() only reads the tables, it can run on several threads.
+ */
+class nativeInputConverter {
+public:
+    nativeInputConverter(const IDnnEngine::dnnInputDesc& desc, const NativeInputParams& params) : m_desc{desc} {
+        if (m_desc.layout == "NC1HWC2" && m_desc.dims.size() == 5) {
+            m_height = m_desc.dims[2];
+            m_width = m_desc.dims[3];
+            m_c2 = m_desc.dims[4];
+            // a 3-channel image fits in a single C1 block
+            m_channel = m_desc.dims[1] == 1 && m_c2 >= 3 ? 3 : 0;
+        }
+        else if (m_desc.layout == "NCHW" && m_desc.dims.size() == 4) {
+            m_channel = m_desc.dims[1];
+            m_height = m_desc.dims[2];
+            m_width = m_desc.dims[3];
+        }
+        else if (m_desc.layout == "NHWC" && m_desc.dims.size() == 4) {
+            m_height = m_desc.dims[1];
+            m_width = m_desc.dims[2];
+            m_channel = m_desc.dims[3];
+        }
+        m_stride = m_desc.layout != "NCHW" && m_desc.widthStride > m_width ? m_desc.widthStride : m_width;
+
+        if (m_desc.dataType == "UINT8" || m_desc.dataType == "INT8") {
+            m_elemSize = 1;
+        }
+        else if (m_desc.dataType == "FP16") {
+            m_elemSize = 2;
+        }
+        else if (m_desc.dataType == "FP32") {
+            m_elemSize = 4;
+        }
+        if (!isValid()) {
+            return;
+        }
+
+        // value of a padding element: real 0
+        float zero_value = 0.f;
+        encode(zero_value, m_zero);
+        m_table.resize(3 * 256 * m_elemSize);
+        for (size_t c = 0; c < 3; c++) {
+            for (int v = 0; v < 256; v++) {
+                float real = (static_cast<float>(v) - params.mean[c]) / params.std[c];
+                encode(real, &m_table[(c * 256 + v) * m_elemSize]);
+            }
+        }
+    }
+
+    // The lookup table and the scratch tensor of one converting thread
+    size_t getMemoryBytes() const {
+        return m_table.capacity() + m_desc.size;
+    }
+
+    // false if the engine's input is not a 3-channel image tensor this converter can produce
+    bool isValid() const {
+        size_t pixel_elements = m_c2 > 0 ? m_c2 : 3;
+        return m_elemSize > 0 && m_channel == 3 && m_width > 0 && m_height > 0
+                && m_desc.size >= m_height * m_stride * pixel_elements * m_elemSize;
+    }
+
+    /**
+     * @brief Convert <tensor> in place, <scratch> keeps the previous buffer for reuse.
+     * @return 0 on success (tensor.passThrough set), -1 if <tensor> is not a packed RGB image of the model size.
+     */
+    int convert(IDnnEngine::dnnInput& tensor, std::vector<uint8_t>& scratch) const {
+        if (!isValid() || tensor.passThrough || tensor.dataType != "UINT8"
+                || tensor.buf.size() < m_width * m_height * 3) {
+            return -1;
+        }
+        scratch.resize(m_desc.size);
+        switch (m_elemSize) {
+            case 1: scatter<uint8_t>(tensor.buf.data(), scratch.data()); break;
+            case 2: scatter<uint16_t>(tensor.buf.data(), scratch.data()); break;
+            default: scatter<uint32_t>(tensor.buf.data(), scratch.data()); break;
+        }
+        tensor.buf.swap(scratch);
+        tensor.size = m_desc.size;
+        tensor.dataType = m_desc.dataType;
+        tensor.passThrough = true;
+        return 0;
+    }
+
+private:
+    static uint16_t toHalf(float value) {
+        uint32_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        uint32_t sign = (bits >> 16) & 0x8000;
+        int32_t exponent = static_cast<int32_t>((bits >> 23) & 0xff) - 127 + 15;
+        uint32_t mantissa = bits & 0x7fffff;
+        if (exponent <= 0) {
+            // subnormal or zero
+            if (exponent < -10) {
+                return static_cast<uint16_t>(sign);
+            }
+            mantissa |= 0x800000;
+            uint32_t shift = static_cast<uint32_t>(14 - exponent);
+            uint32_t half = mantissa >> shift;
+            uint32_t rest = mantissa & ((1u << shift) - 1);
+            uint32_t midpoint = 1u << (shift - 1);
+            half += rest > midpoint || (rest == midpoint && (half & 1)) ? 1 : 0;
+            return static_cast<uint16_t>(sign | half);
+        }
+        if (exponent >= 31) {
+            return static_cast<uint16_t>(sign | 0x7c00);
+        }
+        uint32_t half = (static_cast<uint32_t>(exponent) << 10) | (mantissa >> 13);
+        uint32_t rest = mantissa & 0x1fff;
+        // round to nearest even, a carry into the exponent is the correct result
+        half += rest > 0x1000 || (rest == 0x1000 && (half & 1)) ? 1 : 0;
+        return static_cast<uint16_t>(sign | half);
+    }
+
+    void encode(float real, uint8_t* dst) const {
+        if (m_desc.dataType == "UINT8" || m_desc.dataType == "INT8") {
+            bool is_signed = m_desc.dataType == "INT8";
+            float q = std::nearbyint(real / m_desc.scale) + static_cast<float>(m_desc.zeroPoint);
+            float low = is_signed ? -128.f : 0.f;
+            float high = is_signed ? 127.f : 255.f;
+            int value = static_cast<int>(std::min(high, std::max(low, q)));
+            dst[0] = static_cast<uint8_t>(value);
+        }
+        else if (m_desc.dataType == "FP16") {
+            uint16_t half = toHalf(real);
+            std::memcpy(dst, &half, sizeof(half));
+        }
+        else {
+            std::memcpy(dst, &real, sizeof(real));
+        }
+    }
+
+    template <typename T>
+    void scatter(const uint8_t* rgb, uint8_t* out) const {
+        const T* table = reinterpret_cast<const T*>(m_table.data());
+        T zero;
+        std::memcpy(&zero, m_zero, sizeof(T));
+        T* dst = reinterpret_cast<T*>(out);
+        size_t elements = m_desc.size / sizeof(T);
+
+        if (m_desc.layout == "NHWC") {
+            if (m_stride != m_width) {
+                std::fill(dst, dst + elements, zero);
+            }
+            for (size_t y = 0; y < m_height; y++) {
+                const uint8_t* src = rgb + y * m_width * 3;
+                T* row = dst + y * m_stride * 3;
+                for (size_t x = 0; x < m_width * 3; x += 3) {
+                    row[x + 0] = table[src[x + 0]];
+                    row[x + 1] = table[256 + src[x + 1]];
+                    row[x + 2] = table[512 + src[x + 2]];
+                }
+            }
+        }
+        else if (m_desc.layout == "NCHW") {
+            for (size_t c = 0; c < 3; c++) {
+                const T* channel_table = table + c * 256;
+                T* plane = dst + c * m_height * m_width;
+                for (size_t i = 0; i < m_height * m_width; i++) {
+                    plane[i] = channel_table[rgb[i * 3 + c]];
+                }
+            }
+        }
+        else {
+            // NC1HWC2 with 3 channels: one C1 block, C2 elements per pixel of which the first 3 are used
+            std::fill(dst, dst + elements, zero);
+            for (size_t y = 0; y < m_height; y++) {
+                const uint8_t* src = rgb + y * m_width * 3;
+                T* row = dst + y * m_stride * m_c2;
+                for (size_t x = 0; x < m_width; x++) {
+                    row[x * m_c2 + 0] = table[src[x * 3 + 0]];
+                    row[x * m_c2 + 1] = table[256 + src[x * 3 + 1]];
+                    row[x * m_c2 + 2] = table[512 + src[x * 3 + 2]];
+                }
+            }
+        }
+    }
+
+private:
+    IDnnEngine::dnnInputDesc m_desc;
+    size_t m_width{0};
+    size_t m_height{0};
+    size_t m_channel{0};
+    size_t m_stride{0};
+    size_t m_c2{0};
+    size_t m_elemSize{0};
+    uint8_t m_zero[4]{};
+    std::vector<uint8_t> m_table{};
+};
+
+} // namespace dnn_algorithm
+
+#endif // __NATIVE_INPUT_HPP__
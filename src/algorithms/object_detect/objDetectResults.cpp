@@ -0,0 +1,167 @@
+#include "objDetectResults.hpp"
+#include <cstring>
+#include <fstream>
+
+namespace dnn_algorithm {
+
+namespace {
+
+constexpr uint32_t RESULTS_MAGIC = 0x53524E44; // "DNRS"
+constexpr uint32_t RESULTS_VERSION = 1;
+
+#pragma pack(push, 1)
+struct ResultsHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t count;
+    uint32_t dropped;
+    uint64_t labelTableHash;
+};
+#pragma pack(pop)
+
+constexpr size_t FLOAT_COLUMNS = 5;
+constexpr size_t INT_COLUMNS = 2;
+
+template <typename T>
+uint8_t* writeColumn(uint8_t* dst, const std::vector<T>& column, size_t count) {
+    std::memcpy(dst, column.data(), count * sizeof(T));
+    return dst + count * sizeof(T);
+}
+
+template <typename T>
+const uint8_t* readColumn(const uint8_t* src, std::vector<T>& column, size_t count) {
+    std::memcpy(column.data(), src, count * sizeof(T));
+    return src + count * sizeof(T);
+}
+
+} // namespace
+
+std::shared_ptr<const LabelTable> LabelTable::fromFile(const std::string& path) {
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        return nullptr;
+    }
+    std::vector<std::string> labels;
+    std::string line;
+    while (std::getline(file, line)) {
+        if (!line.empty() && line.back() == '\r') {
+            line.pop_back();
+        }
+        labels.push_back(line);
+    }
+    return std::make_shared<const LabelTable>(labels);
+}
+
+LabelTable::LabelTable(const std::vector<std::string>& labels) {
+    size_t total = 0;
+    for (const auto& label : labels) {
+        total += label.size();
+    }
+    // The views are taken once the buffer is complete, it never reallocates afterwards
+    m_storage.reserve(total);
+    for (const auto& label : labels) {
+        m_storage += label;
+    }
+
+    m_hash = 0xcbf29ce484222325ull;
+    size_t offset = 0;
+    m_labels.reserve(labels.size());
+    for (size_t i = 0; i < labels.size(); i++) {
+        std::string_view view(m_storage.data() + offset, labels[i].size());
+        offset += labels[i].size();
+        m_labels.push_back(view);
+        m_ids.emplace(view, static_cast<int>(i));
+        for (char c : view) {
+            m_hash = (m_hash ^ static_cast<uint8_t>(c)) * 0x100000001b3ull;
+        }
+        m_hash = (m_hash ^ '\n') * 0x100000001b3ull;
+    }
+}
+
+ObjDetectResults::ObjDetectResults(size_t capacity) {
+    reserve(capacity);
+}
+
+void ObjDetectResults::reserve(size_t capacity) {
+    m_capacity = capacity;
+    m_left.resize(capacity);
+    m_top.resize(capacity);
+    m_right.resize(capacity);
+    m_bottom.resize(capacity);
+    m_score.resize(capacity);
+    m_classId.resize(capacity);
+    m_trackId.resize(capacity);
+}
+
+void ObjDetectResults::append(const std::vector<ObjDetectOutput>& outputs) {
+    for (const auto& output : outputs) {
+        int class_id = output.classId;
+        if (class_id < 0 && m_labelTable != nullptr) {
+            class_id = m_labelTable->find(output.label);
+        }
+        push(static_cast<float>(output.bbox.left), static_cast<float>(output.bbox.top),
+             static_cast<float>(output.bbox.right), static_cast<float>(output.bbox.bottom),
+             output.score, class_id, output.trackId);
+    }
+}
+
+void ObjDetectResults::append(const ObjDetectResults& other) {
+    for (size_t i = 0; i < other.m_size; i++) {
+        push(other.m_left[i], other.m_top[i], other.m_right[i], other.m_bottom[i],
+             other.m_score[i], other.m_classId[i], other.m_trackId[i]);
+    }
+    m_dropped += other.m_dropped;
+}
+
+size_t ObjDetectResults::serializedSize() const {
+    return sizeof(ResultsHeader) + m_size * (FLOAT_COLUMNS * sizeof(float) + INT_COLUMNS * sizeof(int32_t));
+}
+
+size_t ObjDetectResults::serialize(uint8_t* buffer, size_t size) const {
+    size_t total = serializedSize();
+    if (buffer == nullptr || size < total) {
+        return 0;
+    }
+    ResultsHeader header{RESULTS_MAGIC, RESULTS_VERSION, static_cast<uint32_t>(m_size), static_cast<uint32_t>(m_dropped),
+        m_labelTable != nullptr ? m_labelTable->hash() : 0};
+    std::memcpy(buffer, &header, sizeof(header));
+    uint8_t* dst = buffer + sizeof(header);
+    dst = writeColumn(dst, m_left, m_size);
+    dst = writeColumn(dst, m_top, m_size);
+    dst = writeColumn(dst, m_right, m_size);
+    dst = writeColumn(dst, m_bottom, m_size);
+    dst = writeColumn(dst, m_score, m_size);
+    dst = writeColumn(dst, m_classId, m_size);
+    writeColumn(dst, m_trackId, m_size);
+    return total;
+}
+
+bool ObjDetectResults::deserialize(const uint8_t* buffer, size_t size, uint64_t& labelTableHash) {
+    ResultsHeader header;
+    if (buffer == nullptr || size < sizeof(header)) {
+        return false;
+    }
+    std::memcpy(&header, buffer, sizeof(header));
+    size_t count = header.count;
+    if (header.magic != RESULTS_MAGIC || header.version != RESULTS_VERSION
+            || size < sizeof(header) + count * (FLOAT_COLUMNS * sizeof(float) + INT_COLUMNS * sizeof(int32_t))) {
+        return false;
+    }
+    if (count > m_capacity) {
+        reserve(count);
+    }
+    const uint8_t* src = buffer + sizeof(header);
+    src = readColumn(src, m_left, count);
+    src = readColumn(src, m_top, count);
+    src = readColumn(src, m_right, count);
+    src = readColumn(src, m_bottom, count);
+    src = readColumn(src, m_score, count);
+    src = readColumn(src, m_classId, count);
+    readColumn(src, m_trackId, count);
+    m_size = count;
+    m_dropped = header.dropped;
+    labelTableHash = header.labelTableHash;
+    return true;
+}
+
+} // namespace dnn_algorithm
@@ -0,0 +1,161 @@
+#ifndef __OBJDETECT_RESULTS_HPP__
+#define __OBJDETECT_RESULTS_HPP__
+
+#include "IDnnObjDetectorPlugin.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace dnn_algorithm {
+
+/**
+ * Interned class labels of a model: all labels live in one buffer, lookups return string_views into it.
+ * Immutable once built and shared as std::shared_ptr<const LabelTable>, so views stay valid as long as
+ * a holder of the table exists.
+ */
+class LabelTable {
+public:
+    // One label per line, nullptr if the file cannot be read
+    static std::shared_ptr<const LabelTable> fromFile(const std::string& path);
+
+    explicit LabelTable(const std::vector<std::string>& labels);
+
+    LabelTable(const LabelTable&) = delete;
+    LabelTable& operator=(const LabelTable&) = delete;
+
+    size_t size() const { return m_labels.size(); }
+
+    // Empty view for an unknown class id
+    std::string_view label(int classId) const {
+        return classId >= 0 && static_cast<size_t>(classId) < m_labels.size() ? m_labels[classId] : std::string_view{};
+    }
+
+    // -1 if the label is not in the table
+    int find(std::string_view label) const {
+        auto it = m_ids.find(label);
+        return it != m_ids.end() ? it->second : -1;
+    }
+
+    // Content hash, identifies the table on the other side of a process boundary
+    uint64_t hash() const { return m_hash; }
+
+    // Label storage, views and the lookup map (node and bucket estimate)
+    size_t getMemoryBytes() const {
+        return m_storage.capacity() + m_labels.capacity() * sizeof(std::string_view)
+            + m_ids.size() * (sizeof(std::pair<const std::string_view, int>) + 2 * sizeof(void*))
+            + m_ids.bucket_count() * sizeof(void*);
+    }
+
+private:
+    std::string m_storage{};
+    std::vector<std::string_view> m_labels{};
+    std::unordered_map<std::string_view, int> m_ids{};
+    uint64_t m_hash{0};
+};
+
+/**
+ * Detections of one frame in structure-of-arrays layout.
+ *
+ * The columns are allocated once for a fixed capacity and reused across frames; boxes beyond the
+ * capacity are counted in getDropped(). Labels are not stored, they resolve through the LabelTable
+ * of the model that produced the results. serialize() writes a flat little-endian block (header and
+ * columns) for shared memory or sockets, the receiver checks the table hash against its own table.
+ */
+class ObjDetectResults {
+public:
+    static constexpr size_t DEFAULT_CAPACITY = 256;
+
+    explicit ObjDetectResults(size_t capacity = DEFAULT_CAPACITY);
+
+    size_t size() const { return m_size; }
+    size_t capacity() const { return m_capacity; }
+    bool empty() const { return m_size == 0; }
+    size_t getDropped() const { return m_dropped; }
+
+    // Keeps the capacity and the label table
+    void clear() {
+        m_size = 0;
+        m_dropped = 0;
+    }
+
+    // Returns false (and counts the box as dropped) when the container is full
+    bool push(float left, float top, float right, float bottom, float score, int classId, int trackId = -1) {
+        if (m_size == m_capacity) {
+            m_dropped++;
+            return false;
+        }
+        m_left[m_size] = left;
+        m_top[m_size] = top;
+        m_right[m_size] = right;
+        m_bottom[m_size] = bottom;
+        m_score[m_size] = score;
+        m_classId[m_size] = classId;
+        m_trackId[m_size] = trackId;
+        m_size++;
+        return true;
+    }
+
+    // Columns, size() entries each
+    const float* left() const { return m_left.data(); }
+    const float* top() const { return m_top.data(); }
+    const float* right() const { return m_right.data(); }
+    const float* bottom() const { return m_bottom.data(); }
+    const float* score() const { return m_score.data(); }
+    const int32_t* classId() const { return m_classId.data(); }
+    const int32_t* trackId() const { return m_trackId.data(); }
+
+    void setLabelTable(std::shared_ptr<const LabelTable> labelTable) { m_labelTable = std::move(labelTable); }
+    const std::shared_ptr<const LabelTable>& getLabelTable() const { return m_labelTable; }
+
+    // Empty view without a table or for an unknown class id
+    std::string_view label(size_t index) const {
+        return m_labelTable != nullptr ? m_labelTable->label(m_classId[index]) : std::string_view{};
+    }
+
+    // Append the outputs of the array-of-structs API, classId -1 is resolved through the label table
+    void append(const std::vector<ObjDetectOutput>& outputs);
+
+    // Append the boxes of <other>, its label table is not taken over
+    void append(const ObjDetectResults& other);
+
+    size_t serializedSize() const;
+
+    // The columns, allocated for capacity() boxes
+    size_t getMemoryBytes() const {
+        return m_capacity * (5 * sizeof(float) + 2 * sizeof(int32_t));
+    }
+
+    // @return bytes written, 0 if <size> is too small
+    size_t serialize(uint8_t* buffer, size_t size) const;
+
+    /**
+     * @brief Read a block written by serialize(), the capacity grows if needed.
+     * @param labelTableHash[out] Hash of the writer's label table, 0 if it had none.
+     * @return false if the block is malformed.
+     */
+    bool deserialize(const uint8_t* buffer, size_t size, uint64_t& labelTableHash);
+
+private:
+    void reserve(size_t capacity);
+
+private:
+    size_t m_capacity{0};
+    size_t m_size{0};
+    size_t m_dropped{0};
+    std::vector<float> m_left{};
+    std::vector<float> m_top{};
+    std::vector<float> m_right{};
+    std::vector<float> m_bottom{};
+    std::vector<float> m_score{};
+    std::vector<int32_t> m_classId{};
+    std::vector<int32_t> m_trackId{};
+    std::shared_ptr<const LabelTable> m_labelTable{nullptr};
+};
+
+} // namespace dnn_algorithm
+
+#endif // __OBJDETECT_RESULTS_HPP__
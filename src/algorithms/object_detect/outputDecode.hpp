@@ -0,0 +1,252 @@
+#ifndef __OUTPUT_DECODE_HPP__
+#define __OUTPUT_DECODE_HPP__
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+#if defined(__aarch64__) && defined(__ARM_NEON)
+#include <arm_neon.h>
+#define OUTPUT_DECODE_USE_NEON 1
+#endif
+
+namespace dnn_algorithm {
+
+/**
+ * Helpers shared by the detector plugins to decode raw output tensors.
+ * The scan functions look for the grid cells whose confidence passes the threshold; they run
+ * 16 (int8), 8 (fp16) or 4 (fp32) lanes at a time with NEON on aarch64, and most cells are
+ * rejected without leaving the vector loop. Other targets use the scalar loop.
+ */
+namespace output_decode {
+
+enum class OutputType {
+    INT8,
+    FP16,
+    FP32,
+    UNSUPPORTED
+};
+
+// dnnOutput::dataType -> OutputType
+inline OutputType parseOutputType(const std::string& dataType) {
+    if (dataType == "int8" || dataType == "INT8") {
+        return OutputType::INT8;
+    }
+    if (dataType == "float16" || dataType == "FP16") {
+        return OutputType::FP16;
+    }
+    if (dataType == "float32" || dataType == "FP32") {
+        return OutputType::FP32;
+    }
+    return OutputType::UNSUPPORTED;
+}
+
+// IEEE 754 half -> float
+inline float fp16ToFp32(uint16_t h) {
+#ifdef OUTPUT_DECODE_USE_NEON
+    __fp16 half;
+    std::memcpy(&half, &h, sizeof(half));
+    return static_cast<float>(half);
+#else
+    uint32_t sign = static_cast<uint32_t>(h & 0x8000) << 16;
+    uint32_t exponent = (h >> 10) & 0x1F;
+    uint32_t mantissa = h & 0x3FF;
+    uint32_t bits;
+    if (exponent == 0) {
+        if (mantissa == 0) {
+            bits = sign;
+        }
+        else {
+            // subnormal: normalize the mantissa
+            exponent = 127 - 15 + 1;
+            while ((mantissa & 0x400) == 0) {
+                mantissa <<= 1;
+                exponent--;
+            }
+            mantissa &= 0x3FF;
+            bits = sign | (exponent << 23) | (mantissa << 13);
+        }
+    }
+    else if (exponent == 0x1F) {
+        bits = sign | 0x7F800000 | (mantissa << 13); // inf / nan
+    }
+    else {
+        bits = sign | ((exponent + 127 - 15) << 23) | (mantissa << 13);
+    }
+    float f;
+    std::memcpy(&f, &bits, sizeof(f));
+    return f;
+#endif
+}
+
+/**
+ * @brief Map a raw half to an integer with the same ordering as its value (NaN excluded).
+ * Positive halves already sort as integers; negative ones sort in reverse, so their magnitude
+ * is negated. +0 and -0 both map to 0.
+ */
+inline int16_t fp16OrderKey(uint16_t h) {
+    return (h & 0x8000) ? static_cast<int16_t>(-static_cast<int32_t>(h & 0x7FFF)) : static_cast<int16_t>(h);
+}
+
+// inverse of fp16OrderKey (-0 comes back as +0)
+inline uint16_t fp16FromOrderKey(int16_t key) {
+    return key < 0 ? static_cast<uint16_t>(0x8000 | -static_cast<int32_t>(key)) : static_cast<uint16_t>(key);
+}
+
+/**
+ * @brief Smallest order key whose half value is >= <val>, so that fp16OrderKey(h) >= key holds
+ * exactly when fp16ToFp32(h) >= val. Values above the largest finite half map to +inf.
+ */
+inline int16_t fp16OrderKeyAtLeast(float val) {
+    int32_t lo = -0x7C00; // -inf
+    int32_t hi = 0x7C00;  // +inf
+    if (!(val > fp16ToFp32(fp16FromOrderKey(static_cast<int16_t>(lo))))) {
+        return static_cast<int16_t>(lo);
+    }
+    // fp16ToFp32(key(lo)) < val <= fp16ToFp32(key(hi))
+    while (hi - lo > 1) {
+        int32_t mid = lo + (hi - lo) / 2;
+        if (fp16ToFp32(fp16FromOrderKey(static_cast<int16_t>(mid))) >= val) {
+            hi = mid;
+        }
+        else {
+            lo = mid;
+        }
+    }
+    return static_cast<int16_t>(hi);
+}
+
+inline float dequantAffine(int8_t qnt, int32_t zp, float scale) {
+    return (static_cast<float>(qnt) - static_cast<float>(zp)) * scale;
+}
+
+inline int8_t quantAffine(float fp32, int32_t zp, float scale) {
+    float dst_val = (fp32 / scale) + zp;
+    return static_cast<int8_t>(dst_val <= -128.f ? -128 : (dst_val >= 127.f ? 127 : dst_val));
+}
+
+/**
+ * @brief Append the indices i in [0, n) with data[i] >= threshold to <indices>.
+ */
+inline void scanAboveThreshold(const int8_t* data, size_t n, int8_t threshold, std::vector<uint32_t>& indices) {
+    size_t i = 0;
+#ifdef OUTPUT_DECODE_USE_NEON
+    const int8x16_t thr = vdupq_n_s8(threshold);
+    for (; i + 16 <= n; i += 16) {
+        uint8x16_t mask = vcgeq_s8(vld1q_s8(data + i), thr);
+        if (vmaxvq_u8(mask) == 0) {
+            continue;
+        }
+        for (size_t k = i; k < i + 16; k++) {
+            if (data[k] >= threshold) {
+                indices.push_back(static_cast<uint32_t>(k));
+            }
+        }
+    }
+#endif
+    for (; i < n; i++) {
+        if (data[i] >= threshold) {
+            indices.push_back(static_cast<uint32_t>(i));
+        }
+    }
+}
+
+inline void scanAboveThreshold(const float* data, size_t n, float threshold, std::vector<uint32_t>& indices) {
+    size_t i = 0;
+#ifdef OUTPUT_DECODE_USE_NEON
+    const float32x4_t thr = vdupq_n_f32(threshold);
+    for (; i + 8 <= n; i += 8) {
+        uint32x4_t mask = vorrq_u32(vcgeq_f32(vld1q_f32(data + i), thr), vcgeq_f32(vld1q_f32(data + i + 4), thr));
+        if (vmaxvq_u32(mask) == 0) {
+            continue;
+        }
+        for (size_t k = i; k < i + 8; k++) {
+            if (data[k] >= threshold) {
+                indices.push_back(static_cast<uint32_t>(k));
+            }
+        }
+    }
+#endif
+    for (; i < n; i++) {
+        if (data[i] >= threshold) {
+            indices.push_back(static_cast<uint32_t>(i));
+        }
+    }
+}
+
+// <data> holds raw IEEE 754 half values
+inline void scanAboveThresholdFp16(const uint16_t* data, size_t n, float threshold, std::vector<uint32_t>& indices) {
+    size_t i = 0;
+#ifdef OUTPUT_DECODE_USE_NEON
+    const float32x4_t thr = vdupq_n_f32(threshold);
+    for (; i + 8 <= n; i += 8) {
+        float16x8_t half = vreinterpretq_f16_u16(vld1q_u16(data + i));
+        uint32x4_t mask = vorrq_u32(vcgeq_f32(vcvt_f32_f16(vget_low_f16(half)), thr),
+                                    vcgeq_f32(vcvt_high_f32_f16(half), thr));
+        if (vmaxvq_u32(mask) == 0) {
+            continue;
+        }
+        for (size_t k = i; k < i + 8; k++) {
+            if (fp16ToFp32(data[k]) >= threshold) {
+                indices.push_back(static_cast<uint32_t>(k));
+            }
+        }
+    }
+#endif
+    for (; i < n; i++) {
+        if (fp16ToFp32(data[i]) >= threshold) {
+            indices.push_back(static_cast<uint32_t>(i));
+        }
+    }
+}
+
+/* Element decoders of the output tensor types.
+ * key() maps a raw element to a value with the same ordering as the decoded value, so threshold
+ * tests and argmax can run on raw int8/fp16/fp32 elements without dequantization; only the
+ * winning elements go through toFloat().
+ */
+struct int8Decoder {
+    using raw_type = int8_t;
+    using key_type = int8_t;
+    int32_t zp;
+    float scale;
+
+    float toFloat(raw_type v) const { return dequantAffine(v, zp, scale); }
+    key_type key(raw_type v) const { return v; }
+    key_type keyThreshold(float val) const { return quantAffine(val, zp, scale); }
+    void scan(const raw_type* data, size_t n, key_type thres, std::vector<uint32_t>& indices) const {
+        scanAboveThreshold(data, n, thres, indices);
+    }
+};
+
+struct fp16Decoder {
+    using raw_type = uint16_t;
+    using key_type = int16_t;
+
+    float toFloat(raw_type v) const { return fp16ToFp32(v); }
+    key_type key(raw_type v) const { return fp16OrderKey(v); }
+    key_type keyThreshold(float val) const { return fp16OrderKeyAtLeast(val); }
+    void scan(const raw_type* data, size_t n, key_type thres, std::vector<uint32_t>& indices) const {
+        // the half of <thres> is the smallest half >= the float threshold, so this selects the same cells
+        scanAboveThresholdFp16(data, n, fp16ToFp32(fp16FromOrderKey(thres)), indices);
+    }
+};
+
+struct fp32Decoder {
+    using raw_type = float;
+    using key_type = float;
+
+    float toFloat(raw_type v) const { return v; }
+    key_type key(raw_type v) const { return v; }
+    key_type keyThreshold(float val) const { return val; }
+    void scan(const raw_type* data, size_t n, key_type thres, std::vector<uint32_t>& indices) const {
+        scanAboveThreshold(data, n, thres, indices);
+    }
+};
+
+} // namespace output_decode
+
+} // namespace dnn_algorithm
+
+#endif // __OUTPUT_DECODE_HPP__
@@ -0,0 +1,115 @@
+#ifndef __POST_PROCESS_EXECUTOR_HPP__
+#define __POST_PROCESS_EXECUTOR_HPP__
+
+#include "IDnnObjDetectorPlugin.hpp"
+#include "bboxUtils.hpp"
+#include "common/TaskScheduler.hpp"
+#include <algorithm>
+#include <functional>
+#include <unordered_map>
+#include <vector>
+
+namespace dnn_algorithm {
+
+/**
+ * Post-processing stages of the detector plugins on top of the process-wide TaskScheduler:
+ * the output heads are decoded concurrently and the per-class NMS buckets run in parallel.
+ * The calling thread always takes part in the work, so a pool without workers runs serially.
+ */
+class postProcessExecutor {
+public:
+    // Below this many candidates NMS stays on the calling thread, the hand-off costs more than it saves
+    static constexpr size_t MIN_PARALLEL_CANDIDATES = 256;
+
+    static postProcessExecutor& instance() {
+        static postProcessExecutor executor(common::TaskScheduler::instance());
+        return executor;
+    }
+
+    explicit postProcessExecutor(common::TaskScheduler& scheduler) : m_scheduler{scheduler} {}
+
+    postProcessExecutor(const postProcessExecutor&) = delete;
+    postProcessExecutor& operator=(const postProcessExecutor&) = delete;
+
+    size_t getWorkerCount() const {
+        return m_scheduler.getWorkerCount();
+    }
+
+    // Run fn(i) for every i in [0, count) at high priority and wait; the first exception thrown by fn is rethrown here
+    void parallelFor(size_t count, const std::function<void(size_t)>& fn) {
+        m_scheduler.parallelFor(count, fn, common::TaskScheduler::Priority::High);
+    }
+
+    /**
+     * Class-aware greedy NMS.
+     * @param boxes Candidate boxes as x, y, w, h.
+     * @return Indices of the kept candidates, highest score first, at most <maxCount>.
+     */
+    std::vector<int> classAwareNms(const std::vector<float>& boxes, const std::vector<float>& scores,
+            const std::vector<int>& classIds, float threshold, size_t maxCount) {
+        std::unordered_map<int, size_t> bucket_of_class;
+        std::vector<std::vector<int>> buckets;
+        for (size_t n = 0; n < scores.size(); n++) {
+            auto it = bucket_of_class.find(classIds[n]);
+            if (it == bucket_of_class.end()) {
+                it = bucket_of_class.emplace(classIds[n], buckets.size()).first;
+                buckets.emplace_back();
+            }
+            buckets[it->second].push_back(static_cast<int>(n));
+        }
+
+        auto suppress = [&boxes, &scores, threshold](std::vector<int>& bucket) {
+            std::sort(bucket.begin(), bucket.end(), [&scores](int a, int b) { return scores[a] > scores[b]; });
+            std::vector<int> kept;
+            for (int n : bucket) {
+                bboxRect<float> bbox1 = toRect(boxes, n);
+                bool overlapped = false;
+                for (int m : kept) {
+                    if (bbox_utils::calculateOverlap(bbox1, toRect(boxes, m)) > threshold) {
+                        overlapped = true;
+                        break;
+                    }
+                }
+                if (!overlapped) {
+                    kept.push_back(n);
+                }
+            }
+            bucket.swap(kept);
+        };
+
+        if (scores.size() < MIN_PARALLEL_CANDIDATES) {
+            for (auto& bucket : buckets) {
+                suppress(bucket);
+            }
+        }
+        else {
+            parallelFor(buckets.size(), [&buckets, &suppress](size_t i) { suppress(buckets[i]); });
+        }
+
+        std::vector<int> kept;
+        for (const auto& bucket : buckets) {
+            kept.insert(kept.end(), bucket.begin(), bucket.end());
+        }
+        std::sort(kept.begin(), kept.end(), [&scores](int a, int b) { return scores[a] > scores[b]; });
+        if (kept.size() > maxCount) {
+            kept.resize(maxCount);
+        }
+        return kept;
+    }
+
+private:
+    static bboxRect<float> toRect(const std::vector<float>& boxes, int n) {
+        bboxRect<float> rect;
+        rect.left = boxes[n * 4 + 0];
+        rect.top = boxes[n * 4 + 1];
+        rect.right = boxes[n * 4 + 0] + boxes[n * 4 + 2];
+        rect.bottom = boxes[n * 4 + 1] + boxes[n * 4 + 3];
+        return rect;
+    }
+
+    common::TaskScheduler& m_scheduler;
+};
+
+} // namespace dnn_algorithm
+
+#endif // __POST_PROCESS_EXECUTOR_HPP__
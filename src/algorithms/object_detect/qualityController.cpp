@@ -0,0 +1,89 @@
+#include "qualityController.hpp"
+#include <algorithm>
+
+namespace dnn_algorithm {
+
+qualityController::qualityController(const QualityControlParams& params) :
+    m_params{params} {
+    m_params.window = std::max<size_t>(m_params.window, 1);
+    m_params.max_upgrade_backoff = std::clamp(m_params.max_upgrade_backoff, 0, 16);
+    m_samples.resize(m_params.window);
+    m_sorted.reserve(m_params.window);
+}
+
+void qualityController::reset() {
+    m_next = 0;
+    m_count = 0;
+    m_misses = 0;
+    m_framesAtLevel = 0;
+    m_calmFrames = 0;
+}
+
+void qualityController::computePercentiles() {
+    m_sorted.assign(m_samples.begin(), m_samples.begin() + m_count);
+    std::sort(m_sorted.begin(), m_sorted.end());
+    m_stats.p50_ms = m_sorted[(m_count - 1) / 2];
+    m_stats.p95_ms = m_sorted[(m_count - 1) * 95 / 100];
+    m_stats.miss_rate = static_cast<float>(m_misses) / static_cast<float>(m_count);
+}
+
+void qualityController::switchLevel(int level, int levelCount) {
+    if (m_levels.size() != static_cast<size_t>(levelCount)) {
+        m_levels.assign(levelCount, levelHistory{});
+    }
+    if (m_level >= 0 && m_level < levelCount && m_count > 0) {
+        auto& left = m_levels[m_level];
+        left.p95_ms = m_stats.p95_ms;
+        if (left.p95_ms <= m_params.deadline_ms * m_params.degrade_ratio) {
+            left.backoff = 0;
+        }
+        else if (m_upgraded && level > m_level) {
+            // stepped up and had to step down again
+            left.backoff = std::min(left.backoff + 1, m_params.max_upgrade_backoff);
+        }
+    }
+    m_upgraded = m_level >= 0 && level < m_level;
+    m_level = level;
+    reset();
+}
+
+int qualityController::update(float latencyMs, size_t queueDepth, int level, int levelCount) {
+    if (level != m_level || m_levels.size() != static_cast<size_t>(levelCount)) {
+        // switched by the caller or by the last decision, the old samples describe another variant
+        switchLevel(level, levelCount);
+    }
+
+    if (m_count == m_params.window) {
+        m_misses -= m_samples[m_next] > m_params.deadline_ms ? 1 : 0;
+    }
+    else {
+        m_count++;
+    }
+    m_samples[m_next] = latencyMs;
+    m_misses += latencyMs > m_params.deadline_ms ? 1 : 0;
+    m_next = (m_next + 1) % m_params.window;
+    m_framesAtLevel++;
+
+    computePercentiles();
+    m_stats.level = level;
+    m_stats.queue_depth = queueDepth;
+
+    bool queue_backlog = m_params.queue_high > 0 && queueDepth >= m_params.queue_high;
+    bool overloaded = m_stats.p95_ms > m_params.deadline_ms * m_params.degrade_ratio
+            || m_stats.miss_rate > m_params.max_miss_rate || queue_backlog;
+    if (overloaded && level + 1 < levelCount && m_framesAtLevel >= m_params.degrade_hold_frames) {
+        m_stats.degrades++;
+        return level + 1;
+    }
+
+    bool calm = m_stats.p95_ms < m_params.deadline_ms * m_params.upgrade_ratio && m_misses == 0
+            && (m_params.queue_high == 0 || queueDepth <= m_params.queue_low);
+    m_calmFrames = calm ? m_calmFrames + 1 : 0;
+    if (calm && level > 0 && m_calmFrames >= (m_params.upgrade_hold_frames << m_levels[level - 1].backoff)) {
+        m_stats.upgrades++;
+        return level - 1;
+    }
+    return level;
+}
+
+} // namespace dnn_algorithm
@@ -0,0 +1,84 @@
+#ifndef __QUALITY_CONTROLLER_HPP__
+#define __QUALITY_CONTROLLER_HPP__
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace dnn_algorithm {
+
+struct QualityControlParams {
+    float deadline_ms{100.f};       // per-frame processing budget
+    size_t window{30};              // latency samples the percentiles are computed over
+    float degrade_ratio{0.9f};      // step down when p95 exceeds this fraction of the deadline
+    float upgrade_ratio{0.5f};      // step up only while p95 stays below this fraction of the deadline
+    float max_miss_rate{0.05f};     // step down when more frames of the window miss the deadline
+    size_t queue_high{2};           // step down at this many frames waiting, 0 = ignore the queue
+    size_t queue_low{0};            // step up only with at most this many frames waiting
+    int degrade_hold_frames{10};    // minimum frames on a variant before stepping down
+    int upgrade_hold_frames{90};    // minimum calm frames before stepping up
+    int max_upgrade_backoff{5};     // the hold doubles per failed upgrade to a level, up to this many times
+};
+
+struct QualityControlStats {
+    int level{0};                   // 0 = first (best) variant
+    float p50_ms{0.f};
+    float p95_ms{0.f};
+    float miss_rate{0.f};
+    size_t queue_depth{0};
+    uint64_t degrades{0};
+    uint64_t upgrades{0};
+};
+
+/**
+ * @brief Picks the model variant under load: level 0 is the best variant, higher levels are cheaper.
+ *
+ * Steps down one level as soon as the latency percentiles, the deadline misses or the input queue show the current
+ * variant cannot keep up, and steps back up only after a longer calm period with a wide margin to the deadline.
+ * The asymmetric thresholds and holds keep it from oscillating between two variants. The samples of a level are
+ * discarded when the level changes, but the last p95 of every level is kept: a calm cheaper level says nothing about
+ * the better one, so stepping back up to a level that did not fit the deadline waits twice as long after each failure.
+ */
+class qualityController {
+public:
+    explicit qualityController(const QualityControlParams& params = QualityControlParams{});
+
+    /**
+     * @brief Add the processing time of a frame.
+     * @param level Variant that processed the frame.
+     * @param levelCount Number of variants available.
+     * @return The level for the next frames.
+     */
+    int update(float latencyMs, size_t queueDepth, int level, int levelCount);
+
+    void reset();
+
+    const QualityControlStats& getStats() const { return m_stats; }
+
+private:
+    void computePercentiles();
+    void switchLevel(int level, int levelCount);
+
+private:
+    struct levelHistory {
+        float p95_ms{0.f};          // at the last switch away from the level, 0 = never measured
+        int backoff{0};             // failed upgrades to the level since it last fitted the deadline
+    };
+
+    QualityControlParams m_params;
+    std::vector<levelHistory> m_levels;
+    std::vector<float> m_samples;   // ring buffer of the latest latencies
+    std::vector<float> m_sorted;
+    size_t m_next{0};
+    size_t m_count{0};
+    size_t m_misses{0};             // deadline misses among the samples
+    int m_level{-1};
+    int m_framesAtLevel{0};
+    int m_calmFrames{0};
+    bool m_upgraded{false};         // the current level was entered by stepping up
+    QualityControlStats m_stats{};
+};
+
+} // namespace dnn_algorithm
+
+#endif // __QUALITY_CONTROLLER_HPP__
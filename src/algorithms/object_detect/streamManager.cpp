@@ -0,0 +1,264 @@
+#include "streamManager.hpp"
+#include "imageTiler.hpp"
+#include "common/CpuTopology.hpp"
+#include <algorithm>
+
+namespace dnn_algorithm {
+
+namespace {
+
+float elapsedMs(streamManager::Clock::time_point from, streamManager::Clock::time_point to) {
+    return std::chrono::duration<float, std::milli>(to - from).count();
+}
+
+} // namespace
+
+
+streamManager::streamManager(size_t engineSlots) : m_logger{std::make_unique<Logger>("streamManager")} {
+    for (size_t i = 0; i < std::max<size_t>(1, engineSlots); i++) {
+        m_workers.emplace_back(&streamManager::dispatchLoop, this);
+    }
+}
+
+streamManager::~streamManager() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_cv.notify_all();
+    for (auto& worker : m_workers) {
+        worker.join();
+    }
+}
+
+int streamManager::addStream(const StreamParams& params, std::shared_ptr<dnnObjDetector> detector, ResultCallback callback) {
+    if (detector == nullptr) {
+        throw std::invalid_argument("The stream detector is nullptr.");
+    }
+
+    auto stream = std::make_shared<Stream>();
+    stream->params = params;
+    stream->params.priority = std::max(1, params.priority);
+    stream->params.queue_depth = std::max<size_t>(1, params.queue_depth);
+    stream->detector = std::move(detector);
+    stream->callback = std::move(callback);
+    stream->stats.name = params.name;
+    stream->fpsWindowStart = Clock::now();
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    stream->id = m_nextStreamId++;
+    m_streams.push_back(stream);
+    return stream->id;
+}
+
+void streamManager::removeStream(int streamId) {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    auto it = std::find_if(m_streams.begin(), m_streams.end(),
+            [streamId](const std::shared_ptr<Stream>& stream) { return stream->id == streamId; });
+    if (it == m_streams.end()) {
+        return;
+    }
+    auto stream = *it;
+    stream->removed = true;
+    stream->queue.clear();
+    m_idleCv.wait(lock, [&stream]() { return !stream->busy; });
+    m_streams.erase(std::find(m_streams.begin(), m_streams.end(), stream));
+}
+
+bool streamManager::submitFrame(int streamId, std::shared_ptr<ObjDetectInput> frame, const ObjDetectParams& params) {
+    auto now = Clock::now();
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = std::find_if(m_streams.begin(), m_streams.end(),
+            [streamId](const std::shared_ptr<Stream>& stream) { return stream->id == streamId; });
+    if (it == m_streams.end() || (*it)->removed) {
+        return false;
+    }
+
+    Stream& stream = **it;
+    stream.stats.submitted++;
+    if (stream.params.target_fps > 0.f) {
+        auto interval = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<float>(1.f / stream.params.target_fps));
+        if (now < stream.nextDue) {
+            stream.stats.dropped_rate++;
+            return false;
+        }
+        // Keep the average rate across camera jitter, without bursting after a pause
+        stream.nextDue = std::max(stream.nextDue + interval, now + interval / 2);
+    }
+
+    if (stream.queue.size() >= stream.params.queue_depth) {
+        stream.queue.pop_front();
+        stream.stats.dropped_queue++;
+    }
+    stream.queue.push_back({std::move(frame), params, now});
+    m_cv.notify_one();
+    return true;
+}
+
+// Drop the queued frames that cannot be finished before their deadline anymore
+void streamManager::shedExpired(Stream& stream, Clock::time_point now) {
+    const float deadline_ms = stream.params.deadline_ms;
+    while (!stream.queue.empty()) {
+        float waited_ms = elapsedMs(stream.queue.front().submitted, now);
+        // With an estimate above the deadline only late frames are shed, so the estimate can still recover
+        bool predictable = stream.expectedProcessMs <= deadline_ms;
+        if (waited_ms <= deadline_ms && (!predictable || waited_ms + stream.expectedProcessMs <= deadline_ms)) {
+            break;
+        }
+        stream.queue.pop_front();
+        stream.stats.dropped_deadline++;
+    }
+}
+
+/* Smooth weighted round-robin (as in nginx): every ready stream gains its weight,
+ * the richest one is served and pays the total weight, which interleaves the streams evenly.
+ */
+std::shared_ptr<streamManager::Stream> streamManager::pickStream() {
+    auto now = Clock::now();
+    int total_weight = 0;
+    std::shared_ptr<Stream> best;
+    for (auto& stream : m_streams) {
+        if (stream->busy || stream->removed) {
+            continue;
+        }
+        shedExpired(*stream, now);
+        if (stream->queue.empty()) {
+            continue;
+        }
+        stream->currentWeight += stream->params.priority;
+        total_weight += stream->params.priority;
+        if (best == nullptr || stream->currentWeight > best->currentWeight) {
+            best = stream;
+        }
+    }
+    if (best != nullptr) {
+        best->currentWeight -= total_weight;
+    }
+    return best;
+}
+
+void streamManager::dispatchLoop() {
+    common::CpuAffinity::applyToCurrentThread(common::CpuAffinity::Stage::Inference);
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (true) {
+        std::shared_ptr<Stream> stream;
+        m_cv.wait(lock, [this, &stream]() {
+            if (m_stop) {
+                return true;
+            }
+            stream = pickStream();
+            return stream != nullptr;
+        });
+        if (m_stop) {
+            return;
+        }
+
+        PendingFrame pending = std::move(stream->queue.front());
+        stream->queue.pop_front();
+        stream->busy = true;
+        size_t backlog = stream->queue.size();
+        lock.unlock();
+
+        auto start = Clock::now();
+        int ret = -1;
+        std::vector<ObjDetectOutput> outputs;
+        try {
+            stream->detector->reportQueueDepth(backlog);
+            stream->detector->pushInputData(pending.frame);
+            ret = stream->detector->runObjDetect(pending.params);
+            outputs = stream->detector->popOutputData();
+        }
+        catch (const std::exception& e) {
+            m_logger->printStdoutLog(Logger::LogLevel::Error, "Stream {} failed: {}", stream->params.name, e.what());
+        }
+        auto end = Clock::now();
+        float latency_ms = elapsedMs(pending.submitted, end);
+        if (stream->callback) {
+            stream->callback(stream->id, ret, pending.frame, outputs, latency_ms);
+        }
+
+        lock.lock();
+        recordResult(*stream, ret, elapsedMs(start, end), latency_ms, end);
+        stream->busy = false;
+        // another worker may be waiting for this stream, removeStream/reportMemory for the frame to finish
+        m_cv.notify_all();
+        m_idleCv.notify_all();
+    }
+}
+
+void streamManager::recordResult(Stream& stream, int status, float processMs, float latencyMs, Clock::time_point now) {
+    if (status != 0) {
+        stream.stats.failed++;
+        return;
+    }
+
+    auto& stats = stream.stats;
+    stats.processed++;
+    stream.expectedProcessMs = stats.processed == 1 ? processMs : stream.expectedProcessMs * 0.8f + processMs * 0.2f;
+    stream.latencySumMs += latencyMs;
+    stats.avg_latency_ms = static_cast<float>(stream.latencySumMs / stats.processed);
+    stats.max_latency_ms = std::max(stats.max_latency_ms, latencyMs);
+
+    stream.fpsWindowFrames++;
+    float window_ms = elapsedMs(stream.fpsWindowStart, now);
+    if (window_ms >= 1000.f) {
+        stats.achieved_fps = stream.fpsWindowFrames * 1000.f / window_ms;
+        stream.fpsWindowFrames = 0;
+        stream.fpsWindowStart = now;
+    }
+}
+
+int streamManager::getStreamStats(int streamId, StreamStats& stats) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (const auto& stream : m_streams) {
+        if (stream->id == streamId) {
+            stats = stream->stats;
+            // a stalled stream has no results to refresh its rate
+            float window_ms = elapsedMs(stream->fpsWindowStart, Clock::now());
+            if (window_ms >= 2000.f) {
+                stats.achieved_fps = stream->fpsWindowFrames * 1000.f / window_ms;
+            }
+            return 0;
+        }
+    }
+    return -1;
+}
+
+void streamManager::reportMemory(MemoryReport& report, const std::string& prefix) {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    auto streams = m_streams;
+    for (const auto& stream : streams) {
+        // the detector is not re-entrant, it is read once no worker runs it; dispatch needs the lock held here
+        m_idleCv.wait(lock, [&stream]() { return !stream->busy; });
+        if (stream->removed) {
+            continue;
+        }
+        std::string name = prefix + "." + (stream->params.name.empty() ? "stream" + std::to_string(stream->id) : stream->params.name);
+        size_t queued = 0;
+        for (const auto& pending : stream->queue) {
+            queued += sizeof(PendingFrame) + (pending.frame != nullptr ? imageTiler::getFrameBytes(*pending.frame) : 0);
+        }
+        report.add(name + ".queue", queued);
+        stream->detector->reportMemory(report, name + ".detector");
+    }
+}
+
+std::vector<StreamStats> streamManager::getAllStreamStats() const {
+    std::vector<int> ids;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (const auto& stream : m_streams) {
+            ids.push_back(stream->id);
+        }
+    }
+    std::vector<StreamStats> all_stats;
+    for (int id : ids) {
+        StreamStats stats;
+        if (getStreamStats(id, stats) == 0) {
+            all_stats.push_back(stats);
+        }
+    }
+    return all_stats;
+}
+
+} // namespace dnn_algorithm
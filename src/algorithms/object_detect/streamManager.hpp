@@ -0,0 +1,124 @@
+#ifndef __STREAM_MANAGER_HPP__
+#define __STREAM_MANAGER_HPP__
+
+#include "dnnObjDetector.hpp"
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace dnn_algorithm {
+
+struct StreamParams {
+    std::string name{};
+    int priority{1};            // weighted round-robin weight, >= 1
+    float target_fps{0.f};      // frames arriving faster are dropped at submission, 0 = no limit
+    float deadline_ms{200.f};   // frames that cannot finish within this time after submission are shed
+    size_t queue_depth{2};      // the oldest queued frame is dropped when a new one does not fit
+};
+
+struct StreamStats {
+    std::string name{};
+    uint64_t submitted{0};
+    uint64_t processed{0};
+    uint64_t failed{0};
+    uint64_t dropped_rate{0};       // above target_fps
+    uint64_t dropped_queue{0};      // replaced by a newer frame
+    uint64_t dropped_deadline{0};   // would have missed the deadline
+    float achieved_fps{0.f};
+    float avg_latency_ms{0.f};      // submission to result
+    float max_latency_ms{0.f};
+};
+
+/**
+ * @brief Shares the inference capacity of the box between camera streams.
+ *
+ * Every stream keeps its own dnnObjDetector (tracker, motion gate and tiling state are per stream),
+ * while a fixed number of dispatch workers (the engine slots) pick the next frame by smooth weighted
+ * round-robin over the streams with pending frames. Under overload frames are shed instead of queued:
+ * rate-limited at submission, replaced in the bounded per-stream queue, and dropped at dispatch when the
+ * queueing delay plus the expected processing time of the stream exceeds its deadline.
+ */
+class streamManager {
+public:
+    using Clock = std::chrono::steady_clock;
+    // Called on a dispatch worker with the result of every processed frame
+    using ResultCallback = std::function<void(int streamId, int status, std::shared_ptr<ObjDetectInput> frame,
+            std::vector<ObjDetectOutput>& outputs, float latencyMs)>;
+
+    explicit streamManager(size_t engineSlots = 1);
+    ~streamManager();
+
+    streamManager(const streamManager&) = delete;
+    streamManager& operator=(const streamManager&) = delete;
+
+    // @return the stream id
+    int addStream(const StreamParams& params, std::shared_ptr<dnnObjDetector> detector, ResultCallback callback);
+
+    // Drops the queued frames and waits for the frame in progress
+    void removeStream(int streamId);
+
+    /**
+     * @brief Queue a frame, never blocks.
+     * @return false if the frame was dropped at submission (rate limit or unknown stream).
+     */
+    bool submitFrame(int streamId, std::shared_ptr<ObjDetectInput> frame, const ObjDetectParams& params);
+
+    int getStreamStats(int streamId, StreamStats& stats) const;
+    std::vector<StreamStats> getAllStreamStats() const;
+
+    /**
+     * @brief Add the queued frames and the detector of every stream to <report>, as <prefix>.<stream name>.queue
+     * and <prefix>.<stream name>.detector. Waits for the frame in progress of each stream, like removeStream.
+     */
+    void reportMemory(MemoryReport& report, const std::string& prefix = "streams");
+
+private:
+    struct PendingFrame {
+        std::shared_ptr<ObjDetectInput> frame{};
+        ObjDetectParams params{};
+        Clock::time_point submitted{};
+    };
+
+    struct Stream {
+        int id{0};
+        StreamParams params{};
+        std::shared_ptr<dnnObjDetector> detector{};
+        ResultCallback callback{};
+        std::deque<PendingFrame> queue{};
+        bool busy{false};           // the detector is not re-entrant, one frame per stream at a time
+        bool removed{false};
+        int currentWeight{0};       // smooth weighted round-robin state
+        Clock::time_point nextDue{};    // rate limit: earliest submission time of the next accepted frame
+        float expectedProcessMs{0.f};   // moving average of the processing time
+        StreamStats stats{};
+        uint64_t fpsWindowFrames{0};
+        Clock::time_point fpsWindowStart{};
+        double latencySumMs{0.0};
+    };
+
+    void dispatchLoop();
+    std::shared_ptr<Stream> pickStream();
+    void shedExpired(Stream& stream, Clock::time_point now);
+    void recordResult(Stream& stream, int status, float processMs, float latencyMs, Clock::time_point now);
+
+private:
+    std::unique_ptr<Logger> m_logger;
+    mutable std::mutex m_mutex;
+    std::condition_variable m_cv;       // dispatch workers: a frame was queued or a stream became idle
+    std::condition_variable m_idleCv;   // removeStream/reportMemory: a stream finished its frame
+    std::vector<std::shared_ptr<Stream>> m_streams{};
+    int m_nextStreamId{0};
+    bool m_stop{false};
+    std::vector<std::thread> m_workers{};
+};
+
+} // namespace dnn_algorithm
+
+#endif // __STREAM_MANAGER_HPP__
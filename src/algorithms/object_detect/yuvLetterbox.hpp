@@ -0,0 +1,174 @@
+#ifndef __YUV_LETTERBOX_HPP__
+#define __YUV_LETTERBOX_HPP__
+
+#include "IDnnObjDetectorPlugin.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace dnn_algorithm {
+
+/**
+ * Fused camera-frame pre-processing: converts an NV12/NV21/YUYV frame straight into the
+ * letterboxed, packed RGB (HWC, uint8) model input tensor in a single pass.
+ * Luma is sampled bilinearly, chroma from the nearest subsampled position, and the colour
+ * conversion uses the BT.601 limited-range integer coefficients (same as cv::COLOR_YUV2RGB_NV12).
+ * Replaces cvtColor(YUV->BGR) + cvtColor(BGR->RGB) + resize + copyMakeBorder.
+ */
+namespace yuv_letterbox {
+
+enum class YuvFormat {
+    NV12,
+    NV21,
+    YUYV
+};
+
+inline bool parseYuvFormat(const std::string& handleType, YuvFormat& format) {
+    if (handleType == "nv12") {
+        format = YuvFormat::NV12;
+    }
+    else if (handleType == "nv21") {
+        format = YuvFormat::NV21;
+    }
+    else if (handleType == "yuyv") {
+        format = YuvFormat::YUYV;
+    }
+    else {
+        return false;
+    }
+    return true;
+}
+
+// Bytes of one row of the first plane, the interleaved chroma plane of NV12/NV21 has the same size
+inline size_t bytesPerRow(YuvFormat format, size_t width) {
+    return format == YuvFormat::YUYV ? width * 2 : width;
+}
+
+// The chroma pairs span two pixels, a frame needs an even width and rows that hold all of it
+inline bool isValidFrame(const YuvImageHandle& src, YuvFormat format) {
+    if (src.width == 0 || src.height == 0 || (src.width & 1) != 0) {
+        return false;
+    }
+    size_t row_bytes = bytesPerRow(format, src.width);
+    return src.strides[0] >= row_bytes && (format == YuvFormat::YUYV || src.strides[1] >= row_bytes);
+}
+
+inline uint8_t clampToU8(int val) {
+    return static_cast<uint8_t>(val < 0 ? 0 : (val > 255 ? 255 : val));
+}
+
+inline void yuvToRgb(int y, int u, int v, uint8_t* rgb) {
+    int c = 298 * (y - 16);
+    int d = u - 128;
+    int e = v - 128;
+    rgb[0] = clampToU8((c + 409 * e + 128) >> 8);
+    rgb[1] = clampToU8((c - 100 * d - 208 * e + 128) >> 8);
+    rgb[2] = clampToU8((c + 516 * d + 128) >> 8);
+}
+
+/**
+ * @param src The camera frame, with an even width and strides of at least bytesPerRow().
+ * @param format The frame pixel format.
+ * @param dst Output tensor, dstWidth * dstHeight * 3 bytes.
+ * @param contentWidth Width of the resized frame inside the letterbox.
+ * @param contentHeight Height of the resized frame inside the letterbox.
+ * @param padLeft Left border of the letterbox.
+ * @param padTop Top border of the letterbox.
+ * @param padValue Grey level of the border.
+ * @return -1 if the frame fails isValidFrame().
+ */
+inline int convertToLetterboxRgb(const YuvImageHandle& src, YuvFormat format, uint8_t* dst,
+        int dstWidth, int dstHeight, int contentWidth, int contentHeight, int padLeft, int padTop, uint8_t padValue = 128) {
+    if (src.planes[0] == nullptr || (format != YuvFormat::YUYV && src.planes[1] == nullptr)) {
+        throw std::invalid_argument("YuvImageHandle plane is nullptr.");
+    }
+    if (contentWidth <= 0 || contentHeight <= 0 || padLeft + contentWidth > dstWidth || padTop + contentHeight > dstHeight) {
+        throw std::invalid_argument("Invalid letterbox geometry.");
+    }
+    if (!isValidFrame(src, format)) {
+        return -1;
+    }
+
+    const int src_w = static_cast<int>(src.width);
+    const int src_h = static_cast<int>(src.height);
+    const size_t dst_row_bytes = static_cast<size_t>(dstWidth) * 3;
+
+    // Top and bottom borders
+    std::memset(dst, padValue, dst_row_bytes * padTop);
+    std::memset(dst + dst_row_bytes * (padTop + contentHeight), padValue, dst_row_bytes * (dstHeight - padTop - contentHeight));
+
+    // Horizontal source positions with 8-bit fixed-point weights, shared by all rows
+    std::vector<int> x0(contentWidth);
+    std::vector<int> x1(contentWidth);
+    std::vector<int> wx(contentWidth);
+    std::vector<int> xc(contentWidth); // even luma column of the chroma pair
+    const float fx = static_cast<float>(src_w) / contentWidth;
+    for (int x = 0; x < contentWidth; x++) {
+        float sx = std::max(0.0f, (x + 0.5f) * fx - 0.5f);
+        int ix = std::min(static_cast<int>(sx), src_w - 1);
+        x0[x] = ix;
+        x1[x] = std::min(ix + 1, src_w - 1);
+        wx[x] = static_cast<int>((sx - ix) * 256.0f);
+        xc[x] = std::min(static_cast<int>(sx + 0.5f), src_w - 1) & ~1;
+    }
+
+    const float fy = static_cast<float>(src_h) / contentHeight;
+    for (int y = 0; y < contentHeight; y++) {
+        float sy = std::max(0.0f, (y + 0.5f) * fy - 0.5f);
+        int iy0 = std::min(static_cast<int>(sy), src_h - 1);
+        int iy1 = std::min(iy0 + 1, src_h - 1);
+        int wy = static_cast<int>((sy - iy0) * 256.0f);
+        int iyc = std::min(static_cast<int>(sy + 0.5f), src_h - 1);
+
+        uint8_t* out = dst + dst_row_bytes * (padTop + y);
+        std::memset(out, padValue, static_cast<size_t>(padLeft) * 3);
+        uint8_t* out_end = out + static_cast<size_t>(padLeft + contentWidth) * 3;
+        std::memset(out_end, padValue, static_cast<size_t>(dstWidth - padLeft - contentWidth) * 3);
+        out += static_cast<size_t>(padLeft) * 3;
+
+        if (format == YuvFormat::YUYV) {
+            const uint8_t* row0 = src.planes[0] + src.strides[0] * iy0;
+            const uint8_t* row1 = src.planes[0] + src.strides[0] * iy1;
+            const uint8_t* rowc = src.planes[0] + src.strides[0] * iyc;
+            for (int x = 0; x < contentWidth; x++, out += 3) {
+                int a = row0[x0[x] * 2];
+                int b = row0[x1[x] * 2];
+                int c = row1[x0[x] * 2];
+                int d = row1[x1[x] * 2];
+                int top = (a << 8) + (b - a) * wx[x];
+                int bottom = (c << 8) + (d - c) * wx[x];
+                int luma = ((top << 8) + (bottom - top) * wy + (1 << 15)) >> 16;
+                const uint8_t* pair = rowc + xc[x] * 2; // Y0 U Y1 V
+                yuvToRgb(luma, pair[1], pair[3], out);
+            }
+        }
+        else {
+            const uint8_t* row0 = src.planes[0] + src.strides[0] * iy0;
+            const uint8_t* row1 = src.planes[0] + src.strides[0] * iy1;
+            const uint8_t* rowc = src.planes[1] + src.strides[1] * (iyc >> 1);
+            const int u_off = format == YuvFormat::NV12 ? 0 : 1;
+            const int v_off = 1 - u_off;
+            for (int x = 0; x < contentWidth; x++, out += 3) {
+                int a = row0[x0[x]];
+                int b = row0[x1[x]];
+                int c = row1[x0[x]];
+                int d = row1[x1[x]];
+                int top = (a << 8) + (b - a) * wx[x];
+                int bottom = (c << 8) + (d - c) * wx[x];
+                int luma = ((top << 8) + (bottom - top) * wy + (1 << 15)) >> 16;
+                const uint8_t* uv = rowc + xc[x];
+                yuvToRgb(luma, uv[u_off], uv[v_off], out);
+            }
+        }
+    }
+    return 0;
+}
+
+} // namespace yuv_letterbox
+
+} // namespace dnn_algorithm
+
+#endif // __YUV_LETTERBOX_HPP__
@@ -0,0 +1,352 @@
+#include "objTracker.hpp"
+#include "algorithms/object_detect/bboxUtils.hpp"
+#include <algorithm>
+#include <cmath>
+#include <string_view>
+#include <tuple>
+
+namespace dnn_algorithm {
+
+namespace {
+
+/**
+ * Constant-velocity Kalman filter of one coordinate, state [position, velocity].
+ * The box state (cx, cy, w, h) uses four of them: with a diagonal process and measurement
+ * noise the 8-state SORT filter decouples into independent 2-state filters.
+ */
+class kalman1D {
+public:
+    void init(float pos, float posVar, float velVar) {
+        m_x[0] = pos;
+        m_x[1] = 0.f;
+        m_P[0][0] = posVar;
+        m_P[0][1] = 0.f;
+        m_P[1][0] = 0.f;
+        m_P[1][1] = velVar;
+    }
+
+    void predict(float q) {
+        // x = F x, P = F P F' + Q, with F = [1 1; 0 1]
+        m_x[0] += m_x[1];
+        float p00 = m_P[0][0] + m_P[0][1] + m_P[1][0] + m_P[1][1] + q;
+        float p01 = m_P[0][1] + m_P[1][1];
+        float p10 = m_P[1][0] + m_P[1][1];
+        float p11 = m_P[1][1] + q * 0.01f;
+        m_P[0][0] = p00;
+        m_P[0][1] = p01;
+        m_P[1][0] = p10;
+        m_P[1][1] = p11;
+    }
+
+    void correct(float z, float r) {
+        // H = [1 0]
+        float s = m_P[0][0] + r;
+        float k0 = m_P[0][0] / s;
+        float k1 = m_P[1][0] / s;
+        float y = z - m_x[0];
+        m_x[0] += k0 * y;
+        m_x[1] += k1 * y;
+        float p00 = (1.f - k0) * m_P[0][0];
+        float p01 = (1.f - k0) * m_P[0][1];
+        float p10 = m_P[1][0] - k1 * m_P[0][0];
+        float p11 = m_P[1][1] - k1 * m_P[0][1];
+        m_P[0][0] = p00;
+        m_P[0][1] = p01;
+        m_P[1][0] = p10;
+        m_P[1][1] = p11;
+    }
+
+    float position() const { return m_x[0]; }
+
+private:
+    float m_x[2]{0.f, 0.f};
+    float m_P[2][2]{{0.f, 0.f}, {0.f, 0.f}};
+};
+
+} // namespace
+
+
+// A detection of either result layout, the label view is only valid during update()
+struct objTracker::detection {
+    bboxRect<float> bbox;
+    float score;
+    int classId;
+    std::string_view label;
+};
+
+
+class objTracker::track {
+public:
+    track(int id, const detection& det) : m_id{id}, m_label{det.label}, m_classId{det.classId}, m_score{det.score}, m_confidence{det.score} {
+        float cx, cy, w, h;
+        toCenter(det.bbox, cx, cy, w, h);
+        float size = std::max(w, h);
+        m_filters[0].init(cx, size * size * 0.01f, size * size);
+        m_filters[1].init(cy, size * size * 0.01f, size * size);
+        m_filters[2].init(w, w * w * 0.01f, w * w * 0.1f);
+        m_filters[3].init(h, h * h * 0.01f, h * h * 0.1f);
+    }
+
+    void predict(float confidenceDecay) {
+        float size = std::max(m_filters[2].position(), m_filters[3].position());
+        float q = std::max(1.f, size * size * 0.0025f);
+        for (auto& filter : m_filters) {
+            filter.predict(q);
+        }
+        m_framesSinceUpdate++;
+        m_confidence *= confidenceDecay;
+    }
+
+    void correct(const detection& det) {
+        float cx, cy, w, h;
+        toCenter(det.bbox, cx, cy, w, h);
+        float size = std::max(w, h);
+        float r = std::max(1.f, size * size * 0.0025f);
+        m_filters[0].correct(cx, r);
+        m_filters[1].correct(cy, r);
+        m_filters[2].correct(w, r);
+        m_filters[3].correct(h, r);
+        m_score = det.score;
+        m_confidence = det.score;
+        m_framesSinceUpdate = 0;
+        m_hits++;
+        m_lost = false;
+    }
+
+    // No detection matched the track on a detection frame
+    void markLost() { m_lost = true; }
+
+    bboxRect<float> getBbox() const {
+        float cx = m_filters[0].position();
+        float cy = m_filters[1].position();
+        float w = std::max(1.f, m_filters[2].position());
+        float h = std::max(1.f, m_filters[3].position());
+        bboxRect<float> bbox;
+        bbox.left = cx - w / 2.f;
+        bbox.top = cy - h / 2.f;
+        bbox.right = cx + w / 2.f;
+        bbox.bottom = cy + h / 2.f;
+        return bbox;
+    }
+
+    // Class ids take precedence, detections without one are matched by label
+    bool isSameClass(const detection& det) const {
+        return m_classId >= 0 && det.classId >= 0 ? m_classId == det.classId : m_label == det.label;
+    }
+
+    ObjDetectOutput toOutput() const {
+        auto bbox = getBbox();
+        ObjDetectOutput output;
+        output.bbox.left = static_cast<int>(std::lround(bbox.left));
+        output.bbox.top = static_cast<int>(std::lround(bbox.top));
+        output.bbox.right = static_cast<int>(std::lround(bbox.right));
+        output.bbox.bottom = static_cast<int>(std::lround(bbox.bottom));
+        output.score = m_confidence;
+        output.label = m_label;
+        output.classId = m_classId;
+        output.trackId = m_id;
+        return output;
+    }
+
+    void toResults(ObjDetectResults& results) const {
+        auto bbox = getBbox();
+        results.push(bbox.left, bbox.top, bbox.right, bbox.bottom, m_confidence, m_classId, m_id);
+    }
+
+    int getId() const { return m_id; }
+    float getConfidence() const { return m_confidence; }
+    int getFramesSinceUpdate() const { return m_framesSinceUpdate; }
+    int getHits() const { return m_hits; }
+    bool isLost() const { return m_lost; }
+
+private:
+    static void toCenter(const bboxRect<float>& bbox, float& cx, float& cy, float& w, float& h) {
+        w = bbox.right - bbox.left;
+        h = bbox.bottom - bbox.top;
+        cx = bbox.left + w / 2.f;
+        cy = bbox.top + h / 2.f;
+    }
+
+private:
+    int m_id;
+    std::string m_label;    // empty for columnar detections, their labels resolve through the label table
+    int m_classId{-1};
+    float m_score;
+    float m_confidence;
+    int m_framesSinceUpdate{0};
+    int m_hits{1};          // matched detections, including the one that started the track
+    bool m_lost{false};     // missed at the last detection frame, coasting frames in between keep it live
+    kalman1D m_filters[4]; // cx, cy, w, h
+};
+
+
+objTracker::objTracker(const ObjTrackParams& params) : m_params{params} {}
+
+objTracker::~objTracker() = default;
+
+void objTracker::reset() {
+    m_tracks.clear();
+    m_detectionFrames = 0;
+}
+
+size_t objTracker::getTrackCount() const {
+    return m_tracks.size();
+}
+
+float objTracker::getMinConfidence() const {
+    float min_confidence = 1.0f;
+    for (const auto& trk : m_tracks) {
+        // a lost track keeps decaying until it ages out, it must not force a detection on every frame
+        if (!trk->isLost()) {
+            min_confidence = std::min(min_confidence, trk->getConfidence());
+        }
+    }
+    return min_confidence;
+}
+
+void objTracker::stepTracks() {
+    for (auto& trk : m_tracks) {
+        trk->predict(m_params.confidence_decay);
+    }
+}
+
+bool objTracker::isReported(const track& trk) const {
+    // lost tracks stay internal until they are matched again or age out, tentative ones until confirmed
+    // unless the tracker itself is still younger than min_hits detection frames
+    return !trk.isLost() && (trk.getHits() >= m_params.min_hits || m_detectionFrames <= m_params.min_hits);
+}
+
+void objTracker::collectTracks(std::vector<ObjDetectOutput>& tracks) const {
+    tracks.clear();
+    tracks.reserve(m_tracks.size());
+    for (const auto& trk : m_tracks) {
+        if (isReported(*trk)) {
+            tracks.push_back(trk->toOutput());
+        }
+    }
+}
+
+void objTracker::collectTracks(ObjDetectResults& tracks) const {
+    tracks.clear();
+    for (const auto& trk : m_tracks) {
+        if (isReported(*trk)) {
+            trk->toResults(tracks);
+        }
+    }
+}
+
+void objTracker::associate(const std::vector<detection>& detections, const std::vector<size_t>& detIndices,
+        std::vector<bool>& trackMatched, std::vector<bool>& detMatched) {
+    // Greedy matching on descending IoU
+    std::vector<std::tuple<float, size_t, size_t>> candidates;
+    for (size_t t = 0; t < m_tracks.size(); t++) {
+        if (trackMatched[t]) {
+            continue;
+        }
+        auto track_bbox = m_tracks[t]->getBbox();
+        for (auto d : detIndices) {
+            if (detMatched[d] || !m_tracks[t]->isSameClass(detections[d])) {
+                continue;
+            }
+            float iou = bbox_utils::calculateOverlap(track_bbox, detections[d].bbox);
+            if (iou >= m_params.iou_threshold) {
+                candidates.emplace_back(iou, t, d);
+            }
+        }
+    }
+
+    std::sort(candidates.begin(), candidates.end(), [](const auto& a, const auto& b) {
+        return std::get<0>(a) > std::get<0>(b);
+    });
+
+    for (const auto& [iou, t, d] : candidates) {
+        if (trackMatched[t] || detMatched[d]) {
+            continue;
+        }
+        m_tracks[t]->correct(detections[d]);
+        trackMatched[t] = true;
+        detMatched[d] = true;
+    }
+}
+
+void objTracker::dropExpired() {
+    m_tracks.erase(std::remove_if(m_tracks.begin(), m_tracks.end(), [this](const std::unique_ptr<track>& trk) {
+        // a tentative track that misses a detection frame is most likely a false positive
+        return trk->getFramesSinceUpdate() > m_params.max_age || (trk->isLost() && trk->getHits() < m_params.min_hits);
+    }), m_tracks.end());
+}
+
+void objTracker::update(const std::vector<ObjDetectOutput>& detections, std::vector<ObjDetectOutput>& tracks) {
+    std::vector<detection> dets;
+    dets.reserve(detections.size());
+    for (const auto& output : detections) {
+        bboxRect<float> bbox{static_cast<float>(output.bbox.left), static_cast<float>(output.bbox.right),
+                static_cast<float>(output.bbox.top), static_cast<float>(output.bbox.bottom)};
+        dets.push_back({bbox, output.score, output.classId, output.label});
+    }
+    updateTracks(dets);
+    collectTracks(tracks);
+}
+
+void objTracker::update(const ObjDetectResults& detections, ObjDetectResults& tracks) {
+    std::vector<detection> dets;
+    dets.reserve(detections.size());
+    for (size_t i = 0; i < detections.size(); i++) {
+        bboxRect<float> bbox{detections.left()[i], detections.right()[i], detections.top()[i], detections.bottom()[i]};
+        dets.push_back({bbox, detections.score()[i], detections.classId()[i], std::string_view{}});
+    }
+    updateTracks(dets);
+    collectTracks(tracks);
+}
+
+void objTracker::updateTracks(const std::vector<detection>& detections) {
+    if (m_detectionFrames <= m_params.min_hits) {
+        m_detectionFrames++;
+    }
+    stepTracks();
+
+    std::vector<size_t> high_dets;
+    std::vector<size_t> low_dets;
+    for (size_t i = 0; i < detections.size(); i++) {
+        if (detections[i].score >= m_params.high_score_threshold) {
+            high_dets.push_back(i);
+        }
+        else {
+            low_dets.push_back(i);
+        }
+    }
+
+    std::vector<bool> track_matched(m_tracks.size(), false);
+    std::vector<bool> det_matched(detections.size(), false);
+    associate(detections, high_dets, track_matched, det_matched);
+    associate(detections, low_dets, track_matched, det_matched);
+    for (size_t t = 0; t < m_tracks.size(); t++) {
+        if (!track_matched[t]) {
+            m_tracks[t]->markLost();
+        }
+    }
+
+    // Drop tracks that have not been seen for too long
+    dropExpired();
+
+    // Start new tracks from unmatched confident detections
+    for (auto d : high_dets) {
+        if (!det_matched[d] && detections[d].score >= m_params.new_track_threshold) {
+            m_tracks.push_back(std::make_unique<track>(m_nextTrackId++, detections[d]));
+        }
+    }
+}
+
+void objTracker::predict(std::vector<ObjDetectOutput>& tracks) {
+    stepTracks();
+    dropExpired();
+    collectTracks(tracks);
+}
+
+void objTracker::predict(ObjDetectResults& tracks) {
+    stepTracks();
+    dropExpired();
+    collectTracks(tracks);
+}
+
+} // namespace dnn_algorithm
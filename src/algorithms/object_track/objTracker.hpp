@@ -0,0 +1,90 @@
+#ifndef __OBJ_TRACKER_HPP__
+#define __OBJ_TRACKER_HPP__
+
+#include "algorithms/object_detect/IDnnObjDetectorPlugin.hpp"
+#include "algorithms/object_detect/objDetectResults.hpp"
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace dnn_algorithm {
+
+struct ObjTrackParams {
+    float iou_threshold{0.3};           // minimum IoU to associate a detection with a track
+    float high_score_threshold{0.5};    // detections above this are associated first (ByteTrack)
+    float new_track_threshold{0.5};     // minimum score to start a new track
+    int max_age{30};                    // frames a track survives without a matched detection
+    int min_hits{3};                    // matched detections before a track is reported
+    float confidence_decay{0.9};        // track confidence factor per frame without a matched detection
+};
+
+/**
+ * @brief SORT/ByteTrack-style multi-object tracker.
+ *
+ * Every track runs a constant-velocity Kalman filter on the box centre and size.
+ * Detections are associated with the predicted tracks by greedy IoU matching of the same class (class id,
+ * or the label for detections without one),
+ * high-score detections first, then low-score detections with the remaining tracks.
+ * Between two detection frames the tracker only predicts, so the detector can run every Nth frame.
+ * A track is reported once confirmed by min_hits detections, and only while the last detection frame matched it.
+ * During the first min_hits detection frames tentative tracks are reported as well (as in SORT), so
+ * enabling the tracker does not blank the first results. A tentative track is dropped on its first miss.
+ */
+class objTracker {
+public:
+    explicit objTracker(const ObjTrackParams& params = ObjTrackParams{});
+    ~objTracker();
+    objTracker(const objTracker&) = delete;
+    objTracker& operator=(const objTracker&) = delete;
+
+    /**
+     * @brief Advance all tracks by one frame and associate the new detections.
+     * @param detections Detections of the current frame.
+     * @param[out] tracks The confirmed tracks matched in this frame (trackId set). Tracks without a match are
+     * kept internally for up to max_age frames and reported again once re-associated.
+     */
+    void update(const std::vector<ObjDetectOutput>& detections, std::vector<ObjDetectOutput>& tracks);
+
+    // Columnar variant, <tracks> is cleared and keeps its label table
+    void update(const ObjDetectResults& detections, ObjDetectResults& tracks);
+
+    /**
+     * @brief Advance all tracks by one frame without detections.
+     * @param[out] tracks The predicted confirmed tracks that were matched at the last detection frame.
+     */
+    void predict(std::vector<ObjDetectOutput>& tracks);
+    void predict(ObjDetectResults& tracks);
+
+    /**
+     * @brief The lowest confidence over the tracks matched at the last detection frame, 1.0 if there are none.
+     * Falls as the tracks coast between detections, lost tracks are not included.
+     */
+    float getMinConfidence() const;
+
+    size_t getTrackCount() const;
+
+    void reset();
+
+private:
+    class track;
+    struct detection;
+
+    void stepTracks();
+    void dropExpired();
+    void updateTracks(const std::vector<detection>& detections);
+    void collectTracks(std::vector<ObjDetectOutput>& tracks) const;
+    void collectTracks(ObjDetectResults& tracks) const;
+    bool isReported(const track& trk) const;
+    void associate(const std::vector<detection>& detections, const std::vector<size_t>& detIndices,
+            std::vector<bool>& trackMatched, std::vector<bool>& detMatched);
+
+private:
+    ObjTrackParams m_params;
+    std::vector<std::unique_ptr<track>> m_tracks;
+    int m_nextTrackId{0};
+    int m_detectionFrames{0};   // update() calls since the last reset, saturates past min_hits
+};
+
+} // namespace dnn_algorithm
+
+#endif // __OBJ_TRACKER_HPP__
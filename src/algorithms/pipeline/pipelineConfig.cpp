@@ -0,0 +1,317 @@
+#include "pipelineConfig.hpp"
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+namespace dnn_algorithm {
+
+namespace {
+
+std::string trim(const std::string& text) {
+    size_t begin = text.find_first_not_of(" \t\r\n");
+    if (begin == std::string::npos) {
+        return "";
+    }
+    size_t end = text.find_last_not_of(" \t\r\n");
+    return text.substr(begin, end - begin + 1);
+}
+
+std::vector<std::string> split(const std::string& text, char delimiter) {
+    std::vector<std::string> parts;
+    std::stringstream stream(text);
+    std::string part;
+    while (std::getline(stream, part, delimiter)) {
+        parts.push_back(trim(part));
+    }
+    return parts;
+}
+
+size_t toSize(const std::string& value, const std::string& where, long minimum = 1) {
+    try {
+        size_t pos = 0;
+        long number = std::stol(value, &pos);
+        if (pos == value.size() && number >= minimum) {
+            return static_cast<size_t>(number);
+        }
+    }
+    catch (const std::exception&) {
+    }
+    throw std::runtime_error(where + ": expected a number >= " + std::to_string(minimum) + ", got \"" + value + "\"");
+}
+
+PipelineEdgeConfig parseEdge(const std::string& text, const std::string& where) {
+    auto fields = split(text, ':');
+    if (fields.empty() || fields[0].empty() || fields.size() > 3) {
+        throw std::runtime_error(where + ": malformed input \"" + text + "\"");
+    }
+    PipelineEdgeConfig edge;
+    edge.from = fields[0];
+    if (fields.size() > 1 && !fields[1].empty()) {
+        edge.queue_size = toSize(fields[1], where);
+    }
+    if (fields.size() > 2) {
+        if (fields[2] == "drop") {
+            edge.drop_oldest = true;
+        }
+        else if (fields[2] != "block") {
+            throw std::runtime_error(where + ": unknown queue policy \"" + fields[2] + "\", expected drop or block");
+        }
+    }
+    return edge;
+}
+
+bool toBool(const std::string& value, bool& result) {
+    if (value == "1" || value == "true" || value == "yes" || value == "on") {
+        result = true;
+        return true;
+    }
+    if (value == "0" || value == "false" || value == "no" || value == "off") {
+        result = false;
+        return true;
+    }
+    return false;
+}
+
+} // namespace
+
+std::string PipelineNodeConfig::getString(const std::string& key, const std::string& defaultVal) const {
+    auto it = options.find(key);
+    return it != options.end() ? it->second : defaultVal;
+}
+
+long PipelineNodeConfig::getInt(const std::string& key, long defaultVal) const {
+    auto it = options.find(key);
+    if (it == options.end()) {
+        return defaultVal;
+    }
+    try {
+        return std::stol(it->second);
+    }
+    catch (const std::exception&) {
+        throw std::invalid_argument("node " + name + ": " + key + " is not an integer: " + it->second);
+    }
+}
+
+float PipelineNodeConfig::getFloat(const std::string& key, float defaultVal) const {
+    auto it = options.find(key);
+    if (it == options.end()) {
+        return defaultVal;
+    }
+    try {
+        return std::stof(it->second);
+    }
+    catch (const std::exception&) {
+        throw std::invalid_argument("node " + name + ": " + key + " is not a number: " + it->second);
+    }
+}
+
+bool PipelineNodeConfig::getBool(const std::string& key, bool defaultVal) const {
+    auto it = options.find(key);
+    if (it == options.end()) {
+        return defaultVal;
+    }
+    bool result = defaultVal;
+    if (!toBool(it->second, result)) {
+        throw std::invalid_argument("node " + name + ": " + key + " is not a boolean: " + it->second);
+    }
+    return result;
+}
+
+PipelineConfig PipelineConfig::load(const std::string& path) {
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        throw std::runtime_error("Failed to open pipeline config: " + path);
+    }
+    std::stringstream text;
+    text << file.rdbuf();
+    return parse(text.str(), path);
+}
+
+PipelineConfig PipelineConfig::parse(const std::string& text, const std::string& source) {
+    PipelineConfig config;
+    enum class Section { None, Model, Node } section = Section::None;
+
+    std::stringstream stream(text);
+    std::string raw;
+    size_t line_number = 0;
+    while (std::getline(stream, raw)) {
+        line_number++;
+        std::string where = source + ":" + std::to_string(line_number);
+        std::string line = trim(raw.substr(0, raw.find_first_of("#;")));
+        if (line.empty()) {
+            continue;
+        }
+
+        if (line.front() == '[') {
+            if (line.back() != ']') {
+                throw std::runtime_error(where + ": unterminated section header");
+            }
+            auto header = split(line.substr(1, line.size() - 2), ' ');
+            header.erase(std::remove(header.begin(), header.end(), ""), header.end());
+            if (header.size() != 2) {
+                throw std::runtime_error(where + ": expected [model <name>] or [node <name>]");
+            }
+            if (header[0] == "model") {
+                if (config.findModel(header[1]) != nullptr) {
+                    throw std::runtime_error(where + ": duplicate model " + header[1]);
+                }
+                config.models.emplace_back();
+                config.models.back().name = header[1];
+                section = Section::Model;
+            }
+            else if (header[0] == "node") {
+                if (config.findNode(header[1]) != nullptr) {
+                    throw std::runtime_error(where + ": duplicate node " + header[1]);
+                }
+                config.nodes.emplace_back();
+                config.nodes.back().name = header[1];
+                section = Section::Node;
+            }
+            else {
+                throw std::runtime_error(where + ": unknown section type " + header[0]);
+            }
+            continue;
+        }
+
+        size_t equals = line.find('=');
+        if (equals == std::string::npos) {
+            throw std::runtime_error(where + ": expected key = value");
+        }
+        std::string key = trim(line.substr(0, equals));
+        std::string value = trim(line.substr(equals + 1));
+
+        if (section == Section::Model) {
+            auto* model = &config.models.back();
+            if (key == "task") {
+                if (value != "detect" && value != "classify") {
+                    throw std::runtime_error(where + ": unknown task " + value + ", expected detect or classify");
+                }
+                model->task = value;
+            }
+            else if (key == "dnnType") {
+                model->dnn_type = value;
+            }
+            else if (key == "plugin") {
+                model->plugin_path = value;
+            }
+            else if (key == "labels") {
+                model->label_path = value;
+            }
+            else if (key == "path") {
+                model->model_path = value;
+            }
+            else if (key == "contexts") {
+                model->contexts = toSize(value, where);
+            }
+            else if (key == "warmup") {
+                model->warmup_runs = static_cast<int>(toSize(value, where, 0));
+            }
+            else {
+                throw std::runtime_error(where + ": unknown model key " + key);
+            }
+        }
+        else if (section == Section::Node) {
+            auto* node = &config.nodes.back();
+            if (key == "type") {
+                node->type = value;
+            }
+            else if (key == "threads") {
+                node->threads = toSize(value, where);
+            }
+            else if (key == "ordered") {
+                bool ordered = false;
+                if (!toBool(value, ordered)) {
+                    throw std::runtime_error(where + ": ordered is not a boolean: " + value);
+                }
+                node->ordered = ordered ? 1 : 0;
+            }
+            else if (key == "inputs") {
+                for (const auto& input : split(value, ',')) {
+                    if (!input.empty()) {
+                        node->inputs.push_back(parseEdge(input, where));
+                    }
+                }
+            }
+            else {
+                node->options[key] = value;
+            }
+        }
+        else {
+            throw std::runtime_error(where + ": key outside of a section");
+        }
+    }
+
+    for (const auto& m : config.models) {
+        if (m.model_path.empty()) {
+            throw std::runtime_error(source + ": model " + m.name + " has no path");
+        }
+    }
+    for (const auto& n : config.nodes) {
+        if (n.type.empty()) {
+            throw std::runtime_error(source + ": node " + n.name + " has no type");
+        }
+        for (const auto& edge : n.inputs) {
+            if (config.findNode(edge.from) == nullptr) {
+                throw std::runtime_error(source + ": node " + n.name + " reads from unknown node " + edge.from);
+            }
+            if (edge.from == n.name) {
+                throw std::runtime_error(source + ": node " + n.name + " reads from itself");
+            }
+        }
+    }
+
+    // Kahn's algorithm, the nodes left over are on a cycle
+    std::vector<size_t> pending(config.nodes.size(), 0);
+    for (size_t i = 0; i < config.nodes.size(); i++) {
+        pending[i] = config.nodes[i].inputs.size();
+    }
+    std::vector<size_t> ready;
+    for (size_t i = 0; i < config.nodes.size(); i++) {
+        if (pending[i] == 0) {
+            ready.push_back(i);
+        }
+    }
+    while (!ready.empty()) {
+        size_t current = ready.front();
+        ready.erase(ready.begin());
+        config.order.push_back(current);
+        for (size_t i = 0; i < config.nodes.size(); i++) {
+            for (const auto& edge : config.nodes[i].inputs) {
+                if (edge.from == config.nodes[current].name && --pending[i] == 0) {
+                    ready.push_back(i);
+                }
+            }
+        }
+    }
+    if (config.order.size() != config.nodes.size()) {
+        std::string cycle;
+        for (size_t i = 0; i < config.nodes.size(); i++) {
+            if (pending[i] > 0) {
+                cycle += (cycle.empty() ? "" : ", ") + config.nodes[i].name;
+            }
+        }
+        throw std::runtime_error(source + ": the graph has a cycle through " + cycle);
+    }
+    return config;
+}
+
+const PipelineModelConfig* PipelineConfig::findModel(const std::string& name) const {
+    for (const auto& model : models) {
+        if (model.name == name) {
+            return &model;
+        }
+    }
+    return nullptr;
+}
+
+const PipelineNodeConfig* PipelineConfig::findNode(const std::string& name) const {
+    for (const auto& node : nodes) {
+        if (node.name == name) {
+            return &node;
+        }
+    }
+    return nullptr;
+}
+
+} // namespace dnn_algorithm
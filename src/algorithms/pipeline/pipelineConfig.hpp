@@ -0,0 +1,69 @@
+#ifndef __PIPELINE_CONFIG_HPP__
+#define __PIPELINE_CONFIG_HPP__
+
+#include <cstddef>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace dnn_algorithm {
+
+// A model shared by the nodes that name it
+struct PipelineModelConfig {
+    std::string name{};
+    std::string task{"detect"};     // "detect" or "classify"
+    std::string dnn_type{"rknn"};
+    std::string plugin_path{};
+    std::string label_path{};
+    std::string model_path{};
+    size_t contexts{1};             // engine contexts, the nodes using the model run at most this many threads
+    int warmup_runs{1};
+};
+
+// An edge from <from> into the node that lists it
+struct PipelineEdgeConfig {
+    std::string from{};
+    size_t queue_size{4};
+    bool drop_oldest{false};        // shed the oldest frame when full instead of blocking the producer
+};
+
+struct PipelineNodeConfig {
+    std::string name{};
+    std::string type{};
+    size_t threads{1};
+    int ordered{-1};                // -1: the default of the stage
+    std::vector<PipelineEdgeConfig> inputs{};
+    std::map<std::string, std::string> options{};   // the remaining keys, interpreted by the stage
+
+    bool hasOption(const std::string& key) const { return options.count(key) != 0; }
+    std::string getString(const std::string& key, const std::string& defaultVal = "") const;
+    // @throw std::invalid_argument if the value is not a number
+    long getInt(const std::string& key, long defaultVal) const;
+    float getFloat(const std::string& key, float defaultVal) const;
+    bool getBool(const std::string& key, bool defaultVal) const;
+};
+
+/**
+ * A pipeline graph as written in its config file.
+ *
+ * The file is ini-like: "[model <name>]" and "[node <name>]" sections of "key = value" lines, '#' and ';'
+ * start comments. A node lists its upstream nodes as "inputs = <node>[:<queue size>[:drop]], ...".
+ * load() checks that the graph is a DAG and fills <order> with a topological order of the nodes.
+ */
+struct PipelineConfig {
+    std::vector<PipelineModelConfig> models{};
+    std::vector<PipelineNodeConfig> nodes{};
+    std::vector<size_t> order{};    // indices into <nodes>, every node after its inputs
+
+    // @throw std::runtime_error with the file and line of the error
+    static PipelineConfig load(const std::string& path);
+    static PipelineConfig parse(const std::string& text, const std::string& source = "<string>");
+
+    // nullptr if there is no such model / node
+    const PipelineModelConfig* findModel(const std::string& name) const;
+    const PipelineNodeConfig* findNode(const std::string& name) const;
+};
+
+} // namespace dnn_algorithm
+
+#endif // __PIPELINE_CONFIG_HPP__
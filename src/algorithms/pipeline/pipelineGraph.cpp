@@ -0,0 +1,429 @@
+#include "pipelineGraph.hpp"
+#include <algorithm>
+#include <chrono>
+#include <stdexcept>
+
+namespace dnn_algorithm {
+
+frameInbox::frameInbox(const std::vector<LaneParams>& lanes, bool ordered) : m_lanes(lanes.size()), m_ordered{ordered} {
+    for (size_t i = 0; i < lanes.size(); i++) {
+        m_lanes[i].params = lanes[i];
+        m_lanes[i].params.capacity = std::max<size_t>(1, lanes[i].capacity);
+    }
+}
+
+std::deque<std::unique_ptr<PipelineFrame>>& frameInbox::queueOf(lane& target, size_t source) {
+    return m_ordered ? m_orders[source].ready : target.frames;
+}
+
+bool frameInbox::makeRoom(lane& target, std::deque<std::unique_ptr<PipelineFrame>>& queue, std::unique_lock<std::mutex>& lock) {
+    while (!m_stopped && target.live >= target.params.capacity) {
+        if (!target.params.dropOldest) {
+            m_notFull.wait(lock);
+            continue;
+        }
+        auto oldest = std::find_if(queue.begin(), queue.end(), [](const auto& queued) { return !queued->skipped; });
+        if (oldest == queue.end()) {
+            // the live frames belong to other sources of an ordered inbox, over the limit rather than out of order
+            break;
+        }
+        (*oldest)->shed();
+        target.live--;
+        m_shed++;
+    }
+    return !m_stopped;
+}
+
+bool frameInbox::push(size_t laneIndex, std::unique_ptr<PipelineFrame> frame) {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    if (m_stopped) {
+        return false;
+    }
+    auto& target = m_lanes[laneIndex];
+    size_t source = frame->source;
+    if (m_ordered) {
+        auto& order = m_orders[source];
+        if (frame->sequence != order.next + order.ready.size()) {
+            // ahead of a gap, waits outside the limit so the frame filling the gap is never blocked behind it
+            uint64_t sequence = frame->sequence;
+            order.early.emplace(sequence, std::move(frame));
+            m_size++;
+            m_maxSize = std::max(m_maxSize, m_size);
+            return true;
+        }
+    }
+
+    auto& queue = queueOf(target, source);
+    if (!frame->skipped) {
+        if (!makeRoom(target, queue, lock)) {
+            return false;
+        }
+        target.live++;
+    }
+    queue.push_back(std::move(frame));
+    m_size++;
+    if (m_ordered) {
+        auto& order = m_orders[source];
+        while (!order.early.empty() && order.early.begin()->first == order.next + order.ready.size()) {
+            auto& early = order.early.begin()->second;
+            target.live += early->skipped ? 0 : 1;
+            order.ready.push_back(std::move(early));
+            order.early.erase(order.early.begin());
+        }
+    }
+    m_maxSize = std::max(m_maxSize, m_size);
+    m_notEmpty.notify_all();
+    return true;
+}
+
+bool frameInbox::takeNext(std::unique_ptr<PipelineFrame>& frame) {
+    if (m_ordered) {
+        // round robin over the sources
+        size_t count = m_orders.size();
+        for (size_t i = 0; i < count; i++) {
+            auto it = std::next(m_orders.begin(), static_cast<long>((m_nextLane + i) % count));
+            auto& order = it->second;
+            if (order.ready.empty()) {
+                continue;
+            }
+            frame = std::move(order.ready.front());
+            order.ready.pop_front();
+            order.next++;
+            m_lanes[0].live -= frame->skipped ? 0 : 1;
+            m_nextLane = (m_nextLane + i + 1) % count;
+            m_size--;
+            return true;
+        }
+        return false;
+    }
+
+    for (size_t i = 0; i < m_lanes.size(); i++) {
+        auto& target = m_lanes[(m_nextLane + i) % m_lanes.size()];
+        if (target.frames.empty()) {
+            continue;
+        }
+        frame = std::move(target.frames.front());
+        target.frames.pop_front();
+        target.live -= frame->skipped ? 0 : 1;
+        m_nextLane = (m_nextLane + i + 1) % m_lanes.size();
+        m_size--;
+        return true;
+    }
+    return false;
+}
+
+bool frameInbox::allClosed() const {
+    return std::all_of(m_lanes.begin(), m_lanes.end(), [](const lane& target) { return target.closed; });
+}
+
+bool frameInbox::pop(std::unique_ptr<PipelineFrame>& frame) {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (!m_stopped) {
+        if (takeNext(frame)) {
+            m_notFull.notify_all();
+            return true;
+        }
+        if (allClosed()) {
+            // the producers are gone, a gap left by a discarded frame will not be filled any more
+            bool released = false;
+            for (auto& [source, order] : m_orders) {
+                if (order.ready.empty() && !order.early.empty()) {
+                    order.next = order.early.begin()->first;
+                    while (!order.early.empty() && order.early.begin()->first == order.next + order.ready.size()) {
+                        m_lanes[0].live += order.early.begin()->second->skipped ? 0 : 1;
+                        order.ready.push_back(std::move(order.early.begin()->second));
+                        order.early.erase(order.early.begin());
+                    }
+                    released = true;
+                }
+            }
+            if (!released) {
+                return false;
+            }
+            continue;
+        }
+        m_notEmpty.wait(lock);
+    }
+    return false;
+}
+
+void frameInbox::closeLane(size_t laneIndex) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_lanes[laneIndex].closed = true;
+    m_notEmpty.notify_all();
+}
+
+void frameInbox::stop() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_stopped = true;
+    m_notEmpty.notify_all();
+    m_notFull.notify_all();
+}
+
+size_t frameInbox::size() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_size;
+}
+
+size_t frameInbox::getMaxSize() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_maxSize;
+}
+
+uint64_t frameInbox::getShed() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_shed;
+}
+
+size_t frameInbox::getQueuedBytes() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    size_t bytes = 0;
+    for (const auto& target : m_lanes) {
+        for (const auto& frame : target.frames) {
+            bytes += frame->getMemoryBytes();
+        }
+    }
+    for (const auto& order : m_orders) {
+        for (const auto& frame : order.second.ready) {
+            bytes += frame->getMemoryBytes();
+        }
+        for (const auto& early : order.second.early) {
+            bytes += early.second->getMemoryBytes();
+        }
+    }
+    return bytes;
+}
+
+pipelineGraph::pipelineGraph(const PipelineConfig& config) : m_logger{std::make_unique<Logger>("pipelineGraph")} {
+    m_models = std::make_unique<pipelineModels>(config.models);
+
+    std::map<std::string, node*> byName;
+    // number of paths from each source to a node
+    std::map<std::string, std::map<size_t, size_t>> reach;
+    // ModelUse bits of the nodes running each model
+    std::map<std::string, std::vector<std::pair<unsigned, std::string>>> modelUsers;
+    size_t sources = 0;
+    for (size_t index : config.order) {
+        const auto& nodeConfig = config.nodes[index];
+        const std::string where = "node " + nodeConfig.name;
+        auto current = std::make_unique<node>();
+        current->config = nodeConfig;
+        current->stage = IPipelineStage::create(nodeConfig, *m_models);
+
+        bool source = current->stage->isSource();
+        if (source && !nodeConfig.inputs.empty()) {
+            throw std::invalid_argument(where + ": a " + nodeConfig.type + " node takes no inputs");
+        }
+        if (!source && nodeConfig.inputs.empty()) {
+            throw std::invalid_argument(where + " has no inputs");
+        }
+        if (nodeConfig.threads > current->stage->getMaxThreads()) {
+            throw std::invalid_argument(where + " runs at most " + std::to_string(current->stage->getMaxThreads())
+                + " threads (model contexts, or a stateful stage)");
+        }
+        // worker i of every node runs instance i of the model: two nodes running the same part of it would
+        // use one instance concurrently
+        unsigned use = current->stage->getModelUse();
+        if (use != 0) {
+            auto& users = modelUsers[current->stage->getModel()];
+            for (const auto& [other_use, other] : users) {
+                if ((other_use & use) != 0) {
+                    throw std::invalid_argument(where + " and node " + other + " run the same stage of model "
+                        + current->stage->getModel() + ", declare a model section for each");
+                }
+            }
+            users.emplace_back(use, nodeConfig.name);
+        }
+        bool ordered = nodeConfig.ordered < 0 ? current->stage->isStateful() : nodeConfig.ordered == 1;
+        if (ordered && nodeConfig.inputs.size() > 1) {
+            throw std::invalid_argument(where + ": an ordered node takes one input");
+        }
+
+        std::vector<frameInbox::LaneParams> lanes;
+        auto& paths = reach[nodeConfig.name];
+        if (source) {
+            current->sourceIndex = sources++;
+            lanes.push_back({nodeConfig.threads * 2, false});
+            paths[current->sourceIndex] = 1;
+        }
+        for (size_t lane = 0; lane < nodeConfig.inputs.size(); lane++) {
+            const auto& edge = nodeConfig.inputs[lane];
+            node* upstream = byName.at(edge.from);
+            upstream->outputs.emplace_back(current.get(), lane);
+            lanes.push_back({edge.queue_size, edge.drop_oldest});
+            for (const auto& [from, count] : reach[edge.from]) {
+                paths[from] += count;
+            }
+        }
+        for (const auto& [from, count] : paths) {
+            if (count > 1) {
+                throw std::invalid_argument(where + ": the frames of a source arrive over " + std::to_string(count) + " paths");
+            }
+        }
+        current->inbox = std::make_unique<frameInbox>(lanes, ordered);
+        byName[nodeConfig.name] = current.get();
+        m_nodes.push_back(std::move(current));
+    }
+    if (sources == 0) {
+        throw std::invalid_argument("The pipeline has no source node");
+    }
+}
+
+pipelineGraph::~pipelineGraph() {
+    stop();
+}
+
+void pipelineGraph::start() {
+    if (m_started) {
+        return;
+    }
+    m_started = true;
+    for (auto& current : m_nodes) {
+        current->running = current->config.threads;
+        for (size_t worker = 0; worker < current->config.threads; worker++) {
+            current->workers.emplace_back(&pipelineGraph::runWorker, this, std::ref(*current), worker);
+        }
+    }
+    for (auto& current : m_nodes) {
+        if (current->stage->isSource()) {
+            current->producer = std::thread(&pipelineGraph::runProducer, this, std::ref(*current));
+        }
+    }
+    m_logger->printStdoutLog(Logger::LogLevel::Info, "started {} nodes", m_nodes.size());
+}
+
+void pipelineGraph::wait() {
+    join();
+}
+
+void pipelineGraph::stop() {
+    for (auto& current : m_nodes) {
+        current->inbox->stop();
+    }
+    join();
+}
+
+bool pipelineGraph::isDone() const {
+    return m_started && std::all_of(m_nodes.begin(), m_nodes.end(),
+        [](const std::unique_ptr<node>& current) { return current->running == 0; });
+}
+
+void pipelineGraph::join() {
+    // upstream first, every node finishes once its inputs are closed
+    for (auto& current : m_nodes) {
+        if (current->producer.joinable()) {
+            current->producer.join();
+        }
+        for (auto& worker : current->workers) {
+            if (worker.joinable()) {
+                worker.join();
+            }
+        }
+        current->workers.clear();
+    }
+}
+
+void pipelineGraph::runProducer(node& source) {
+    // the producer only paces the source, the decoding runs on the workers
+    CpuAffinity::applyToCurrentThread(CpuAffinity::Stage::IO);
+    uint64_t sequence = 0;
+    while (true) {
+        auto frame = std::make_unique<PipelineFrame>();
+        bool more = false;
+        try {
+            more = source.stage->produce(*frame);
+        }
+        catch (const std::exception& e) {
+            m_logger->printStdoutLog(Logger::LogLevel::Error, "node {}: {}", source.config.name, e.what());
+        }
+        if (!more) {
+            break;
+        }
+        frame->source = source.sourceIndex;
+        frame->sequence = sequence++;
+        if (!source.inbox->push(0, std::move(frame))) {
+            break;
+        }
+    }
+    source.inbox->closeLane(0);
+}
+
+void pipelineGraph::runWorker(node& current, size_t worker) {
+    CpuAffinity::applyToCurrentThread(current.stage->getCpuStage());
+    std::unique_ptr<PipelineFrame> frame;
+    while (current.inbox->pop(frame)) {
+        if (frame->skipped) {
+            current.passed++;
+            forward(current, std::move(frame));
+            continue;
+        }
+
+        auto begin = std::chrono::steady_clock::now();
+        int ret = -1;
+        try {
+            ret = current.stage->process(*frame, worker);
+        }
+        catch (const std::exception& e) {
+            m_logger->printStdoutLog(Logger::LogLevel::Error, "node {}: {}", current.config.name, e.what());
+        }
+        current.busyNs += static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - begin).count());
+        if (ret != 0) {
+            (ret < 0 ? current.errors : current.skipped)++;
+            // downstream only needs the header
+            frame->shed();
+        }
+        else {
+            current.processed++;
+        }
+        forward(current, std::move(frame));
+    }
+
+    if (--current.running == 0) {
+        current.stage->finish();
+        for (auto& [downstream, lane] : current.outputs) {
+            downstream->inbox->closeLane(lane);
+        }
+    }
+}
+
+void pipelineGraph::forward(node& current, std::unique_ptr<PipelineFrame> frame) {
+    for (size_t i = 0; i < current.outputs.size(); i++) {
+        auto& [downstream, lane] = current.outputs[i];
+        if (i + 1 == current.outputs.size()) {
+            downstream->inbox->push(lane, std::move(frame));
+        }
+        else {
+            downstream->inbox->push(lane, std::make_unique<PipelineFrame>(*frame));
+        }
+    }
+}
+
+std::vector<PipelineNodeStats> pipelineGraph::getStats() const {
+    std::vector<PipelineNodeStats> stats;
+    for (const auto& current : m_nodes) {
+        PipelineNodeStats node_stats;
+        node_stats.name = current->config.name;
+        node_stats.type = current->config.type;
+        node_stats.threads = current->config.threads;
+        node_stats.processed = current->processed;
+        node_stats.skipped = current->skipped;
+        node_stats.errors = current->errors;
+        node_stats.passed = current->passed;
+        node_stats.shed = current->inbox->getShed();
+        node_stats.queued = current->inbox->size();
+        node_stats.maxQueued = current->inbox->getMaxSize();
+        node_stats.busyMs = static_cast<float>(current->busyNs.load()) / 1e6f;
+        stats.push_back(node_stats);
+    }
+    return stats;
+}
+
+void pipelineGraph::reportMemory(MemoryReport& report, const std::string& prefix) const {
+    m_models->reportMemory(report, prefix + ".models");
+    for (const auto& current : m_nodes) {
+        report.add(prefix + "." + current->config.name + ".queue", current->inbox->getQueuedBytes());
+    }
+}
+
+} // namespace dnn_algorithm
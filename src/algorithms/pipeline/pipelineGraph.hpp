@@ -0,0 +1,175 @@
+#ifndef __PIPELINE_GRAPH_HPP__
+#define __PIPELINE_GRAPH_HPP__
+
+#include "pipelineConfig.hpp"
+#include "pipelineStages.hpp"
+#include "common/Logger.hpp"
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace dnn_algorithm {
+
+struct PipelineNodeStats {
+    std::string name{};
+    std::string type{};
+    size_t threads{0};
+    uint64_t processed{0};
+    uint64_t skipped{0};        // filtered by the stage (motion gate)
+    uint64_t errors{0};
+    uint64_t passed{0};         // arrived skipped and forwarded untouched
+    uint64_t shed{0};           // shed by an input queue with the drop policy
+    size_t queued{0};           // frames waiting in the input queues
+    size_t maxQueued{0};
+    float busyMs{0.f};          // processing time summed over the workers
+};
+
+/**
+ * Input queues of a node, one bounded lane per incoming edge.
+ *
+ * A full lane blocks the producer, or with the drop policy sheds its oldest frame: the payload is released and
+ * the header is forwarded as skipped, so the downstream nodes still see every sequence number.
+ * Frames marked skipped do not count against the limit. An ordered inbox (one lane) hands out the frames of each
+ * source in sequence order; frames arriving ahead of a gap wait outside the limit until their predecessors arrive.
+ */
+class frameInbox {
+public:
+    struct LaneParams {
+        size_t capacity{4};
+        bool dropOldest{false};
+    };
+
+    frameInbox(const std::vector<LaneParams>& lanes, bool ordered);
+
+    frameInbox(const frameInbox&) = delete;
+    frameInbox& operator=(const frameInbox&) = delete;
+
+    // false once stopped, the frame is discarded then
+    bool push(size_t lane, std::unique_ptr<PipelineFrame> frame);
+
+    // Blocks for the next frame, false once every lane is closed and drained, or when stopped
+    bool pop(std::unique_ptr<PipelineFrame>& frame);
+
+    // The producer of the lane is done
+    void closeLane(size_t lane);
+
+    // Wake up every blocked caller, push and pop fail from now on
+    void stop();
+
+    size_t size() const;
+    size_t getMaxSize() const;
+    uint64_t getShed() const;
+    // Payload of the frames waiting, see PipelineFrame::getMemoryBytes
+    size_t getQueuedBytes() const;
+
+private:
+    struct lane {
+        LaneParams params{};
+        std::deque<std::unique_ptr<PipelineFrame>> frames{};    // unordered inbox
+        size_t live{0};                                         // frames not skipped
+        bool closed{false};
+    };
+
+    // Frames of one source in an ordered inbox
+    struct sourceOrder {
+        uint64_t next{0};                                       // sequence of ready.front()
+        std::deque<std::unique_ptr<PipelineFrame>> ready{};     // contiguous from <next>
+        std::map<uint64_t, std::unique_ptr<PipelineFrame>> early{};
+    };
+
+    std::deque<std::unique_ptr<PipelineFrame>>& queueOf(lane& target, size_t source);
+    // Called with m_mutex held, false if stopped while waiting for room
+    bool makeRoom(lane& target, std::deque<std::unique_ptr<PipelineFrame>>& queue, std::unique_lock<std::mutex>& lock);
+    bool takeNext(std::unique_ptr<PipelineFrame>& frame);
+    bool allClosed() const;
+
+private:
+    mutable std::mutex m_mutex;
+    std::condition_variable m_notEmpty;
+    std::condition_variable m_notFull;
+    std::vector<lane> m_lanes;
+    bool m_ordered;
+    std::map<size_t, sourceOrder> m_orders{};
+    size_t m_nextLane{0};
+    size_t m_size{0};
+    size_t m_maxSize{0};
+    uint64_t m_shed{0};
+    bool m_stopped{false};
+};
+
+/**
+ * Runs a PipelineConfig: every node gets <threads> workers reading its inbox, frames leaving a node are handed
+ * to each downstream node (copied on fan-out). Source nodes run an extra producer thread.
+ *
+ * Ordered nodes (the default for stateful stages such as track and sink) see the frames of each source in
+ * sequence order. A frame reaches a node at most once: graphs where a source reaches a node over two paths
+ * are rejected, as are graphs where two nodes run the same stage of one model (see IPipelineStage::ModelUse).
+ */
+class pipelineGraph {
+public:
+    // Loads the models and creates the stages. @throw std::runtime_error / std::invalid_argument on an invalid graph.
+    explicit pipelineGraph(const PipelineConfig& config);
+    ~pipelineGraph();
+
+    pipelineGraph(const pipelineGraph&) = delete;
+    pipelineGraph& operator=(const pipelineGraph&) = delete;
+
+    void start();
+
+    // Blocks until the sources are exhausted and every frame has left the graph
+    void wait();
+
+    // Stop the sources and the workers, the frames in flight are discarded
+    void stop();
+
+    // true once every node has finished, wait() returns without blocking then
+    bool isDone() const;
+
+    std::vector<PipelineNodeStats> getStats() const;
+
+    /**
+     * @brief Add the models as <prefix>.models.<model>.<i> and the input queue of every node as
+     * <prefix>.<node>.queue. Call it before start() or once wait() or stop() returned, the models are not locked.
+     */
+    void reportMemory(MemoryReport& report, const std::string& prefix = "pipeline") const;
+
+private:
+    struct node {
+        PipelineNodeConfig config{};
+        std::unique_ptr<IPipelineStage> stage{nullptr};
+        std::unique_ptr<frameInbox> inbox{nullptr};
+        std::vector<std::pair<node*, size_t>> outputs{};    // downstream node and its lane
+        size_t sourceIndex{0};
+        std::thread producer{};
+        std::vector<std::thread> workers{};
+        std::atomic<size_t> running{0};
+        std::atomic<uint64_t> processed{0};
+        std::atomic<uint64_t> skipped{0};
+        std::atomic<uint64_t> errors{0};
+        std::atomic<uint64_t> passed{0};
+        std::atomic<uint64_t> busyNs{0};
+    };
+
+    void runProducer(node& source);
+    void runWorker(node& current, size_t worker);
+    void forward(node& current, std::unique_ptr<PipelineFrame> frame);
+    void join();
+
+private:
+    std::unique_ptr<Logger> m_logger;
+    std::unique_ptr<pipelineModels> m_models;
+    std::vector<std::unique_ptr<node>> m_nodes{};   // in topological order
+    bool m_started{false};
+};
+
+} // namespace dnn_algorithm
+
+#endif // __PIPELINE_GRAPH_HPP__
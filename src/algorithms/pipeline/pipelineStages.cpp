@@ -0,0 +1,587 @@
+#include "pipelineStages.hpp"
+#include "algorithms/object_detect/imageDecoder.hpp"
+#include "algorithms/object_detect/imageTiler.hpp"
+#include "algorithms/object_detect/motionGate.hpp"
+#include "algorithms/object_track/objTracker.hpp"
+#include "algorithms/result_log/resultLogWriter.hpp"
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <dirent.h>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <sys/stat.h>
+#include <thread>
+#include <unordered_map>
+
+namespace dnn_algorithm {
+
+PipelineFrame::PipelineFrame(const PipelineFrame& other) :
+        source{other.source},
+        sequence{other.sequence},
+        streamId{other.streamId},
+        timestampNs{other.timestampNs},
+        sourcePath{other.sourcePath},
+        skipped{other.skipped},
+        input{other.input},
+        origWidth{other.origWidth},
+        origHeight{other.origHeight},
+        params{other.params},
+        tensor{other.tensor},
+        dnnOutputs{other.dnnOutputs},
+        dnnOutputStorage{other.dnnOutputStorage},
+        detections{other.detections},
+        classes{other.classes} {
+    if (dnnOutputStorage.size() == dnnOutputs.size()) {
+        for (size_t i = 0; i < dnnOutputs.size(); i++) {
+            dnnOutputs[i].buf = dnnOutputStorage[i].data();
+        }
+    }
+}
+
+void PipelineFrame::shed() {
+    skipped = true;
+    input.reset();
+    tensor = IDnnEngine::dnnInput{};
+    dnnOutputs.clear();
+    dnnOutputStorage.clear();
+    detections.clear();
+    classes.clear();
+}
+
+size_t PipelineFrame::getMemoryBytes() const {
+    size_t bytes = sizeof(PipelineFrame) + tensor.buf.capacity()
+        + detections.capacity() * sizeof(ObjDetectOutput) + classes.capacity() * sizeof(ObjClassifyOutput);
+    if (input != nullptr) {
+        bytes += imageTiler::getFrameBytes(*input);
+    }
+    for (const auto& storage : dnnOutputStorage) {
+        bytes += storage.capacity();
+    }
+    return bytes;
+}
+
+pipelineModels::pipelineModels(const std::vector<PipelineModelConfig>& models) {
+    for (const auto& model : models) {
+        if (model.task == "classify") {
+            auto& instances = m_classifiers[model.name];
+            for (size_t i = 0; i < model.contexts; i++) {
+                auto classifier = std::make_unique<dnnObjClassifier>(model.dnn_type, model.plugin_path, model.label_path);
+                classifier->loadModel(model.model_path);
+                instances.push_back(std::move(classifier));
+            }
+        }
+        else {
+            auto& instances = m_detectors[model.name];
+            for (size_t i = 0; i < model.contexts; i++) {
+                // the registry loads the model once, the further instances get engine clones
+                instances.push_back(dnnObjDetector::create(model.dnn_type, model.plugin_path, model.label_path,
+                    model.model_path, model.warmup_runs));
+            }
+        }
+    }
+}
+
+dnnObjDetector& pipelineModels::detector(const std::string& name, size_t worker) {
+    auto it = m_detectors.find(name);
+    if (it == m_detectors.end()) {
+        throw std::invalid_argument("No detection model named " + name);
+    }
+    return *it->second[worker % it->second.size()];
+}
+
+dnnObjClassifier& pipelineModels::classifier(const std::string& name, size_t worker) {
+    auto it = m_classifiers.find(name);
+    if (it == m_classifiers.end()) {
+        throw std::invalid_argument("No classification model named " + name);
+    }
+    return *it->second[worker % it->second.size()];
+}
+
+size_t pipelineModels::getContexts(const std::string& name) const {
+    auto detectors = m_detectors.find(name);
+    if (detectors != m_detectors.end()) {
+        return detectors->second.size();
+    }
+    auto classifiers = m_classifiers.find(name);
+    return classifiers != m_classifiers.end() ? classifiers->second.size() : 0;
+}
+
+void pipelineModels::reportMemory(MemoryReport& report, const std::string& prefix) const {
+    for (const auto& model : m_detectors) {
+        for (size_t i = 0; i < model.second.size(); i++) {
+            model.second[i]->reportMemory(report, prefix + "." + model.first + "." + std::to_string(i));
+        }
+    }
+    for (const auto& model : m_classifiers) {
+        for (size_t i = 0; i < model.second.size(); i++) {
+            model.second[i]->reportMemory(report, prefix + "." + model.first + "." + std::to_string(i));
+        }
+    }
+}
+
+namespace {
+
+uint64_t wallClockNs() {
+    auto now = std::chrono::system_clock::now().time_since_epoch();
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(now).count());
+}
+
+bool isImageFile(const std::string& name) {
+    size_t dot = name.rfind('.');
+    if (dot == std::string::npos) {
+        return false;
+    }
+    std::string ext = name.substr(dot + 1);
+    std::transform(ext.begin(), ext.end(), ext.begin(), [](unsigned char c) { return std::tolower(c); });
+    return ext == "jpg" || ext == "jpeg" || ext == "png" || ext == "bmp";
+}
+
+// A directory (its image files, sorted) or a comma separated list of files
+std::vector<std::string> listImages(const std::string& images) {
+    std::vector<std::string> paths;
+    struct stat st;
+    if (stat(images.c_str(), &st) == 0 && S_ISDIR(st.st_mode)) {
+        DIR* dir = opendir(images.c_str());
+        if (dir != nullptr) {
+            while (dirent* entry = readdir(dir)) {
+                std::string name = entry->d_name;
+                if (isImageFile(name)) {
+                    paths.push_back(images + "/" + name);
+                }
+            }
+            closedir(dir);
+        }
+        std::sort(paths.begin(), paths.end());
+        return paths;
+    }
+    std::stringstream stream(images);
+    std::string path;
+    while (std::getline(stream, path, ',')) {
+        path.erase(0, path.find_first_not_of(" \t"));
+        path.erase(path.find_last_not_of(" \t") + 1);
+        if (!path.empty()) {
+            paths.push_back(path);
+        }
+    }
+    return paths;
+}
+
+void writeJsonString(std::string& out, const std::string& value) {
+    out += '"';
+    for (char c : value) {
+        if (c == '"' || c == '\\') {
+            out += '\\';
+            out += c;
+        }
+        else if (static_cast<unsigned char>(c) < 0x20) {
+            char escaped[8];
+            std::snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+            out += escaped;
+        }
+        else {
+            out += c;
+        }
+    }
+    out += '"';
+}
+
+std::string requireOption(const PipelineNodeConfig& node, const std::string& key) {
+    std::string value = node.getString(key);
+    if (value.empty()) {
+        throw std::invalid_argument("node " + node.name + " (" + node.type + ") needs the option " + key);
+    }
+    return value;
+}
+
+// Stages running on a model are bounded by its contexts
+class modelStage : public IPipelineStage {
+public:
+    modelStage(const PipelineNodeConfig& node, pipelineModels& models) :
+        m_models{models},
+        m_model{requireOption(node, "model")},
+        m_contexts{models.getContexts(m_model)} {
+        if (m_contexts == 0) {
+            throw std::invalid_argument("node " + node.name + " uses the unknown model " + m_model);
+        }
+    }
+
+    size_t getMaxThreads() const override { return m_contexts; }
+    std::string getModel() const override { return m_model; }
+    unsigned getModelUse() const override { return UseAll; }
+
+protected:
+    pipelineModels& m_models;
+    std::string m_model;
+    size_t m_contexts;
+};
+
+/**
+ * Source node: reads image files, from a directory or a list.
+ * Options: images, repeat (passes over the list, 0 = endless), fps (0 = as fast as the queues allow),
+ * stream, model (decode at the smallest DCT scale for its input) or width / height.
+ */
+class decodeStage : public IPipelineStage {
+public:
+    decodeStage(const PipelineNodeConfig& node, pipelineModels& models) :
+        m_paths{listImages(requireOption(node, "images"))},
+        m_repeat{node.getInt("repeat", 1)},
+        m_streamId{static_cast<int>(node.getInt("stream", 0))},
+        m_width{static_cast<size_t>(node.getInt("width", 640))},
+        m_height{static_cast<size_t>(node.getInt("height", 640))} {
+        if (m_paths.empty()) {
+            throw std::invalid_argument("node " + node.name + ": no images in " + node.getString("images"));
+        }
+        float fps = node.getFloat("fps", 0.f);
+        if (fps > 0.f) {
+            m_period = std::chrono::nanoseconds(static_cast<int64_t>(1e9 / fps));
+        }
+        if (node.hasOption("model")) {
+            IDnnEngine::dnnInputShape shape;
+            models.detector(node.getString("model"), 0).getInputShape(shape);
+            m_width = shape.width;
+            m_height = shape.height;
+        }
+    }
+
+    bool isSource() const override { return true; }
+    CpuAffinity::Stage getCpuStage() const override { return CpuAffinity::Stage::PreProcess; }
+
+    bool produce(PipelineFrame& frame) override {
+        if (m_next == m_paths.size()) {
+            m_next = 0;
+            m_pass++;
+        }
+        if (m_repeat > 0 && m_pass >= m_repeat) {
+            return false;
+        }
+        if (m_period.count() > 0) {
+            auto now = std::chrono::steady_clock::now();
+            if (m_deadline < now) {
+                m_deadline = now;
+            }
+            std::this_thread::sleep_until(m_deadline);
+            m_deadline += m_period;
+        }
+        frame.sourcePath = m_paths[m_next++];
+        frame.streamId = m_streamId;
+        frame.timestampNs = wallClockNs();
+        return true;
+    }
+
+    int process(PipelineFrame& frame, size_t /*worker*/) override {
+        imageDecoder::DecodedImage decoded;
+        if (imageDecoder::decode(frame.sourcePath, m_width, m_height, decoded) != 0) {
+            return -1;
+        }
+        auto input = std::make_shared<ObjDetectInput>();
+        input->handleType = "opencv4";
+        input->imageHandle = decoded.image;
+        input->decodeDownscale = decoded.downscale;
+        frame.input = std::move(input);
+        frame.origWidth = decoded.origWidth;
+        frame.origHeight = decoded.origHeight;
+        return 0;
+    }
+
+private:
+    std::vector<std::string> m_paths;
+    long m_repeat;
+    int m_streamId;
+    size_t m_width;
+    size_t m_height;
+    size_t m_next{0};
+    long m_pass{0};
+    std::chrono::nanoseconds m_period{0};
+    std::chrono::steady_clock::time_point m_deadline{};
+};
+
+// Marks frames of a static scene as skipped, one motionGate per stream
+class gateStage : public IPipelineStage {
+public:
+    explicit gateStage(const PipelineNodeConfig& node) {
+        m_params.analysis_width = static_cast<int>(node.getInt("analysis_width", m_params.analysis_width));
+        m_params.pixel_threshold = static_cast<int>(node.getInt("pixel_threshold", m_params.pixel_threshold));
+        m_params.changed_ratio = node.getFloat("changed_ratio", m_params.changed_ratio);
+        m_params.max_skip_frames = static_cast<int>(node.getInt("max_skip_frames", m_params.max_skip_frames));
+        m_params.background_rate = node.getFloat("background_rate", m_params.background_rate);
+    }
+
+    bool isStateful() const override { return true; }
+    size_t getMaxThreads() const override { return 1; }
+    CpuAffinity::Stage getCpuStage() const override { return CpuAffinity::Stage::PreProcess; }
+
+    int process(PipelineFrame& frame, size_t /*worker*/) override {
+        auto& gate = m_gates[frame.streamId];
+        if (gate == nullptr) {
+            gate = std::make_unique<motionGate>(m_params);
+        }
+        return gate->checkFrame(*frame.input) ? 0 : 1;
+    }
+
+private:
+    MotionGateParams m_params{};
+    std::unordered_map<int, std::unique_ptr<motionGate>> m_gates{};
+};
+
+// Options: model, conf_threshold, nms_threshold
+class preProcessStage : public modelStage {
+public:
+    preProcessStage(const PipelineNodeConfig& node, pipelineModels& models) :
+        modelStage(node, models),
+        m_confThreshold{node.getFloat("conf_threshold", 0.25f)},
+        m_nmsThreshold{node.getFloat("nms_threshold", 0.45f)} {}
+
+    int process(PipelineFrame& frame, size_t worker) override {
+        auto& detector = m_models.detector(m_model, worker);
+        detector.initParams(frame.params, frame.origWidth, frame.origHeight);
+        frame.params.conf_threshold = m_confThreshold;
+        frame.params.nms_threshold = m_nmsThreshold;
+        return detector.preProcess(frame.params, *frame.input, frame.tensor);
+    }
+
+    unsigned getModelUse() const override { return UsePreProcess; }
+    CpuAffinity::Stage getCpuStage() const override { return CpuAffinity::Stage::PreProcess; }
+
+protected:
+    float m_confThreshold;
+    float m_nmsThreshold;
+};
+
+class inferStage : public modelStage {
+public:
+    using modelStage::modelStage;
+
+    int process(PipelineFrame& frame, size_t worker) override {
+        int ret = m_models.detector(m_model, worker).infer(frame.tensor, frame.dnnOutputs, frame.dnnOutputStorage);
+        // the tensor is not needed downstream
+        frame.tensor = IDnnEngine::dnnInput{};
+        return ret;
+    }
+
+    unsigned getModelUse() const override { return UseInfer; }
+    CpuAffinity::Stage getCpuStage() const override { return CpuAffinity::Stage::Inference; }
+};
+
+class postProcessStage : public modelStage {
+public:
+    using modelStage::modelStage;
+
+    int process(PipelineFrame& frame, size_t worker) override {
+        frame.detections.clear();
+        int ret = m_models.detector(m_model, worker).postProcess(frame.params, frame.dnnOutputs, frame.detections);
+        frame.dnnOutputs.clear();
+        frame.dnnOutputStorage.clear();
+        return ret;
+    }
+
+    unsigned getModelUse() const override { return UsePostProcess; }
+    CpuAffinity::Stage getCpuStage() const override { return CpuAffinity::Stage::PostProcess; }
+};
+
+// pre-process, inference and post-process in one node (dnnObjDetector::runObjDetect)
+class detectStage : public preProcessStage {
+public:
+    using preProcessStage::preProcessStage;
+
+    int process(PipelineFrame& frame, size_t worker) override {
+        auto& detector = m_models.detector(m_model, worker);
+        detector.initParams(frame.params, frame.origWidth, frame.origHeight);
+        frame.params.conf_threshold = m_confThreshold;
+        frame.params.nms_threshold = m_nmsThreshold;
+        detector.pushInputData(frame.input);
+        int ret = detector.runObjDetect(frame.params);
+        frame.detections = detector.popOutputData();
+        return ret;
+    }
+
+    unsigned getModelUse() const override { return UseAll; }
+    // runObjDetect places its pre- and post-processing itself, like the streamManager workers
+    CpuAffinity::Stage getCpuStage() const override { return CpuAffinity::Stage::Inference; }
+};
+
+// One objTracker per stream, the detections are replaced by the confirmed tracks
+class trackStage : public IPipelineStage {
+public:
+    explicit trackStage(const PipelineNodeConfig& node) {
+        m_params.iou_threshold = node.getFloat("iou_threshold", m_params.iou_threshold);
+        m_params.high_score_threshold = node.getFloat("high_score_threshold", m_params.high_score_threshold);
+        m_params.new_track_threshold = node.getFloat("new_track_threshold", m_params.new_track_threshold);
+        m_params.max_age = static_cast<int>(node.getInt("max_age", m_params.max_age));
+        m_params.min_hits = static_cast<int>(node.getInt("min_hits", m_params.min_hits));
+        m_params.confidence_decay = node.getFloat("confidence_decay", m_params.confidence_decay);
+    }
+
+    bool isStateful() const override { return true; }
+    size_t getMaxThreads() const override { return 1; }
+    CpuAffinity::Stage getCpuStage() const override { return CpuAffinity::Stage::PostProcess; }
+
+    int process(PipelineFrame& frame, size_t /*worker*/) override {
+        auto& tracker = m_trackers[frame.streamId];
+        if (tracker == nullptr) {
+            tracker = std::make_unique<objTracker>(m_params);
+        }
+        std::vector<ObjDetectOutput> tracks;
+        tracker->update(frame.detections, tracks);
+        frame.detections.swap(tracks);
+        return 0;
+    }
+
+private:
+    ObjTrackParams m_params{};
+    std::unordered_map<int, std::unique_ptr<objTracker>> m_trackers{};
+};
+
+// Classifies the detections with a classify model. Options: model, crop_expand, min_detect_score, softmax
+class cascadeStage : public modelStage {
+public:
+    cascadeStage(const PipelineNodeConfig& node, pipelineModels& models) : modelStage(node, models) {
+        m_params.crop_expand = node.getFloat("crop_expand", 0.f);
+        m_params.min_detect_score = node.getFloat("min_detect_score", 0.f);
+        m_params.apply_softmax = node.getBool("softmax", true);
+        auto& classifier = m_models.classifier(m_model, 0);
+        IDnnEngine::dnnInputShape shape;
+        classifier.getInputShape(shape);
+        m_params.model_input_width = shape.width;
+        m_params.model_input_height = shape.height;
+        m_params.model_input_channel = shape.channel;
+        classifier.getOutputQuantParams(m_params.quantize_zero_points, m_params.quantize_scales);
+    }
+
+    CpuAffinity::Stage getCpuStage() const override { return CpuAffinity::Stage::Inference; }
+
+    int process(PipelineFrame& frame, size_t worker) override {
+        frame.classes.clear();
+        return m_models.classifier(m_model, worker).runCascade(m_params, *frame.input, frame.detections, frame.classes);
+    }
+
+private:
+    ObjClassifyParams m_params{};
+};
+
+/**
+ * Terminal node. Options: format (log, jsonl or result_log), path (file for jsonl, directory for result_log),
+ * prefix (result_log segment prefix).
+ */
+class sinkStage : public IPipelineStage {
+public:
+    explicit sinkStage(const PipelineNodeConfig& node) :
+        m_logger{std::make_unique<Logger>("pipelineSink")},
+        m_format{node.getString("format", "log")} {
+        if (m_format == "jsonl") {
+            std::string path = requireOption(node, "path");
+            m_file.open(path, std::ios::out | std::ios::trunc);
+            if (!m_file.is_open()) {
+                throw std::invalid_argument("node " + node.name + ": cannot open " + path);
+            }
+        }
+        else if (m_format == "result_log") {
+            ResultLogParams logParams;
+            logParams.directory = requireOption(node, "path");
+            logParams.prefix = node.getString("prefix", logParams.prefix);
+            m_resultLog = std::make_unique<resultLogWriter>(logParams);
+        }
+        else if (m_format != "log") {
+            throw std::invalid_argument("node " + node.name + ": unknown sink format " + m_format);
+        }
+    }
+
+    bool isStateful() const override { return true; }
+    size_t getMaxThreads() const override { return 1; }
+    CpuAffinity::Stage getCpuStage() const override { return CpuAffinity::Stage::IO; }
+
+    int process(PipelineFrame& frame, size_t /*worker*/) override {
+        if (m_resultLog != nullptr) {
+            return m_resultLog->append(frame.streamId, frame.timestampNs, frame.sequence, frame.detections);
+        }
+        if (m_file.is_open()) {
+            writeJson(frame);
+            return m_file.good() ? 0 : -1;
+        }
+        for (size_t i = 0; i < frame.detections.size(); i++) {
+            const auto& obj = frame.detections[i];
+            m_logger->printStdoutLog(Logger::LogLevel::Info, "stream {} frame {}: bbox: [{}, {}, {}, {}], score: {}, label: {}, track: {}{}",
+                frame.streamId, frame.sequence, obj.bbox.left, obj.bbox.top, obj.bbox.right, obj.bbox.bottom,
+                obj.score, obj.label, obj.trackId, i < frame.classes.size() ? ", class: " + frame.classes[i].label : "");
+        }
+        return 0;
+    }
+
+    void finish() override {
+        if (m_file.is_open()) {
+            m_file.flush();
+        }
+    }
+
+private:
+    void writeJson(const PipelineFrame& frame) {
+        m_line.clear();
+        char number[160];
+        std::snprintf(number, sizeof(number), "{\"stream\":%d,\"frame\":%llu,\"ts\":%llu,\"source\":",
+            frame.streamId, static_cast<unsigned long long>(frame.sequence),
+            static_cast<unsigned long long>(frame.timestampNs));
+        m_line += number;
+        writeJsonString(m_line, frame.sourcePath);
+        m_line += ",\"boxes\":[";
+        for (size_t i = 0; i < frame.detections.size(); i++) {
+            const auto& obj = frame.detections[i];
+            std::snprintf(number, sizeof(number), "%s{\"left\":%d,\"top\":%d,\"right\":%d,\"bottom\":%d,\"score\":%.4f,\"track\":%d,\"label\":",
+                i > 0 ? "," : "", obj.bbox.left, obj.bbox.top, obj.bbox.right, obj.bbox.bottom, obj.score, obj.trackId);
+            m_line += number;
+            writeJsonString(m_line, obj.label);
+            if (i < frame.classes.size() && frame.classes[i].classId >= 0) {
+                std::snprintf(number, sizeof(number), ",\"class_score\":%.4f,\"class\":", frame.classes[i].score);
+                m_line += number;
+                writeJsonString(m_line, frame.classes[i].label);
+            }
+            m_line += '}';
+        }
+        m_line += "]}\n";
+        m_file << m_line;
+    }
+
+private:
+    std::unique_ptr<Logger> m_logger;
+    std::string m_format;
+    std::ofstream m_file{};
+    std::string m_line{};
+    std::unique_ptr<resultLogWriter> m_resultLog{nullptr};
+};
+
+} // namespace
+
+std::unique_ptr<IPipelineStage> IPipelineStage::create(const PipelineNodeConfig& node, pipelineModels& models) {
+    const std::string& type = node.type;
+    if (type == "decode") {
+        return std::make_unique<decodeStage>(node, models);
+    }
+    if (type == "gate") {
+        return std::make_unique<gateStage>(node);
+    }
+    if (type == "preprocess") {
+        return std::make_unique<preProcessStage>(node, models);
+    }
+    if (type == "infer") {
+        return std::make_unique<inferStage>(node, models);
+    }
+    if (type == "postprocess") {
+        return std::make_unique<postProcessStage>(node, models);
+    }
+    if (type == "detect") {
+        return std::make_unique<detectStage>(node, models);
+    }
+    if (type == "track") {
+        return std::make_unique<trackStage>(node);
+    }
+    if (type == "cascade") {
+        return std::make_unique<cascadeStage>(node, models);
+    }
+    if (type == "sink") {
+        return std::make_unique<sinkStage>(node);
+    }
+    throw std::invalid_argument("node " + node.name + ": unknown type " + type);
+}
+
+} // namespace dnn_algorithm
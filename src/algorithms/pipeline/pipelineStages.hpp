@@ -0,0 +1,125 @@
+#ifndef __PIPELINE_STAGES_HPP__
+#define __PIPELINE_STAGES_HPP__
+
+#include "pipelineConfig.hpp"
+#include "algorithms/object_detect/dnnObjDetector.hpp"
+#include "algorithms/object_classify/dnnObjClassifier.hpp"
+#include "common/CpuTopology.hpp"
+#include "common/Logger.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace dnn_algorithm {
+
+// One frame travelling through the pipeline graph, each stage fills its part
+struct PipelineFrame {
+    size_t source{0};               // index of the source node that produced the frame
+    uint64_t sequence{0};           // per source node, assigned by the graph
+    int streamId{0};
+    uint64_t timestampNs{0};
+    std::string sourcePath{};
+    // filtered out (motion gate, stage error or shed from a full queue); the frame still flows downstream
+    // without being processed so the ordered nodes see every sequence number
+    bool skipped{false};
+    std::shared_ptr<ObjDetectInput> input{nullptr};
+    size_t origWidth{0};
+    size_t origHeight{0};
+    ObjDetectParams params{};
+    IDnnEngine::dnnInput tensor{};
+    std::vector<IDnnEngine::dnnOutput> dnnOutputs{};
+    std::vector<std::vector<uint8_t>> dnnOutputStorage{};   // owns what dnnOutputs point to
+    std::vector<ObjDetectOutput> detections{};
+    std::vector<ObjClassifyOutput> classes{};               // one per detection after a cascade node
+
+    PipelineFrame() = default;
+    // copies for fan-out, dnnOutputs are re-pointed to the copied storage
+    PipelineFrame(const PipelineFrame& other);
+    PipelineFrame& operator=(const PipelineFrame&) = delete;
+
+    // Release the payload of a shed frame, the header keeps flowing
+    void shed();
+
+    // Payload bytes: the input frame (shared with the fan-out copies), the tensor and the raw outputs
+    size_t getMemoryBytes() const;
+};
+
+/**
+ * The models of a pipeline, created once and shared by the nodes that name them.
+ * A model has <contexts> detectors (or classifiers); worker <i> of a node uses instance i % contexts, so two
+ * workers of one node never share an instance. Nodes of different stages may use the same instance on
+ * different frames, see dnnObjDetector::preProcess.
+ */
+class pipelineModels {
+public:
+    // @throw like dnnObjDetector::create() if a model cannot be loaded
+    explicit pipelineModels(const std::vector<PipelineModelConfig>& models);
+
+    pipelineModels(const pipelineModels&) = delete;
+    pipelineModels& operator=(const pipelineModels&) = delete;
+
+    // @throw std::invalid_argument for an unknown model or a model of another task
+    dnnObjDetector& detector(const std::string& name, size_t worker);
+    dnnObjClassifier& classifier(const std::string& name, size_t worker);
+    size_t getContexts(const std::string& name) const;
+
+    // Every instance as <prefix>.<model>.<i>, call it while no node runs the models
+    void reportMemory(MemoryReport& report, const std::string& prefix) const;
+
+private:
+    std::map<std::string, std::vector<std::unique_ptr<dnnObjDetector>>> m_detectors{};
+    std::map<std::string, std::vector<std::unique_ptr<dnnObjClassifier>>> m_classifiers{};
+};
+
+class IPipelineStage {
+public:
+    virtual ~IPipelineStage() = default;
+
+    /**
+     * @brief Process one frame on worker thread <worker> of the node.
+     * @return 0 to forward the frame, > 0 to forward it as skipped, < 0 on error (forwarded as skipped).
+     */
+    virtual int process(PipelineFrame& frame, size_t worker) = 0;
+
+    // Sources create the frames: fill <frame> for the next input, false once exhausted
+    virtual bool produce(PipelineFrame& /*frame*/) { return false; }
+    virtual bool isSource() const { return false; }
+
+    // Stages keeping state across frames see them in sequence order by default and run single-threaded
+    virtual bool isStateful() const { return false; }
+
+    // Upper bound for the threads of the node
+    virtual size_t getMaxThreads() const { return SIZE_MAX; }
+
+    // Placement of the worker threads of the node
+    virtual CpuAffinity::Stage getCpuStage() const { return CpuAffinity::Stage::Worker; }
+
+    // Parts of a model instance a stage runs while processing frames
+    enum ModelUse : unsigned {
+        UsePreProcess = 1,
+        UseInfer = 2,
+        UsePostProcess = 4,
+        UseAll = UsePreProcess | UseInfer | UsePostProcess
+    };
+
+    // The model the stage runs and its ModelUse bits, two nodes may only share a model on disjoint bits
+    virtual std::string getModel() const { return {}; }
+    virtual unsigned getModelUse() const { return 0; }
+
+    // Called once after the last frame
+    virtual void finish() {}
+
+    /**
+     * @brief Stage for a node of the config.
+     * Types: decode, gate, preprocess, infer, postprocess, detect, track, cascade, sink.
+     * @throw std::invalid_argument for an unknown type or invalid options.
+     */
+    static std::unique_ptr<IPipelineStage> create(const PipelineNodeConfig& node, pipelineModels& models);
+};
+
+} // namespace dnn_algorithm
+
+#endif // __PIPELINE_STAGES_HPP__
@@ -0,0 +1,153 @@
+#include <chrono>
+#include <cmath>
+#include <csignal>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include "common/ArgParser.hpp"
+#include "resultLogReader.hpp"
+
+using namespace common;
+using namespace dnn_algorithm;
+
+namespace {
+
+volatile std::sig_atomic_t g_stop = 0;
+
+void onSignal(int) {
+    g_stop = 1;
+}
+
+void writeJsonString(std::string& out, std::string_view value) {
+    out += '"';
+    for (char c : value) {
+        if (c == '"' || c == '\\') {
+            out += '\\';
+            out += c;
+        }
+        else if (static_cast<unsigned char>(c) < 0x20) {
+            char escaped[8];
+            std::snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+            out += escaped;
+        }
+        else {
+            out += c;
+        }
+    }
+    out += '"';
+}
+
+// Fixed-point number, null for what JSON cannot represent. A float has at most 39 integer digits.
+void writeJsonFloat(std::string& out, float value, int precision) {
+    char number[64];
+    int length = std::isfinite(value) ? std::snprintf(number, sizeof(number), "%.*f", precision, static_cast<double>(value)) : -1;
+    if (length < 0 || static_cast<size_t>(length) >= sizeof(number)) {
+        out += "null";
+        return;
+    }
+    out.append(number, static_cast<size_t>(length));
+}
+
+// One label per line, the line number is the class id (same format as LabelTable::fromFile)
+bool readLabels(const std::string& path, std::vector<std::string>& labels) {
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        return false;
+    }
+    std::string line;
+    while (std::getline(file, line)) {
+        if (!line.empty() && line.back() == '\r') {
+            line.pop_back();
+        }
+        labels.push_back(line);
+    }
+    return true;
+}
+
+} // namespace
+
+
+// Prints the records of a result log as JSON lines, --follow keeps tailing the log until interrupted
+int main(int argc, char* argv[])
+{
+    ArgParser parser("ResultLogExport");
+    parser.addOption("--dir, --directory", std::string("."), "Directory of the result log");
+    parser.addOption("--prefix", std::string("detections"), "File name prefix of the segments");
+    parser.addOption("--labels, --labelTextPath", std::string(""), "Label file to resolve the class ids, optional");
+    parser.addFlag("--follow", false, "Wait for new records instead of exiting at the end of the log");
+    parser.addOption("--poll_ms", int(50), "Poll interval of --follow in milliseconds");
+    parser.parseArgs(argc, argv);
+
+    std::string directory;
+    std::string prefix;
+    std::string labelTextPath;
+    int pollMs = 50;
+    parser.getOptionVal("--directory", directory);
+    parser.getOptionVal("--prefix", prefix);
+    parser.getOptionVal("--labelTextPath", labelTextPath);
+    parser.getOptionVal("--poll_ms", pollMs);
+    bool follow = parser.getFlagVal("--follow");
+
+    std::vector<std::string> labels;
+    if (!labelTextPath.empty() && !readLabels(labelTextPath, labels)) {
+        std::cerr << "Failed to read labels: " << labelTextPath << std::endl;
+        return -1;
+    }
+
+    std::signal(SIGINT, onSignal);
+    std::signal(SIGTERM, onSignal);
+
+    resultLogReader reader(directory, prefix);
+    resultLogReader::Record record;
+    std::string line;
+    while (g_stop == 0) {
+        if (!reader.next(record)) {
+            if (!follow) {
+                break;
+            }
+            std::cout.flush();
+            std::this_thread::sleep_for(std::chrono::milliseconds(pollMs));
+            continue;
+        }
+
+        line.clear();
+        line += "{\"stream\":" + std::to_string(record.streamId);
+        line += ",\"ts\":" + std::to_string(record.timestampNs);
+        line += ",\"frame\":" + std::to_string(record.frameId);
+        line += ",\"dropped\":" + std::to_string(record.dropped);
+        line += ",\"boxes\":[";
+        for (uint32_t i = 0; i < record.count; i++) {
+            const auto& box = record.boxes[i];
+            line += i > 0 ? ",{\"left\":" : "{\"left\":";
+            writeJsonFloat(line, box.left, 1);
+            line += ",\"top\":";
+            writeJsonFloat(line, box.top, 1);
+            line += ",\"right\":";
+            writeJsonFloat(line, box.right, 1);
+            line += ",\"bottom\":";
+            writeJsonFloat(line, box.bottom, 1);
+            line += ",\"score\":";
+            writeJsonFloat(line, box.score, 4);
+            line += ",\"class\":" + std::to_string(box.classId);
+            line += ",\"track\":" + std::to_string(box.trackId);
+            if (!labels.empty()) {
+                line += ",\"label\":";
+                bool known = box.classId >= 0 && static_cast<size_t>(box.classId) < labels.size();
+                writeJsonString(line, known ? labels[box.classId] : std::string{});
+            }
+            line += '}';
+        }
+        line += "]}\n";
+        std::cout << line;
+    }
+    std::cout.flush();
+
+    if (reader.getSkippedSegments() > 0) {
+        std::cerr << reader.getSkippedSegments() << " segments were deleted before they could be read" << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,105 @@
+#ifndef __RESULT_LOG_FORMAT_HPP__
+#define __RESULT_LOG_FORMAT_HPP__
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <dirent.h>
+
+namespace dnn_algorithm {
+
+/**
+ * On-disk layout of the detection result log.
+ *
+ * The log is a sequence of fixed-size segment files "<prefix>-<sequence>.dlog", each mapped by the writer.
+ * A segment starts with ResultLogSegmentHeader, followed by records: ResultLogRecordHeader and <count>
+ * ResultLogBox entries, padded to 8 bytes. The writer publishes a record by advancing <committed> with a
+ * release store, readers load it with acquire and may read everything below it in place. Once a record
+ * no longer fits, the writer sets <closed> and continues in the next sequence number.
+ * All fields are little-endian.
+ */
+namespace result_log {
+
+constexpr uint32_t SEGMENT_MAGIC = 0x4C524E44; // "DNRL"
+constexpr uint32_t FORMAT_VERSION = 1;
+constexpr size_t RECORD_ALIGNMENT = 8;
+
+#pragma pack(push, 1)
+struct ResultLogSegmentHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t sequence;
+    uint64_t capacity;      // file size
+    uint64_t committed;     // end of the last complete record, accessed atomically
+    uint32_t closed;        // accessed atomically, 1 once the writer moved on
+    uint32_t reserved[7];
+};
+
+struct ResultLogRecordHeader {
+    uint32_t size;          // bytes of the record including header, boxes and padding
+    int32_t streamId;
+    uint64_t timestampNs;
+    uint64_t frameId;
+    uint32_t count;
+    uint32_t dropped;       // boxes that did not fit the results container
+};
+
+struct ResultLogBox {
+    float left;
+    float top;
+    float right;
+    float bottom;
+    float score;
+    int32_t classId;
+    int32_t trackId;
+    uint32_t reserved;
+};
+#pragma pack(pop)
+
+static_assert(sizeof(ResultLogSegmentHeader) == 64, "segment header must stay 64 bytes");
+
+inline size_t recordSize(size_t count) {
+    size_t size = sizeof(ResultLogRecordHeader) + count * sizeof(ResultLogBox);
+    return (size + RECORD_ALIGNMENT - 1) / RECORD_ALIGNMENT * RECORD_ALIGNMENT;
+}
+
+inline std::string segmentPath(const std::string& directory, const std::string& prefix, uint64_t sequence) {
+    char name[32];
+    std::snprintf(name, sizeof(name), "-%08llu.dlog", static_cast<unsigned long long>(sequence));
+    return directory + "/" + prefix + name;
+}
+
+// Oldest and newest sequence numbers in <directory>, false if there is no segment
+inline bool findSegments(const std::string& directory, const std::string& prefix, uint64_t& oldest, uint64_t& newest) {
+    DIR* dir = opendir(directory.c_str());
+    if (dir == nullptr) {
+        return false;
+    }
+    std::string head = prefix + "-";
+    bool found = false;
+    while (struct dirent* entry = readdir(dir)) {
+        std::string name = entry->d_name;
+        if (name.size() <= head.size() + 5 || name.compare(0, head.size(), head) != 0
+                || name.compare(name.size() - 5, 5, ".dlog") != 0) {
+            continue;
+        }
+        std::string digits = name.substr(head.size(), name.size() - head.size() - 5);
+        if (digits.find_first_not_of("0123456789") != std::string::npos) {
+            continue;
+        }
+        uint64_t sequence = std::stoull(digits);
+        oldest = found ? std::min(oldest, sequence) : sequence;
+        newest = found ? std::max(newest, sequence) : sequence;
+        found = true;
+    }
+    closedir(dir);
+    return found;
+}
+
+} // namespace result_log
+
+} // namespace dnn_algorithm
+
+#endif // __RESULT_LOG_FORMAT_HPP__
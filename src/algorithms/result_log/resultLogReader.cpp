@@ -0,0 +1,146 @@
+#include "resultLogReader.hpp"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace dnn_algorithm {
+
+using namespace result_log;
+
+resultLogReader::resultLogReader(const std::string& directory, const std::string& prefix) :
+    m_directory{directory.empty() ? "." : directory},
+    m_prefix{prefix} {
+    uint64_t oldest = 0;
+    if (findOldest(oldest)) {
+        openSegment(oldest);
+    }
+}
+
+resultLogReader::~resultLogReader() {
+    closeSegment();
+}
+
+bool resultLogReader::exists(uint64_t sequence) const {
+    struct stat st;
+    return stat(segmentPath(m_directory, m_prefix, sequence).c_str(), &st) == 0;
+}
+
+bool resultLogReader::findOldest(uint64_t& sequence) const {
+    uint64_t newest = 0;
+    return findSegments(m_directory, m_prefix, sequence, newest);
+}
+
+bool resultLogReader::hasNewer() const {
+    uint64_t oldest = 0;
+    uint64_t newest = 0;
+    return exists(m_sequence + 1) || (findSegments(m_directory, m_prefix, oldest, newest) && newest > m_sequence);
+}
+
+bool resultLogReader::openSegment(uint64_t sequence) {
+    closeSegment();
+    m_sequence = sequence;
+    int fd = open(segmentPath(m_directory, m_prefix, sequence).c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(ResultLogSegmentHeader)) {
+        // created but not sized yet
+        close(fd);
+        return false;
+    }
+    void* base = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED) {
+        return false;
+    }
+    auto* header = static_cast<const ResultLogSegmentHeader*>(base);
+    if (__atomic_load_n(&header->magic, __ATOMIC_ACQUIRE) != SEGMENT_MAGIC || header->version != FORMAT_VERSION) {
+        munmap(base, static_cast<size_t>(st.st_size));
+        return false;
+    }
+    m_base = static_cast<const uint8_t*>(base);
+    m_size = static_cast<size_t>(st.st_size);
+    m_offset = sizeof(ResultLogSegmentHeader);
+    return true;
+}
+
+void resultLogReader::closeSegment() {
+    if (m_base != nullptr) {
+        munmap(const_cast<uint8_t*>(m_base), m_size);
+        m_base = nullptr;
+    }
+}
+
+bool resultLogReader::next(Record& record) {
+    while (true) {
+        if (m_base == nullptr) {
+            // the log did not exist yet or the segment was not initialized
+            if (!openSegment(m_sequence)) {
+                uint64_t oldest = 0;
+                if (!findOldest(oldest) || oldest <= m_sequence || !openSegment(oldest)) {
+                    return false;
+                }
+                m_skippedSegments += oldest - m_sequence;
+            }
+        }
+
+        auto* header = reinterpret_cast<const ResultLogSegmentHeader*>(m_base);
+        uint64_t committed = __atomic_load_n(&header->committed, __ATOMIC_ACQUIRE);
+        if (m_offset < committed && committed <= m_size) {
+            auto* src = reinterpret_cast<const ResultLogRecordHeader*>(m_base + m_offset);
+            // the header, then the boxes it announces, must lie within the committed bytes
+            if (committed - m_offset < sizeof(ResultLogRecordHeader) || src->size < sizeof(ResultLogRecordHeader)
+                    || src->size > committed - m_offset || recordSize(src->count) != src->size) {
+                // corrupted segment, continue with the next one
+                m_offset = committed;
+                continue;
+            }
+            record.streamId = src->streamId;
+            record.timestampNs = src->timestampNs;
+            record.frameId = src->frameId;
+            record.count = src->count;
+            record.dropped = src->dropped;
+            record.boxes = reinterpret_cast<const ResultLogBox*>(m_base + m_offset + sizeof(ResultLogRecordHeader));
+            record.sequence = m_sequence;
+            m_offset += src->size;
+            return true;
+        }
+
+        if (__atomic_load_n(&header->closed, __ATOMIC_ACQUIRE) == 0 && !hasNewer()) {
+            return false;
+        }
+        // <closed> is set after the last commit, drain the segment before moving on. A segment left open while
+        // a newer one exists belongs to a writer that crashed, the restarted writer never appends to it.
+        if (m_offset < __atomic_load_n(&header->committed, __ATOMIC_ACQUIRE)) {
+            continue;
+        }
+        uint64_t following = m_sequence + 1;
+        if (!exists(following)) {
+            uint64_t oldest = 0;
+            if (findOldest(oldest) && oldest > following) {
+                m_skippedSegments += oldest - following;
+                following = oldest;
+            }
+        }
+        closeSegment();
+        m_sequence = following;
+    }
+}
+
+void resultLogReader::seekToEnd() {
+    uint64_t sequence = m_sequence;
+    while (exists(sequence + 1)) {
+        sequence++;
+    }
+    if (m_base == nullptr || sequence != m_sequence) {
+        if (!openSegment(sequence)) {
+            return;
+        }
+    }
+    auto* header = reinterpret_cast<const ResultLogSegmentHeader*>(m_base);
+    m_offset = __atomic_load_n(&header->committed, __ATOMIC_ACQUIRE);
+}
+
+} // namespace dnn_algorithm
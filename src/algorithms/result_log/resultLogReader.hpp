@@ -0,0 +1,68 @@
+#ifndef __RESULT_LOG_READER_HPP__
+#define __RESULT_LOG_READER_HPP__
+
+#include "resultLogFormat.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace dnn_algorithm {
+
+/**
+ * Tails the result log written by resultLogWriter, possibly from another process.
+ * Segments are mapped read-only and records are returned in place, nothing is copied. A record stays valid
+ * until the reader moves past its segment, a segment deleted by the writer's retention remains mapped.
+ * Not thread-safe, use one reader per consumer thread.
+ */
+class resultLogReader {
+public:
+    struct Record {
+        int streamId{0};
+        uint64_t timestampNs{0};
+        uint64_t frameId{0};
+        uint32_t count{0};
+        uint32_t dropped{0};
+        const result_log::ResultLogBox* boxes{nullptr};   // <count> boxes inside the mapping
+        uint64_t sequence{0};                              // segment the record was read from
+    };
+
+    // Starts at the oldest segment available
+    resultLogReader(const std::string& directory, const std::string& prefix = "detections");
+    ~resultLogReader();
+
+    resultLogReader(const resultLogReader&) = delete;
+    resultLogReader& operator=(const resultLogReader&) = delete;
+
+    /**
+     * @brief Read the next committed record.
+     * @return false if the reader has caught up with the writer (or no log exists yet), call again later to follow.
+     */
+    bool next(Record& record);
+
+    // Skip to the end of the log, only records appended from now on are returned
+    void seekToEnd();
+
+    // Records lost because their segment was deleted before the reader got to it
+    uint64_t getSkippedSegments() const { return m_skippedSegments; }
+
+private:
+    bool openSegment(uint64_t sequence);
+    void closeSegment();
+    bool findOldest(uint64_t& sequence) const;
+    bool exists(uint64_t sequence) const;
+    // A later segment was created: the current one gets no more records, even if it was never closed
+    bool hasNewer() const;
+
+private:
+    std::string m_directory;
+    std::string m_prefix;
+    const uint8_t* m_base{nullptr};
+    size_t m_size{0};
+    size_t m_offset{0};
+    uint64_t m_sequence{0};
+    uint64_t m_skippedSegments{0};
+};
+
+} // namespace dnn_algorithm
+
+#endif // __RESULT_LOG_READER_HPP__
@@ -0,0 +1,171 @@
+#include "resultLogWriter.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace dnn_algorithm {
+
+using namespace result_log;
+
+resultLogWriter::resultLogWriter(const ResultLogParams& params) :
+    m_params{params},
+    m_logger{std::make_unique<Logger>("resultLogWriter")} {
+    if (m_params.directory.empty()) {
+        m_params.directory = ".";
+    }
+    if (mkdir(m_params.directory.c_str(), 0755) != 0 && errno != EEXIST) {
+        throw std::runtime_error("Failed to create result log directory: " + m_params.directory);
+    }
+
+    // Continue after the newest segment of a previous run
+    uint64_t oldest = 0;
+    uint64_t newest = 0;
+    bool found = findSegments(m_params.directory, m_params.prefix, oldest, newest);
+    if (!openSegment(found ? newest + 1 : 0)) {
+        throw std::runtime_error("Failed to create result log segment in " + m_params.directory);
+    }
+}
+
+resultLogWriter::~resultLogWriter() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    closeSegment();
+}
+
+bool resultLogWriter::openSegment(uint64_t sequence) {
+    std::string path = segmentPath(m_params.directory, m_params.prefix, sequence);
+    int fd = open(path.c_str(), O_CREAT | O_RDWR | O_TRUNC, 0644);
+    if (fd < 0) {
+        m_logger->printStdoutLog(Logger::LogLevel::Error, "Failed to open {}: {}", path, strerror(errno));
+        return false;
+    }
+    size_t capacity = std::max(m_params.segment_size, sizeof(ResultLogSegmentHeader) + recordSize(0));
+    // Reserve the blocks up front: a sparse file would turn a full disk into SIGBUS on the mapped writes
+    int err = posix_fallocate(fd, 0, static_cast<off_t>(capacity));
+    if (err != 0) {
+        m_logger->printStdoutLog(Logger::LogLevel::Error, "Failed to allocate {}: {}", path, strerror(err));
+        close(fd);
+        unlink(path.c_str());
+        return false;
+    }
+    void* base = mmap(nullptr, capacity, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED) {
+        m_logger->printStdoutLog(Logger::LogLevel::Error, "Failed to map {}: {}", path, strerror(errno));
+        return false;
+    }
+
+    auto* header = static_cast<ResultLogSegmentHeader*>(base);
+    std::memset(header, 0, sizeof(*header));
+    header->sequence = sequence;
+    header->capacity = capacity;
+    header->committed = sizeof(ResultLogSegmentHeader);
+    header->version = FORMAT_VERSION;
+    // readers check the magic last
+    __atomic_store_n(&header->magic, SEGMENT_MAGIC, __ATOMIC_RELEASE);
+
+    m_base = static_cast<uint8_t*>(base);
+    m_capacity = capacity;
+    m_offset = sizeof(ResultLogSegmentHeader);
+    m_sequence = sequence;
+    m_stats.segments++;
+    m_stats.sequence = sequence;
+
+    // Retention: the readers keep their mapping of a deleted segment
+    if (m_params.max_segments > 0 && sequence >= m_params.max_segments) {
+        unlink(segmentPath(m_params.directory, m_params.prefix, sequence - m_params.max_segments).c_str());
+    }
+    return true;
+}
+
+void resultLogWriter::closeSegment() {
+    if (m_base == nullptr) {
+        return;
+    }
+    auto* header = reinterpret_cast<ResultLogSegmentHeader*>(m_base);
+    __atomic_store_n(&header->closed, 1u, __ATOMIC_RELEASE);
+    munmap(m_base, m_capacity);
+    m_base = nullptr;
+}
+
+uint8_t* resultLogWriter::reserve(size_t size) {
+    if (sizeof(ResultLogSegmentHeader) + size > m_params.segment_size) {
+        return nullptr;
+    }
+    if (m_base == nullptr || m_offset + size > m_capacity) {
+        closeSegment();
+        if (!openSegment(m_sequence + 1)) {
+            return nullptr;
+        }
+    }
+    return m_base + m_offset;
+}
+
+void resultLogWriter::commit(size_t size) {
+    m_offset += size;
+    auto* header = reinterpret_cast<ResultLogSegmentHeader*>(m_base);
+    __atomic_store_n(&header->committed, static_cast<uint64_t>(m_offset), __ATOMIC_RELEASE);
+    m_stats.records++;
+    m_stats.bytes += size;
+}
+
+int resultLogWriter::append(int streamId, uint64_t timestampNs, uint64_t frameId, const ObjDetectResults& results) {
+    size_t size = recordSize(results.size());
+    std::lock_guard<std::mutex> lock(m_mutex);
+    uint8_t* dst = reserve(size);
+    if (dst == nullptr) {
+        return -1;
+    }
+
+    auto* record = reinterpret_cast<ResultLogRecordHeader*>(dst);
+    record->size = static_cast<uint32_t>(size);
+    record->streamId = streamId;
+    record->timestampNs = timestampNs;
+    record->frameId = frameId;
+    record->count = static_cast<uint32_t>(results.size());
+    record->dropped = static_cast<uint32_t>(results.getDropped());
+    auto* boxes = reinterpret_cast<ResultLogBox*>(dst + sizeof(ResultLogRecordHeader));
+    for (size_t i = 0; i < results.size(); i++) {
+        boxes[i].left = results.left()[i];
+        boxes[i].top = results.top()[i];
+        boxes[i].right = results.right()[i];
+        boxes[i].bottom = results.bottom()[i];
+        boxes[i].score = results.score()[i];
+        boxes[i].classId = results.classId()[i];
+        boxes[i].trackId = results.trackId()[i];
+        boxes[i].reserved = 0;
+    }
+    commit(size);
+    m_stats.boxes += results.size();
+    return 0;
+}
+
+int resultLogWriter::append(int streamId, uint64_t timestampNs, uint64_t frameId, const std::vector<ObjDetectOutput>& outputs) {
+    ObjDetectResults results(outputs.size());
+    results.append(outputs);
+    return append(streamId, timestampNs, frameId, results);
+}
+
+void resultLogWriter::flush() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_base != nullptr) {
+        msync(m_base, m_offset, MS_ASYNC);
+    }
+}
+
+ResultLogStats resultLogWriter::getStats() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_stats;
+}
+
+void resultLogWriter::reportMemory(MemoryReport& report, const std::string& prefix) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    report.add(prefix + ".segment", (m_offset + page - 1) / page * page);
+}
+
+} // namespace dnn_algorithm
@@ -0,0 +1,79 @@
+#ifndef __RESULT_LOG_WRITER_HPP__
+#define __RESULT_LOG_WRITER_HPP__
+
+#include "resultLogFormat.hpp"
+#include "algorithms/object_detect/objDetectResults.hpp"
+#include "common/Logger.hpp"
+#include "common/MemoryReport.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace dnn_algorithm {
+
+using namespace common;
+
+struct ResultLogParams {
+    std::string directory{};
+    std::string prefix{"detections"};
+    size_t segment_size{64 << 20};  // bytes per segment file
+    size_t max_segments{16};        // older segments are deleted, 0 keeps all
+};
+
+struct ResultLogStats {
+    uint64_t records{0};
+    uint64_t boxes{0};
+    uint64_t bytes{0};
+    uint64_t segments{0};   // segments opened
+    uint64_t sequence{0};   // sequence number of the current segment
+};
+
+/**
+ * Appends per-frame detections to the memory-mapped, segment-rotated result log (see resultLogFormat.hpp).
+ * Appending is a copy into the mapping and one release store, the page cache does the I/O.
+ * Thread-safe, streams of a streamManager can share one writer.
+ */
+class resultLogWriter {
+public:
+    // @throw std::runtime_error if the directory or the first segment cannot be created
+    explicit resultLogWriter(const ResultLogParams& params);
+    ~resultLogWriter();
+
+    resultLogWriter(const resultLogWriter&) = delete;
+    resultLogWriter& operator=(const resultLogWriter&) = delete;
+
+    // @return 0 on success, -1 if the record is larger than a segment or a new segment cannot be opened
+    int append(int streamId, uint64_t timestampNs, uint64_t frameId, const ObjDetectResults& results);
+    int append(int streamId, uint64_t timestampNs, uint64_t frameId, const std::vector<ObjDetectOutput>& outputs);
+
+    // Schedule the write-back of the current segment (msync MS_ASYNC)
+    void flush();
+
+    ResultLogStats getStats() const;
+
+    // The written part of the mapped segment (page cache, counted in the RSS) as <prefix>.segment
+    void reportMemory(MemoryReport& report, const std::string& prefix = "result_log") const;
+
+private:
+    uint8_t* reserve(size_t size);
+    void commit(size_t size);
+    bool openSegment(uint64_t sequence);
+    void closeSegment();
+
+private:
+    ResultLogParams m_params;
+    std::unique_ptr<Logger> m_logger;
+    mutable std::mutex m_mutex;
+    uint8_t* m_base{nullptr};
+    size_t m_capacity{0};
+    size_t m_offset{0};
+    uint64_t m_sequence{0};
+    ResultLogStats m_stats{};
+};
+
+} // namespace dnn_algorithm
+
+#endif // __RESULT_LOG_WRITER_HPP__
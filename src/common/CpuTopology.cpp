@@ -0,0 +1,314 @@
+#include "CpuTopology.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <pthread.h>
+#include <sched.h>
+
+
+namespace common {
+
+namespace {
+
+bool readNumber(const std::string& path, uint32_t& value) {
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        return false;
+    }
+    file >> value;
+    return !file.fail();
+}
+
+// "0-3,6" -> {0, 1, 2, 3, 6}
+std::vector<int> parseCpuList(const std::string& list) {
+    std::vector<int> cpus;
+    std::stringstream ss(list);
+    std::string range;
+    while (std::getline(ss, range, ',')) {
+        try {
+            size_t dash = range.find('-');
+            int first = std::stoi(range.substr(0, dash));
+            int last = dash == std::string::npos ? first : std::stoi(range.substr(dash + 1));
+            for (int cpu = first; cpu <= last; cpu++) {
+                cpus.push_back(cpu);
+            }
+        }
+        catch (const std::exception&) {
+            return {};
+        }
+    }
+    return cpus;
+}
+
+constexpr size_t STAGE_COUNT = static_cast<size_t>(CpuAffinity::Stage::Count);
+
+struct PolicyTable {
+    std::array<std::atomic<int>, STAGE_COUNT> classes;
+
+    PolicyTable() {
+        using Stage = CpuAffinity::Stage;
+        using CpuClass = CpuAffinity::CpuClass;
+        set(Stage::PreProcess, CpuClass::Big);
+        set(Stage::PostProcess, CpuClass::Big);
+        set(Stage::Worker, CpuClass::Big);
+        set(Stage::Inference, CpuClass::Big);
+        set(Stage::Logging, CpuClass::Little);
+        set(Stage::IO, CpuClass::Little);
+        set(Stage::Metrics, CpuClass::Little);
+        parseEnv();
+    }
+
+    void set(CpuAffinity::Stage stage, CpuAffinity::CpuClass cpuClass) {
+        classes[static_cast<size_t>(stage)] = static_cast<int>(cpuClass);
+    }
+
+    // DNN_CPU_AFFINITY="stage=big|little|any,..."
+    void parseEnv() {
+        const char* env = std::getenv("DNN_CPU_AFFINITY");
+        if (env == nullptr) {
+            return;
+        }
+        std::stringstream ss(env);
+        std::string item;
+        while (std::getline(ss, item, ',')) {
+            size_t pos = item.find('=');
+            std::string name = item.substr(0, pos);
+            std::string value = pos == std::string::npos ? "" : item.substr(pos + 1);
+            CpuAffinity::CpuClass cpu_class;
+            if (value == "big") {
+                cpu_class = CpuAffinity::CpuClass::Big;
+            }
+            else if (value == "little") {
+                cpu_class = CpuAffinity::CpuClass::Little;
+            }
+            else if (value == "any") {
+                cpu_class = CpuAffinity::CpuClass::Any;
+            }
+            else {
+                std::cerr << "DNN_CPU_AFFINITY: invalid class in " << item << std::endl;
+                continue;
+            }
+            bool found = false;
+            for (size_t i = 0; i < STAGE_COUNT; i++) {
+                auto stage = static_cast<CpuAffinity::Stage>(i);
+                if (name == CpuAffinity::stageName(stage)) {
+                    set(stage, cpu_class);
+                    found = true;
+                }
+            }
+            if (!found) {
+                std::cerr << "DNN_CPU_AFFINITY: unknown stage in " << item << std::endl;
+            }
+        }
+    }
+};
+
+PolicyTable& policyTable() {
+    static PolicyTable table;
+    return table;
+}
+
+// Mask of the calling thread as last read or set here, so that the per-frame ScopedStage does not
+// query and set the affinity when the thread already runs on the right cores.
+// A mask changed outside this file is picked up again by applyToCurrentThread().
+struct ThreadMask {
+    bool known{false};
+    std::vector<int> cores{};
+};
+
+thread_local ThreadMask t_threadMask;
+
+// nullptr if the mask cannot be read
+const std::vector<int>* getThreadCores() {
+    if (t_threadMask.known) {
+        return &t_threadMask.cores;
+    }
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (pthread_getaffinity_np(pthread_self(), sizeof(set), &set) != 0) {
+        return nullptr;
+    }
+    t_threadMask.cores.clear();
+    for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+        if (CPU_ISSET(cpu, &set)) {
+            t_threadMask.cores.push_back(cpu);
+        }
+    }
+    t_threadMask.known = true;
+    return &t_threadMask.cores;
+}
+
+bool setThreadCores(const std::vector<int>& cores) {
+    if (t_threadMask.known && t_threadMask.cores == cores) {
+        return true;
+    }
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int cpu : cores) {
+        CPU_SET(cpu, &set);
+    }
+    if (pthread_setaffinity_np(pthread_self(), sizeof(set), &set) != 0) {
+        t_threadMask.known = false;
+        return false;
+    }
+    t_threadMask.cores = cores;
+    t_threadMask.known = true;
+    return true;
+}
+
+} // namespace
+
+const CpuTopology& CpuTopology::instance() {
+    static CpuTopology topology("/sys/devices/system/cpu");
+    return topology;
+}
+
+CpuTopology::CpuTopology(const std::string& sysfsRoot) {
+    std::vector<int> cpus;
+    std::ifstream present(sysfsRoot + "/present");
+    std::string list;
+    if (present.is_open() && std::getline(present, list)) {
+        cpus = parseCpuList(list);
+    }
+    if (cpus.empty()) {
+        unsigned int count = std::max(1u, std::thread::hardware_concurrency());
+        for (unsigned int cpu = 0; cpu < count; cpu++) {
+            cpus.push_back(static_cast<int>(cpu));
+        }
+    }
+
+    uint32_t max_capacity = 0;
+    uint32_t max_freq = 0;
+    for (int cpu : cpus) {
+        CpuCore core;
+        core.id = cpu;
+        std::string dir = sysfsRoot + "/cpu" + std::to_string(cpu);
+        readNumber(dir + "/cpu_capacity", core.capacity);
+        readNumber(dir + "/cpufreq/cpuinfo_max_freq", core.maxFreqKHz);
+        max_capacity = std::max(max_capacity, core.capacity);
+        max_freq = std::max(max_freq, core.maxFreqKHz);
+        m_cores.push_back(core);
+    }
+
+    // Anything within 80% of the fastest core counts as big, so the two A76 clusters of RK3588 stay together
+    for (auto& core : m_cores) {
+        if (max_capacity > 0) {
+            core.big = core.capacity * 5 >= max_capacity * 4;
+        }
+        else if (max_freq > 0) {
+            core.big = core.maxFreqKHz * 5 >= max_freq * 4;
+        }
+    }
+}
+
+std::vector<int> CpuTopology::getBigCores() const {
+    std::vector<int> cores;
+    for (const auto& core : m_cores) {
+        if (core.big) {
+            cores.push_back(core.id);
+        }
+    }
+    return cores;
+}
+
+std::vector<int> CpuTopology::getLittleCores() const {
+    std::vector<int> cores;
+    for (const auto& core : m_cores) {
+        if (!core.big) {
+            cores.push_back(core.id);
+        }
+    }
+    return cores;
+}
+
+bool CpuTopology::isHeterogeneous() const {
+    return !getBigCores().empty() && !getLittleCores().empty();
+}
+
+std::string CpuTopology::describe() const {
+    std::stringstream ss;
+    for (const auto& core : m_cores) {
+        ss << "cpu" << core.id << "(" << (core.big ? "big" : "little")
+           << ", capacity " << core.capacity << ", " << core.maxFreqKHz / 1000 << " MHz) ";
+    }
+    return ss.str();
+}
+
+void CpuAffinity::setPolicy(Stage stage, CpuClass cpuClass) {
+    policyTable().set(stage, cpuClass);
+}
+
+CpuAffinity::CpuClass CpuAffinity::getPolicy(Stage stage) {
+    return static_cast<CpuClass>(policyTable().classes[static_cast<size_t>(stage)].load());
+}
+
+const char* CpuAffinity::stageName(Stage stage) {
+    switch (stage) {
+    case Stage::PreProcess:
+        return "preprocess";
+    case Stage::PostProcess:
+        return "postprocess";
+    case Stage::Worker:
+        return "worker";
+    case Stage::Inference:
+        return "inference";
+    case Stage::Logging:
+        return "logging";
+    case Stage::IO:
+        return "io";
+    case Stage::Metrics:
+        return "metrics";
+    default:
+        return "unknown";
+    }
+}
+
+const std::vector<int>& CpuAffinity::coresOf(CpuClass cpuClass) {
+    // Indexed by CpuClass, the topology is fixed for the lifetime of the process
+    static const std::array<std::vector<int>, 3> cores = []() {
+        std::array<std::vector<int>, 3> classes{};
+        const auto& topology = CpuTopology::instance();
+        if (topology.isHeterogeneous()) {
+            classes[static_cast<size_t>(CpuClass::Big)] = topology.getBigCores();
+            classes[static_cast<size_t>(CpuClass::Little)] = topology.getLittleCores();
+        }
+        return classes;
+    }();
+    return cores[static_cast<size_t>(cpuClass)];
+}
+
+bool CpuAffinity::applyToCurrentThread(Stage stage) {
+    const std::vector<int>& cores = coresOf(getPolicy(stage));
+    if (cores.empty()) {
+        return false;
+    }
+    // Called once per thread, re-read the mask in case it was changed behind the cache
+    t_threadMask.known = false;
+    return setThreadCores(cores);
+}
+
+CpuAffinity::ScopedStage::ScopedStage(Stage stage) {
+    const std::vector<int>& cores = coresOf(getPolicy(stage));
+    if (cores.empty()) {
+        return;
+    }
+    const std::vector<int>* current = getThreadCores();
+    if (current == nullptr || *current == cores) {
+        return;
+    }
+    m_previousCores = *current;
+    m_restore = setThreadCores(cores);
+}
+
+CpuAffinity::ScopedStage::~ScopedStage() {
+    if (m_restore) {
+        setThreadCores(m_previousCores);
+    }
+}
+
+} // namespace common
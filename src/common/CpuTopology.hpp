@@ -0,0 +1,105 @@
+#ifndef __CPU_TOPOLOGY_HPP__
+#define __CPU_TOPOLOGY_HPP__
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace common {
+
+/**
+ * CPU layout read from /sys/devices/system/cpu.
+ * Cores are ranked by cpu_capacity (arm64 DT), or by cpuinfo_max_freq when the capacity is not exported.
+ * On RK3588 the A76 cores report a capacity of 1024 and the A55 cores about 530.
+ */
+class CpuTopology {
+public:
+    struct CpuCore {
+        int id{0};
+        uint32_t capacity{0};   // 0 when not exported
+        uint32_t maxFreqKHz{0}; // 0 when not exported
+        bool big{true};
+    };
+
+    static const CpuTopology& instance();
+
+    // Parse <sysfsRoot> (normally /sys/devices/system/cpu)
+    explicit CpuTopology(const std::string& sysfsRoot);
+
+    const std::vector<CpuCore>& getCores() const {
+        return m_cores;
+    }
+    std::vector<int> getBigCores() const;
+    std::vector<int> getLittleCores() const;
+
+    // False on symmetric SoCs, the affinity policies are no-ops then
+    bool isHeterogeneous() const;
+
+    std::string describe() const;
+
+private:
+    std::vector<CpuCore> m_cores{};
+};
+
+/**
+ * Placement of the library threads per pipeline stage.
+ *
+ * Defaults: the latency-critical stages (pre-processing, decode/NMS, the shared worker pool and the engine
+ * completion threads) run on the big cores; logging, I/O and metrics export on the little cores.
+ * The defaults can be changed with setPolicy() or the environment variable DNN_CPU_AFFINITY,
+ * e.g. DNN_CPU_AFFINITY="logging=any,io=big".
+ */
+class CpuAffinity {
+public:
+    enum class Stage {
+        PreProcess = 0,
+        PostProcess,
+        Worker,
+        Inference,
+        Logging,
+        IO,
+        Metrics,
+        Count
+    };
+
+    enum class CpuClass {
+        Any,
+        Big,
+        Little
+    };
+
+    static void setPolicy(Stage stage, CpuClass cpuClass);
+    static CpuClass getPolicy(Stage stage);
+
+    // Pin the calling thread to the cores of the stage policy, returns false when nothing was changed
+    static bool applyToCurrentThread(Stage stage);
+
+    static const char* stageName(Stage stage);
+
+    /**
+     * Pins the calling thread for the lifetime of the object and restores the previous mask,
+     * for stages that run on threads the library does not own. The mask of the thread is cached
+     * per thread, a stage whose cores already match costs no syscall.
+     */
+    class ScopedStage {
+    public:
+        explicit ScopedStage(Stage stage);
+        ~ScopedStage();
+        ScopedStage(const ScopedStage&) = delete;
+        ScopedStage& operator=(const ScopedStage&) = delete;
+
+    private:
+        bool m_restore{false};
+        std::vector<int> m_previousCores{};
+    };
+
+private:
+    // Empty for CpuClass::Any and on homogeneous systems, computed once
+    static const std::vector<int>& coresOf(CpuClass cpuClass);
+};
+
+} // namespace common
+
+#endif // __CPU_TOPOLOGY_HPP__
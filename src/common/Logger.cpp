@@ -1,4 +1,5 @@
 #include "Logger.hpp"
+#include "CpuTopology.hpp"
 #include <spdlog/sinks/stdout_color_sinks.h>
 #include <spdlog/sinks/basic_file_sink.h>
 #include <spdlog/async.h>
@@ -8,8 +9,23 @@ namespace common {
 
 std::mutex Logger::m_loggerMtxLock;
 
+namespace {
+
+// The async loggers share one spdlog worker, keep it off the cores used by the pipeline
+void initLoggingThreadPool() {
+    static std::once_flag once;
+    std::call_once(once, []() {
+        spdlog::init_thread_pool(spdlog::details::default_async_q_size, 1,
+                []() { CpuAffinity::applyToCurrentThread(CpuAffinity::Stage::Logging); });
+        spdlog::flush_every(std::chrono::seconds(3));
+    });
+}
+
+} // namespace
+
 Logger::Logger(const std::string& logger_id, const std::string& log_file_path, const std::string& async_log_file_path){
     
+    initLoggingThreadPool();
     {
         std::lock_guard<std::mutex> lock(m_loggerMtxLock);
         auto ts = std::chrono::system_clock::now().time_since_epoch().count();
@@ -29,12 +45,15 @@ Logger::Logger(const std::string& logger_id, const std::string& log_file_path, c
 }
 
 Logger::~Logger() {
-    // Cleanup the logger here
-    spdlog::flush_every(std::chrono::seconds(3));
-    spdlog::shutdown();
-    m_stdout_logger.reset();
-    m_file_logger.reset();
-    m_async_file_logger.reset();
+    // Only unregister the loggers of this instance, spdlog::shutdown() would stop the loggers of every
+    // other component (and the shared async thread pool) while they are still in use
+    for (auto* logger : {&m_stdout_logger, &m_file_logger, &m_async_file_logger}) {
+        if (*logger != nullptr) {
+            (*logger)->flush();
+            spdlog::drop((*logger)->name());
+            logger->reset();
+        }
+    }
 }
 
 } // namespace common
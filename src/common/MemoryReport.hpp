@@ -0,0 +1,78 @@
+#ifndef __MEMORY_REPORT_HPP__
+#define __MEMORY_REPORT_HPP__
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace common {
+
+/**
+ * Bytes held by the components of the process, as a list of dotted paths ("detector.active.weights").
+ *
+ * Components append their own entries through a reportMemory(report, prefix) method; the report is a snapshot
+ * built on demand, nothing is tracked per allocation. Memory shared between components (the weights of engine
+ * clones) is added once, by its owner. What the report does not cover (code, allocator overhead, third-party
+ * caches) is the difference to the process RSS.
+ */
+class MemoryReport {
+public:
+    struct Entry {
+        std::string component{};
+        size_t bytes{0};
+    };
+
+    void add(const std::string& component, size_t bytes) {
+        m_entries.push_back({component, bytes});
+    }
+
+    const std::vector<Entry>& getEntries() const { return m_entries; }
+
+    size_t total() const {
+        size_t bytes = 0;
+        for (const auto& entry : m_entries) {
+            bytes += entry.bytes;
+        }
+        return bytes;
+    }
+
+    // The entries at <prefix> and below it
+    size_t total(const std::string& prefix) const {
+        size_t bytes = 0;
+        for (const auto& entry : m_entries) {
+            if (entry.component.compare(0, prefix.size(), prefix) == 0
+                    && (entry.component.size() == prefix.size() || entry.component[prefix.size()] == '.')) {
+                bytes += entry.bytes;
+            }
+        }
+        return bytes;
+    }
+
+    // One line per entry in KB, the largest first, and the total
+    std::string format() const {
+        std::vector<Entry> sorted = m_entries;
+        std::stable_sort(sorted.begin(), sorted.end(), [](const Entry& a, const Entry& b) { return a.bytes > b.bytes; });
+        size_t width = 5;
+        for (const auto& entry : sorted) {
+            width = std::max(width, entry.component.size());
+        }
+        std::string text;
+        char line[64];
+        for (const auto& entry : sorted) {
+            std::snprintf(line, sizeof(line), " %10zu KB\n", entry.bytes >> 10);
+            text += entry.component + std::string(width - entry.component.size(), ' ') + line;
+        }
+        std::snprintf(line, sizeof(line), " %10zu KB\n", total() >> 10);
+        text += "total" + std::string(width - 5, ' ') + line;
+        return text;
+    }
+
+private:
+    std::vector<Entry> m_entries{};
+};
+
+} // namespace common
+
+#endif // __MEMORY_REPORT_HPP__
@@ -0,0 +1,294 @@
+#include "TaskScheduler.hpp"
+#include "CpuTopology.hpp"
+#include <algorithm>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+
+
+namespace common {
+
+namespace {
+
+// Identifies the pool and the queue of the current worker thread
+thread_local const TaskScheduler* t_scheduler = nullptr;
+thread_local size_t t_workerIndex = 0;
+
+size_t defaultWorkerCount() {
+    const char* env = std::getenv("DNN_SCHEDULER_WORKERS");
+    if (env != nullptr) {
+        try {
+            return static_cast<size_t>(std::stoul(env));
+        }
+        catch (const std::exception&) {
+            std::cerr << "Invalid DNN_SCHEDULER_WORKERS: " << env << std::endl;
+        }
+    }
+    unsigned int cores = std::thread::hardware_concurrency();
+    return cores > 1 ? cores - 1 : 1;
+}
+
+} // namespace
+
+TaskScheduler& TaskScheduler::instance() {
+    static TaskScheduler scheduler(defaultWorkerCount());
+    static const bool placed = []() {
+        scheduler.setWorkerInitHook([](size_t) { CpuAffinity::applyToCurrentThread(CpuAffinity::Stage::Worker); });
+        return true;
+    }();
+    (void)placed;
+    return scheduler;
+}
+
+TaskScheduler::TaskScheduler(size_t numWorkers) : m_statsStart{std::chrono::steady_clock::now()} {
+    for (size_t i = 0; i < numWorkers; i++) {
+        m_queues.emplace_back(std::make_unique<WorkerQueue>());
+    }
+    for (size_t i = 0; i < numWorkers; i++) {
+        m_workers.emplace_back(&TaskScheduler::workerLoop, this, i);
+    }
+}
+
+TaskScheduler::~TaskScheduler() {
+    {
+        std::lock_guard<std::mutex> lock(m_sleepMutex);
+        m_stop = true;
+    }
+    m_sleepCv.notify_all();
+    for (auto& worker : m_workers) {
+        worker.join();
+    }
+}
+
+void TaskScheduler::post(std::function<void()> task, Priority priority) {
+    m_submitted++;
+    if (m_workers.empty()) {
+        // No pool: run on the caller
+        runTask(task);
+        return;
+    }
+
+    size_t index = (t_scheduler == this) ? t_workerIndex : (m_nextQueue++ % m_queues.size());
+    size_t depth = ++m_pending;
+    {
+        auto& queue = *m_queues[index];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.tasks[static_cast<size_t>(priority)].push_back(std::move(task));
+    }
+
+    size_t max_depth = m_maxQueueDepth.load();
+    while (depth > max_depth && !m_maxQueueDepth.compare_exchange_weak(max_depth, depth)) {
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_sleepMutex);
+    }
+    m_sleepCv.notify_one();
+}
+
+// The owner takes its newest task, it is the most likely to still be in cache
+bool TaskScheduler::popLocal(size_t index, Priority lowest, std::function<void()>& task) {
+    auto& queue = *m_queues[index];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    for (size_t p = 0; p <= static_cast<size_t>(lowest); p++) {
+        auto& tasks = queue.tasks[p];
+        if (!tasks.empty()) {
+            task = std::move(tasks.back());
+            tasks.pop_back();
+            return true;
+        }
+    }
+    return false;
+}
+
+// Thieves take the oldest task of the highest priority found on any other queue
+bool TaskScheduler::steal(size_t thief, Priority lowest, std::function<void()>& task) {
+    const size_t count = m_queues.size();
+    for (size_t p = 0; p <= static_cast<size_t>(lowest); p++) {
+        for (size_t i = 1; i <= count; i++) {
+            size_t victim = (thief + i) % count;
+            auto& queue = *m_queues[victim];
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            auto& tasks = queue.tasks[p];
+            if (!tasks.empty()) {
+                task = std::move(tasks.front());
+                tasks.pop_front();
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+bool TaskScheduler::runPendingTask(bool fromWaiter, Priority lowest) {
+    if (m_queues.empty() || m_pending.load() == 0) {
+        return false;
+    }
+
+    bool is_worker = (t_scheduler == this);
+    size_t index = is_worker ? t_workerIndex : 0;
+    std::function<void()> task;
+    if (is_worker && popLocal(index, lowest, task)) {
+        // own queue
+    }
+    else if (steal(index, lowest, task)) {
+        if (is_worker) {
+            m_steals++;
+        }
+    }
+    else {
+        return false;
+    }
+    m_pending--;
+
+    runTask(task);
+    if (fromWaiter) {
+        m_executedByWaiters++;
+    }
+    return true;
+}
+
+void TaskScheduler::runTask(std::function<void()>& task) {
+    try {
+        task();
+    }
+    catch (const std::exception& e) {
+        m_failed++;
+        std::cerr << "TaskScheduler: task threw: " << e.what() << std::endl;
+    }
+    catch (...) {
+        m_failed++;
+        std::cerr << "TaskScheduler: task threw an unknown exception" << std::endl;
+    }
+    m_executed++;
+}
+
+void TaskScheduler::workerLoop(size_t index) {
+    t_scheduler = this;
+    t_workerIndex = index;
+    uint64_t applied_hook = 0;
+
+    while (true) {
+        uint64_t hook_generation = m_hookGeneration.load();
+        if (hook_generation != applied_hook) {
+            std::function<void(size_t)> hook;
+            {
+                std::lock_guard<std::mutex> lock(m_hookMutex);
+                hook = m_initHook;
+            }
+            if (hook) {
+                hook(index);
+            }
+            applied_hook = hook_generation;
+        }
+
+        if (runPendingTask(false)) {
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(m_sleepMutex);
+        if (m_stop && m_pending.load() == 0) {
+            break;
+        }
+        auto idle_begin = std::chrono::steady_clock::now();
+        m_sleepCv.wait(lock, [this, applied_hook]() {
+            return m_stop || m_pending.load() > 0 || m_hookGeneration.load() != applied_hook;
+        });
+        m_idleNanoseconds += std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - idle_begin).count();
+    }
+}
+
+void TaskScheduler::parallelFor(size_t count, const std::function<void(size_t)>& fn, Priority priority) {
+    if (count == 0) {
+        return;
+    }
+    size_t helpers = std::min(count - 1, m_workers.size());
+    if (helpers == 0) {
+        for (size_t i = 0; i < count; i++) {
+            fn(i);
+        }
+        return;
+    }
+
+    struct Job {
+        std::atomic<size_t> next{0};
+        size_t finished{0};
+        std::mutex mutex;
+        std::condition_variable done;
+        std::exception_ptr error{};
+    };
+    auto job = std::make_shared<Job>();
+    // Helpers that start after the loop is exhausted never touch <fn>
+    auto run = [job, count, &fn]() {
+        for (size_t i = job->next++; i < count; i = job->next++) {
+            std::exception_ptr error{};
+            try {
+                fn(i);
+            }
+            catch (...) {
+                error = std::current_exception();
+            }
+            std::lock_guard<std::mutex> lock(job->mutex);
+            if (error && !job->error) {
+                job->error = error;
+            }
+            if (++job->finished == count) {
+                job->done.notify_all();
+            }
+        }
+    };
+
+    for (size_t i = 0; i < helpers; i++) {
+        post(run, priority);
+    }
+    run();
+
+    // The remaining indices are in progress on other threads; unrelated queued tasks are left to the workers
+    std::unique_lock<std::mutex> lock(job->mutex);
+    job->done.wait(lock, [&job, count]() { return job->finished == count; });
+    if (job->error) {
+        std::rethrow_exception(job->error);
+    }
+}
+
+void TaskScheduler::setWorkerInitHook(std::function<void(size_t workerIndex)> hook) {
+    {
+        std::lock_guard<std::mutex> lock(m_hookMutex);
+        m_initHook = std::move(hook);
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_sleepMutex);
+        m_hookGeneration++;
+    }
+    m_sleepCv.notify_all();
+}
+
+TaskScheduler::Stats TaskScheduler::getStats() const {
+    Stats stats;
+    stats.workers = m_workers.size();
+    stats.submitted = m_submitted.load();
+    stats.executed = m_executed.load();
+    stats.steals = m_steals.load();
+    stats.executedByWaiters = m_executedByWaiters.load();
+    stats.failed = m_failed.load();
+    stats.queueDepth = m_pending.load();
+    stats.maxQueueDepth = m_maxQueueDepth.load();
+    stats.idleSeconds = m_idleNanoseconds.load() / 1e9;
+    stats.uptimeSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - m_statsStart).count();
+    return stats;
+}
+
+void TaskScheduler::resetStats() {
+    m_submitted = 0;
+    m_executed = 0;
+    m_steals = 0;
+    m_executedByWaiters = 0;
+    m_failed = 0;
+    m_maxQueueDepth = m_pending.load();
+    m_idleNanoseconds = 0;
+    m_statsStart = std::chrono::steady_clock::now();
+}
+
+} // namespace common
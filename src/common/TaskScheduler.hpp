@@ -0,0 +1,136 @@
+#ifndef __TASK_SCHEDULER_HPP__
+#define __TASK_SCHEDULER_HPP__
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace common {
+
+/**
+ * Process-wide work-stealing scheduler for the CPU stages (pre-processing, decode, NMS, image decode, I/O).
+ *
+ * Every worker owns a deque per priority: it pops its own newest task first and steals the oldest
+ * task of another worker when it runs dry. Tasks posted from outside the pool are spread round-robin.
+ * A thread blocked in wait() runs pending tasks of at least the priority it waits at instead of sleeping,
+ * so nested use from inside a task cannot starve the pool, and a frame-path waiter never picks up a
+ * background task (model loads, teardown). parallelFor() callers only work on their own loop.
+ *
+ * The pool size defaults to hardware_concurrency() - 1 and can be set with the environment
+ * variable DNN_SCHEDULER_WORKERS before the first call to instance().
+ */
+class TaskScheduler {
+public:
+    enum class Priority {
+        High = 0,   // latency critical: post-processing of the frame being delivered
+        Normal,
+        Low,        // background: logging, prefetch
+        Count
+    };
+
+    struct Stats {
+        size_t workers{0};
+        uint64_t submitted{0};
+        uint64_t executed{0};
+        uint64_t steals{0};
+        uint64_t executedByWaiters{0};  // tasks run by threads blocked in parallelFor/wait
+        uint64_t failed{0};             // posted tasks that threw, each one is logged
+        size_t queueDepth{0};           // tasks currently queued
+        size_t maxQueueDepth{0};
+        double idleSeconds{0.0};        // summed over all workers
+        double uptimeSeconds{0.0};
+    };
+
+    static TaskScheduler& instance();
+
+    explicit TaskScheduler(size_t numWorkers);
+    ~TaskScheduler();
+
+    TaskScheduler(const TaskScheduler&) = delete;
+    TaskScheduler& operator=(const TaskScheduler&) = delete;
+
+    // An exception thrown by <task> is logged and counted in Stats::failed
+    void post(std::function<void()> task, Priority priority = Priority::Normal);
+
+    // An exception thrown by <func> is stored in the future and rethrown by get() or wait()
+    template <typename F>
+    auto submit(F&& func, Priority priority = Priority::Normal) -> std::future<std::invoke_result_t<std::decay_t<F>>> {
+        using result_type = std::invoke_result_t<std::decay_t<F>>;
+        auto task = std::make_shared<std::packaged_task<result_type()>>(std::forward<F>(func));
+        auto future = task->get_future();
+        post([task]() { (*task)(); }, priority);
+        return future;
+    }
+
+    // Block until <future> is ready, running queued tasks of priority <lowest> or higher in the meantime
+    template <typename T>
+    T wait(std::future<T>& future, Priority lowest = Priority::Normal) {
+        while (future.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+            if (!runPendingTask(true, lowest)) {
+                future.wait_for(std::chrono::microseconds(200));
+            }
+        }
+        return future.get();
+    }
+
+    // Run fn(i) for every i in [0, count); the caller takes part, then blocks until the indices taken by
+    // the workers are done. The first exception of fn is rethrown.
+    void parallelFor(size_t count, const std::function<void(size_t)>& fn, Priority priority = Priority::High);
+
+    size_t getWorkerCount() const {
+        return m_workers.size();
+    }
+
+    // Run once on every worker thread (at its next wake-up), used to apply thread names or affinity
+    void setWorkerInitHook(std::function<void(size_t workerIndex)> hook);
+
+    Stats getStats() const;
+    void resetStats();
+
+private:
+    struct WorkerQueue {
+        std::mutex mutex;
+        std::deque<std::function<void()>> tasks[static_cast<size_t>(Priority::Count)];
+    };
+
+    void workerLoop(size_t index);
+    bool popLocal(size_t index, Priority lowest, std::function<void()>& task);
+    bool steal(size_t thief, Priority lowest, std::function<void()>& task);
+    bool runPendingTask(bool fromWaiter, Priority lowest = Priority::Low);
+    void runTask(std::function<void()>& task);
+
+private:
+    std::vector<std::unique_ptr<WorkerQueue>> m_queues{};
+    std::vector<std::thread> m_workers{};
+    std::atomic<size_t> m_nextQueue{0};
+    std::atomic<size_t> m_pending{0};
+    std::mutex m_sleepMutex;
+    std::condition_variable m_sleepCv;
+    std::atomic<bool> m_stop{false};
+
+    std::mutex m_hookMutex;
+    std::function<void(size_t)> m_initHook{};
+    std::atomic<uint64_t> m_hookGeneration{0};
+
+    std::atomic<uint64_t> m_submitted{0};
+    std::atomic<uint64_t> m_executed{0};
+    std::atomic<uint64_t> m_steals{0};
+    std::atomic<uint64_t> m_executedByWaiters{0};
+    std::atomic<uint64_t> m_failed{0};
+    std::atomic<size_t> m_maxQueueDepth{0};
+    std::atomic<uint64_t> m_idleNanoseconds{0};
+    std::chrono::steady_clock::time_point m_statsStart{};
+};
+
+} // namespace common
+
+#endif // __TASK_SCHEDULER_HPP__
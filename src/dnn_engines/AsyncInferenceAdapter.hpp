@@ -0,0 +1,140 @@
+#ifndef __ASYNC_INFERENCE_ADAPTER_HPP__
+#define __ASYNC_INFERENCE_ADAPTER_HPP__
+
+#include "dnn_engines/IDnnEngine.hpp"
+#include "common/CpuTopology.hpp"
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+namespace dnn_engine {
+
+/**
+ * Generic runInferenceAsync for engines without a native asynchronous mode:
+ * the inputs are copied into a small queue and a completion thread runs
+ * pushInputData/runInference/popOutputData and the completion callback in submission order.
+ */
+class AsyncInferenceAdapter {
+public:
+    // submit() blocks while this many runs are queued, so a fast producer cannot grow the queue without bound
+    static constexpr size_t MAX_PENDING = 2;
+
+    explicit AsyncInferenceAdapter(IDnnEngine& engine) : m_engine{engine} {
+        m_thread = std::thread(&AsyncInferenceAdapter::completionLoop, this);
+    }
+
+    ~AsyncInferenceAdapter() {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stop = true;
+        }
+        m_cv.notify_all();
+        m_thread.join();
+    }
+
+    AsyncInferenceAdapter(const AsyncInferenceAdapter&) = delete;
+    AsyncInferenceAdapter& operator=(const AsyncInferenceAdapter&) = delete;
+
+    int submit(const IDnnEngine::dnnInput& inputData, IDnnEngine::InferenceCompletion completion) {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_cv.wait(lock, [this]() { return m_stop || m_jobs.size() < MAX_PENDING; });
+        if (m_stop) {
+            return -1;
+        }
+        m_jobs.emplace_back(inputData, std::move(completion));
+        m_cv.notify_all();
+        return 0;
+    }
+
+    void waitIdle() {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_cv.wait(lock, [this]() { return m_jobs.empty() && !m_running; });
+    }
+
+private:
+    void completionLoop() {
+        common::CpuAffinity::applyToCurrentThread(common::CpuAffinity::Stage::Inference);
+        std::vector<IDnnEngine::dnnOutput> outputs;
+        while (true) {
+            std::pair<IDnnEngine::dnnInput, IDnnEngine::InferenceCompletion> job;
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_cv.wait(lock, [this]() { return m_stop || !m_jobs.empty(); });
+                // pending runs are completed before the thread exits
+                if (m_jobs.empty()) {
+                    return;
+                }
+                job = std::move(m_jobs.front());
+                m_jobs.pop_front();
+                m_running = true;
+            }
+            m_cv.notify_all();
+
+            int ret = m_engine.pushInputData(job.first);
+            if (ret == 0) {
+                ret = m_engine.runInference();
+            }
+            if (ret == 0) {
+                ret = m_engine.popOutputData(outputs);
+            }
+            if (job.second) {
+                job.second(ret, outputs);
+            }
+
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_running = false;
+            }
+            m_cv.notify_all();
+        }
+    }
+
+private:
+    IDnnEngine& m_engine;
+    std::thread m_thread;
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+    std::deque<std::pair<IDnnEngine::dnnInput, IDnnEngine::InferenceCompletion>> m_jobs{};
+    bool m_running{false};
+    bool m_stop{false};
+};
+
+inline int IDnnEngine::runInferenceAsync(dnnInput& inputData, InferenceCompletion completion) {
+    std::shared_ptr<AsyncInferenceAdapter> adapter;
+    {
+        std::lock_guard<std::mutex> lock(m_asyncAdapterMutex);
+        if (m_asyncAdapter == nullptr) {
+            m_asyncAdapter = std::make_shared<AsyncInferenceAdapter>(*this);
+        }
+        adapter = m_asyncAdapter;
+    }
+    return adapter->submit(inputData, std::move(completion));
+}
+
+inline int IDnnEngine::waitInferenceAsync() {
+    std::shared_ptr<AsyncInferenceAdapter> adapter;
+    {
+        std::lock_guard<std::mutex> lock(m_asyncAdapterMutex);
+        adapter = m_asyncAdapter;
+    }
+    if (adapter != nullptr) {
+        adapter->waitIdle();
+    }
+    return 0;
+}
+
+inline void IDnnEngine::stopInferenceAsync() {
+    std::shared_ptr<AsyncInferenceAdapter> adapter;
+    {
+        std::lock_guard<std::mutex> lock(m_asyncAdapterMutex);
+        adapter.swap(m_asyncAdapter);
+    }
+    // joins the completion thread after the pending runs
+    adapter.reset();
+}
+
+} // namespace dnn_engine
+
+#endif // __ASYNC_INFERENCE_ADAPTER_HPP__
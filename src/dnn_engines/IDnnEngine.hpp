@@ -1,12 +1,17 @@
 #ifndef __IDNN_ENGINE_HPP__
 #define __IDNN_ENGINE_HPP__
 
+#include "common/MemoryReport.hpp"
+#include <functional>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <vector>
 
 namespace dnn_engine {
 
+class AsyncInferenceAdapter;
+
 class IDnnEngine {
 public:
 
@@ -15,6 +20,7 @@ public:
         size_t width{0};
         size_t height{0};
         size_t channel{0};
+        size_t batch{1};
     };
 
     struct dnnInput {
@@ -24,22 +30,90 @@ public:
         dnnInputShape shape{};
         // dataType can be "UINT8", "float32"
         std::string dataType{"UINT8"};
+        // <buf> already holds the native tensor described by getInputDesc, the engine submits it unconverted
+        bool passThrough{false};
+    };
+
+    // The input tensor in the layout and type the accelerator consumes, see getInputDesc
+    struct dnnInputDesc {
+        size_t index{0};
+        // dims in the order of <layout>, e.g. {1, 640, 640, 3} for NHWC or {1, 1, 640, 640, 16} for NC1HWC2
+        std::vector<size_t> dims{};
+        // layout can be "NCHW", "NHWC", "NC1HWC2"
+        std::string layout{"NHWC"};
+        // dataType can be "UINT8", "INT8", "FP16", "FP32"
+        std::string dataType{"UINT8"};
+        // affine quantization of the integer types: real = (q - zeroPoint) * scale
+        int32_t zeroPoint{0};
+        float scale{1.f};
+        // elements per row including the alignment padding, 0 if rows are not padded
+        size_t widthStride{0};
+        // bytes of the tensor including the padding
+        size_t size{0};
     };
 
     struct dnnOutput {
         size_t index{0};
         void* buf{nullptr};
         size_t size{0};
-        // dataType can be "UINT8", "INT8", "float32"
-        std::string dataType{"INT8"};
+        // dataType can be "int8" (affine quantized), "float16", "float32"
+        std::string dataType{"int8"};
+    };
+
+    // Describes an output tensor of the loaded model
+    struct dnnOutputDesc {
+        size_t index{0};
+        // dims in the order of <layout>, e.g. {1, 255, 80, 80}
+        std::vector<size_t> dims{};
+        // layout can be "NCHW", "NHWC"
+        std::string layout{"NCHW"};
+        // the dataType popOutputData will report for this output
+        std::string dataType{"int8"};
     };
 
+    // Memory held by an engine, by component
+    struct dnnMemoryUsage {
+        size_t modelBlobBytes{0};   // model file kept in host memory
+        size_t weightBytes{0};      // weights in accelerator memory
+        size_t internalBytes{0};    // activations and intermediate tensors of the context
+        size_t ioBytes{0};          // input and output tensors of the runtime
+        size_t sharedBytes{0};      // blob and weights shared with the engine this one was cloned from, not in total()
+        size_t dmaBytes{0};         // DMA memory allocated by the runtime as it reports it, 0 if unknown
+
+        size_t total() const { return modelBlobBytes + weightBytes + internalBytes + ioBytes; }
+    };
+
+    // Time spent in the phases of loadModel
+    struct dnnLoadStats {
+        float readMs{0.f};  // reading the model file
+        float initMs{0.f};  // creating the runtime context
+        float queryMs{0.f}; // querying the tensor attributes
+    };
+
+    // status is the result of the run (0 on success), the outputs are only valid during the call
+    using InferenceCompletion = std::function<void(int status, std::vector<dnnOutput>& outputs)>;
+
+    using Factory = std::function<std::unique_ptr<IDnnEngine>()>;
+
+    // rknn is built in, other types (test engines) have to be registered before create() is called with them
     static std::unique_ptr<IDnnEngine> create(const std::string& dnnType);
 
+    static void registerType(const std::string& dnnType, Factory factory);
+
     virtual void loadModel(const std::string& modelPath) = 0;
 
     virtual int getInputShape(dnnInputShape& shape) = 0;
 
+    virtual int getOutputDescs(std::vector<dnnOutputDesc>& outputDescs) = 0;
+
+    /* The native input tensor of the model. Pre-processing that produces exactly this tensor (type, layout,
+     * quantization and the normalization the model was converted with) sets dnnInput::passThrough, so the
+     * runtime skips its own conversion. Returns -1 if the engine has no pass-through input.
+     */
+    virtual int getInputDesc(dnnInputDesc& /*desc*/) {
+        return -1;
+    }
+
     /* for networks using quantitative models
      * when using a quantization model, the post-processing process requires inverse quantization to 
      * floating-point data based on the model's scale array and zero_point array
@@ -52,12 +126,57 @@ public:
 
     virtual int runInference() = 0;
 
+    /* Non-blocking inference: <inputData> is consumed before the call returns, so the caller can pre-process
+     * the next frame while the accelerator works. <completion> runs on an engine-owned thread, in submission order.
+     * Do not mix with the blocking calls while runs are pending.
+     * The default implementation runs the blocking calls on a completion thread (AsyncInferenceAdapter).
+     */
+    virtual int runInferenceAsync(dnnInput& inputData, InferenceCompletion completion);
+
+    // Block until every submitted asynchronous run has completed
+    virtual int waitInferenceAsync();
+
+    /* A new engine with its own context for the loaded model, sharing the weights where the backend allows it.
+     * Returns nullptr if the engine cannot be cloned, the model has to be loaded again then.
+     */
+    virtual std::unique_ptr<IDnnEngine> clone() {
+        return nullptr;
+    }
+
+    virtual int getLoadStats(dnnLoadStats& /*stats*/) {
+        return -1;
+    }
+
+    // Bytes held by this engine for the loaded model (model blob, weights, internal tensors), 0 if unknown
+    virtual size_t getMemoryFootprint() {
+        return 0;
+    }
+
+    // Breakdown of the memory of the engine, -1 if the backend cannot report it
+    virtual int getMemoryUsage(dnnMemoryUsage& /*usage*/) {
+        return -1;
+    }
+
+    // Add the breakdown as <prefix>.blob/.weights/.internal/.io, or the footprint as <prefix> without one
+    void reportMemory(common::MemoryReport& report, const std::string& prefix);
+
     virtual ~IDnnEngine() = default;
 
 protected:
     IDnnEngine() = default;
+
+    /* Engines relying on the default runInferenceAsync must call this first in their destructor,
+     * the completion thread calls back into the derived class.
+     */
+    void stopInferenceAsync();
+
+private:
+    std::mutex m_asyncAdapterMutex;
+    std::shared_ptr<AsyncInferenceAdapter> m_asyncAdapter{};
 };
 
 } // namespace dnn_engine
 
+#include "dnn_engines/AsyncInferenceAdapter.hpp"
+
 #endif // __IDNN_ENGINE_HPP__
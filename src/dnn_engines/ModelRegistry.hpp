@@ -0,0 +1,114 @@
+#ifndef __MODEL_REGISTRY_HPP__
+#define __MODEL_REGISTRY_HPP__
+
+#include "dnn_engines/IDnnEngine.hpp"
+#include "common/Logger.hpp"
+#include <chrono>
+#include <cstdint>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace dnn_engine {
+
+/**
+ * Process-wide cache of loaded models, shared between detectors.
+ *
+ * A model is identified by its path and a hash of its content, so a file replaced on disk is reloaded and the
+ * same file under another path is loaded once. acquire() always returns an engine with its own context:
+ * the first user gets the loaded engine, further users get clones sharing its weights (IDnnEngine::clone),
+ * or a separate load if the engine cannot be cloned.
+ * Models stay resident after their last user is gone; when the memory budget is exceeded the least recently
+ * used models without users are unloaded. prewarm() loads a model in the background ahead of a switch.
+ */
+class ModelRegistry {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    struct ModelInfo {
+        std::string dnnType{};
+        std::string modelPath{};
+        uint64_t hash{0};
+        size_t memoryBytes{0};  // the loaded engine plus the clones in use
+        size_t users{0};        // engines handed out and still alive
+        bool loading{false};
+        float idleSeconds{0.f}; // since the last acquire
+    };
+
+    static ModelRegistry& instance();
+
+    ModelRegistry();
+    ~ModelRegistry() = default;
+
+    ModelRegistry(const ModelRegistry&) = delete;
+    ModelRegistry& operator=(const ModelRegistry&) = delete;
+
+    // 0 disables the eviction. The default is read from DNN_MODEL_MEMORY_BUDGET_MB.
+    void setMemoryBudget(size_t bytes);
+    size_t getMemoryBudget() const;
+
+    /**
+     * @brief Get an engine for the model, loading it on first use.
+     * The engine belongs to the caller; it keeps the weights it shares alive even if the model is evicted.
+     * @throw std::runtime_error / std::invalid_argument if the model cannot be loaded.
+     */
+    std::shared_ptr<IDnnEngine> acquire(const std::string& dnnType, const std::string& modelPath);
+
+    // Load the model at low priority on the TaskScheduler, the future rethrows load errors
+    std::shared_future<void> prewarm(const std::string& dnnType, const std::string& modelPath);
+
+    // Unload every model without users
+    void purge();
+
+    size_t getResidentBytes() const;
+    std::vector<ModelInfo> getModels() const;
+
+    // Models kept resident without users, as <prefix>.<model path>; the engines in use are reported by their holders
+    void reportMemory(common::MemoryReport& report, const std::string& prefix = "registry") const;
+
+private:
+    struct Lease {
+        std::weak_ptr<IDnnEngine> engine{};
+        size_t bytes{0};
+    };
+
+    struct Entry {
+        std::string dnnType{};
+        std::string modelPath{};
+        uint64_t hash{0};
+        // size and modification time of the file when it was loaded
+        uint64_t fileSize{0};
+        int64_t fileMtime{0};
+        std::shared_ptr<IDnnEngine> engine{};
+        size_t engineBytes{0};
+        std::weak_ptr<IDnnEngine> engineLease{};    // the loaded engine itself is handed out to one user at a time
+        std::vector<Lease> clones{};
+        Clock::time_point lastUsed{};
+        bool loading{true};
+        std::promise<void> loaded{};
+        std::shared_future<void> ready{};
+    };
+
+    std::shared_ptr<Entry> load(const std::string& dnnType, const std::string& modelPath);
+    std::shared_ptr<Entry> waitLoaded(std::shared_ptr<Entry> entry);
+    static size_t residentBytesOf(Entry& entry);
+    static size_t usersOf(Entry& entry);
+    // Called with m_mutex held, never evicts <keep>; the evicted entries are destroyed by the caller after unlocking
+    std::vector<std::shared_ptr<Entry>> enforceBudget(const Entry* keep);
+    void removeEntry(const std::shared_ptr<Entry>& entry);
+
+private:
+    std::unique_ptr<common::Logger> m_logger;
+    mutable std::mutex m_mutex;
+    size_t m_memoryBudget{0};
+    std::vector<std::shared_ptr<Entry>> m_entries{};
+    // "<dnnType>:<path>" -> entry, several paths may resolve to the same content
+    std::unordered_map<std::string, std::shared_ptr<Entry>> m_byPath{};
+};
+
+} // namespace dnn_engine
+
+#endif // __MODEL_REGISTRY_HPP__
@@ -1,8 +1,21 @@
 #include "dnn_engines/IDnnEngine.hpp"
 #include "rknn/rknn.hpp"
+#include <map>
 
 namespace dnn_engine {
 
+namespace {
+
+std::mutex g_factoryMutex;
+std::map<std::string, IDnnEngine::Factory> g_factories;
+
+} // namespace
+
+void IDnnEngine::registerType(const std::string& dnnType, Factory factory) {
+    std::lock_guard<std::mutex> lock(g_factoryMutex);
+    g_factories[dnnType] = std::move(factory);
+}
+
 std::unique_ptr<IDnnEngine> IDnnEngine::create(const std::string& dnnType) {
     if(dnnType.compare("TensorRT") == 0) {
         // return std::make_unique<TensorRTDnn>();
@@ -12,8 +25,31 @@ std::unique_ptr<IDnnEngine> IDnnEngine::create(const std::string& dnnType) {
         return std::make_unique<rknn>();
     }
     else {
-        throw std::invalid_argument("Invalid DNN type specified.");
+        Factory factory;
+        {
+            std::lock_guard<std::mutex> lock(g_factoryMutex);
+            auto it = g_factories.find(dnnType);
+            if (it != g_factories.end()) {
+                factory = it->second;
+            }
+        }
+        if (!factory) {
+            throw std::invalid_argument("Invalid DNN type specified.");
+        }
+        return factory();
+    }
+}
+
+void IDnnEngine::reportMemory(common::MemoryReport& report, const std::string& prefix) {
+    dnnMemoryUsage usage;
+    if (getMemoryUsage(usage) != 0) {
+        report.add(prefix, getMemoryFootprint());
+        return;
     }
+    report.add(prefix + ".blob", usage.modelBlobBytes);
+    report.add(prefix + ".weights", usage.weightBytes);
+    report.add(prefix + ".internal", usage.internalBytes);
+    report.add(prefix + ".io", usage.ioBytes);
 }
 
 } // namespace dnn_engine
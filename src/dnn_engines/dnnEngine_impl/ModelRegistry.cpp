@@ -0,0 +1,295 @@
+#include "dnn_engines/ModelRegistry.hpp"
+#include "common/TaskScheduler.hpp"
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <stdexcept>
+#include <sys/stat.h>
+
+namespace dnn_engine {
+
+using namespace common;
+
+namespace {
+
+// FNV-1a over the file content
+uint64_t hashFile(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        throw std::runtime_error("Failed to open model: " + path);
+    }
+    uint64_t hash = 0xcbf29ce484222325ull;
+    std::vector<char> buffer(1 << 20);
+    while (file) {
+        file.read(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+        std::streamsize count = file.gcount();
+        for (std::streamsize i = 0; i < count; i++) {
+            hash ^= static_cast<uint8_t>(buffer[i]);
+            hash *= 0x100000001b3ull;
+        }
+    }
+    return hash;
+}
+
+} // namespace
+
+ModelRegistry& ModelRegistry::instance() {
+    static ModelRegistry registry;
+    return registry;
+}
+
+ModelRegistry::ModelRegistry() : m_logger{std::make_unique<Logger>("ModelRegistry")} {
+    const char* env = std::getenv("DNN_MODEL_MEMORY_BUDGET_MB");
+    if (env != nullptr) {
+        m_memoryBudget = static_cast<size_t>(std::strtoull(env, nullptr, 10)) << 20;
+    }
+}
+
+void ModelRegistry::setMemoryBudget(size_t bytes) {
+    std::vector<std::shared_ptr<Entry>> evicted;
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_memoryBudget = bytes;
+    evicted = enforceBudget(nullptr);
+}
+
+size_t ModelRegistry::getMemoryBudget() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_memoryBudget;
+}
+
+std::shared_ptr<IDnnEngine> ModelRegistry::acquire(const std::string& dnnType, const std::string& modelPath) {
+    auto entry = load(dnnType, modelPath);
+
+    std::shared_ptr<IDnnEngine> engine;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        entry->lastUsed = Clock::now();
+        engine = entry->engine;
+        if (entry->engineLease.expired()) {
+            // the lease does not own the engine, it keeps the registry's reference alive
+            std::shared_ptr<IDnnEngine> lease(engine.get(), [engine](IDnnEngine*) {});
+            entry->engineLease = lease;
+            return lease;
+        }
+    }
+
+    // The loaded engine is in use, the context is not re-entrant
+    std::unique_ptr<IDnnEngine> copy = engine->clone();
+    if (copy == nullptr) {
+        copy = IDnnEngine::create(dnnType);
+        copy->loadModel(modelPath);
+    }
+    size_t bytes = copy->getMemoryFootprint();
+    // a clone may share the weights of <engine>, keep it alive as long as the clone
+    std::shared_ptr<IDnnEngine> lease(copy.release(), [engine](IDnnEngine* clone) { delete clone; });
+
+    std::vector<std::shared_ptr<Entry>> evicted;
+    std::lock_guard<std::mutex> lock(m_mutex);
+    entry->clones.push_back({lease, bytes});
+    evicted = enforceBudget(entry.get());
+    return lease;
+}
+
+std::shared_future<void> ModelRegistry::prewarm(const std::string& dnnType, const std::string& modelPath) {
+    return TaskScheduler::instance().submit([this, dnnType, modelPath]() {
+        load(dnnType, modelPath);
+    }, TaskScheduler::Priority::Low).share();
+}
+
+std::shared_ptr<ModelRegistry::Entry> ModelRegistry::load(const std::string& dnnType, const std::string& modelPath) {
+    struct stat st;
+    if (stat(modelPath.c_str(), &st) != 0) {
+        throw std::runtime_error("Model not found: " + modelPath);
+    }
+    uint64_t file_size = static_cast<uint64_t>(st.st_size);
+    int64_t file_mtime = static_cast<int64_t>(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec;
+    std::string key = dnnType + ":" + modelPath;
+    auto unchanged = [file_size, file_mtime](const Entry& entry) {
+        return entry.fileSize == file_size && entry.fileMtime == file_mtime;
+    };
+
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        auto it = m_byPath.find(key);
+        if (it != m_byPath.end() && unchanged(*it->second)) {
+            auto entry = it->second;
+            lock.unlock();
+            return waitLoaded(entry);
+        }
+    }
+
+    // Only hashed on a miss, a model already loaded from another path is reused
+    uint64_t hash = hashFile(modelPath);
+    auto entry = std::make_shared<Entry>();
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        auto it = m_byPath.find(key);
+        if (it != m_byPath.end() && unchanged(*it->second)) {
+            auto loaded = it->second;
+            lock.unlock();
+            return waitLoaded(loaded);
+        }
+        for (const auto& other : m_entries) {
+            if (other->dnnType == dnnType && other->hash == hash && other->fileSize == file_size) {
+                m_byPath[key] = other;
+                auto loaded = other;
+                lock.unlock();
+                return waitLoaded(loaded);
+            }
+        }
+
+        // A changed file gets a new entry, the users of the old content keep their engines
+        entry->dnnType = dnnType;
+        entry->modelPath = modelPath;
+        entry->hash = hash;
+        entry->fileSize = file_size;
+        entry->fileMtime = file_mtime;
+        entry->lastUsed = Clock::now();
+        entry->ready = entry->loaded.get_future().share();
+        m_byPath[key] = entry;
+        m_entries.push_back(entry);
+    }
+
+    try {
+        auto start = Clock::now();
+        std::shared_ptr<IDnnEngine> engine = IDnnEngine::create(dnnType);
+        engine->loadModel(modelPath);
+        size_t bytes = engine->getMemoryFootprint();
+        auto elapsed = std::chrono::duration<float, std::milli>(Clock::now() - start).count();
+
+        std::vector<std::shared_ptr<Entry>> evicted;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            entry->engine = engine;
+            entry->engineBytes = bytes;
+            entry->loading = false;
+            evicted = enforceBudget(entry.get());
+        }
+        entry->loaded.set_value();
+        m_logger->printStdoutLog(Logger::LogLevel::Info, "loaded {} in {:.1f} ms, {} KB", modelPath, elapsed, bytes >> 10);
+    }
+    catch (...) {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            removeEntry(entry);
+        }
+        entry->loaded.set_exception(std::current_exception());
+        throw;
+    }
+    return entry;
+}
+
+std::shared_ptr<ModelRegistry::Entry> ModelRegistry::waitLoaded(std::shared_ptr<Entry> entry) {
+    // rethrows the error of a failed load
+    entry->ready.get();
+    return entry;
+}
+
+size_t ModelRegistry::residentBytesOf(Entry& entry) {
+    entry.clones.erase(std::remove_if(entry.clones.begin(), entry.clones.end(),
+            [](const Lease& lease) { return lease.engine.expired(); }), entry.clones.end());
+    size_t bytes = entry.engineBytes;
+    for (const auto& lease : entry.clones) {
+        bytes += lease.bytes;
+    }
+    return bytes;
+}
+
+size_t ModelRegistry::usersOf(Entry& entry) {
+    size_t users = entry.engineLease.expired() ? 0 : 1;
+    for (const auto& lease : entry.clones) {
+        users += lease.engine.expired() ? 0 : 1;
+    }
+    return users;
+}
+
+std::vector<std::shared_ptr<ModelRegistry::Entry>> ModelRegistry::enforceBudget(const Entry* keep) {
+    std::vector<std::shared_ptr<Entry>> evicted;
+    if (m_memoryBudget == 0) {
+        return evicted;
+    }
+
+    size_t total = 0;
+    for (const auto& entry : m_entries) {
+        total += residentBytesOf(*entry);
+    }
+    while (total > m_memoryBudget) {
+        std::shared_ptr<Entry> victim;
+        for (const auto& entry : m_entries) {
+            if (entry.get() == keep || entry->loading || usersOf(*entry) > 0) {
+                continue;
+            }
+            if (victim == nullptr || entry->lastUsed < victim->lastUsed) {
+                victim = entry;
+            }
+        }
+        if (victim == nullptr) {
+            m_logger->printStdoutLog(Logger::LogLevel::Warn, "{} KB resident above the budget of {} KB, every model is in use",
+                total >> 10, m_memoryBudget >> 10);
+            break;
+        }
+        total -= residentBytesOf(*victim);
+        removeEntry(victim);
+        m_logger->printStdoutLog(Logger::LogLevel::Info, "evicted {}", victim->modelPath);
+        evicted.push_back(std::move(victim));
+    }
+    return evicted;
+}
+
+void ModelRegistry::removeEntry(const std::shared_ptr<Entry>& entry) {
+    m_entries.erase(std::remove(m_entries.begin(), m_entries.end(), entry), m_entries.end());
+    for (auto it = m_byPath.begin(); it != m_byPath.end();) {
+        it = it->second == entry ? m_byPath.erase(it) : std::next(it);
+    }
+}
+
+void ModelRegistry::purge() {
+    std::vector<std::shared_ptr<Entry>> unused;
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (const auto& entry : m_entries) {
+        if (!entry->loading && usersOf(*entry) == 0) {
+            unused.push_back(entry);
+        }
+    }
+    for (const auto& entry : unused) {
+        removeEntry(entry);
+    }
+}
+
+size_t ModelRegistry::getResidentBytes() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    size_t bytes = 0;
+    for (const auto& entry : m_entries) {
+        bytes += residentBytesOf(*entry);
+    }
+    return bytes;
+}
+
+void ModelRegistry::reportMemory(MemoryReport& report, const std::string& prefix) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (const auto& entry : m_entries) {
+        if (!entry->loading && usersOf(*entry) == 0) {
+            report.add(prefix + "." + entry->modelPath, residentBytesOf(*entry));
+        }
+    }
+}
+
+std::vector<ModelRegistry::ModelInfo> ModelRegistry::getModels() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto now = Clock::now();
+    std::vector<ModelInfo> models;
+    for (const auto& entry : m_entries) {
+        ModelInfo info;
+        info.dnnType = entry->dnnType;
+        info.modelPath = entry->modelPath;
+        info.hash = entry->hash;
+        info.memoryBytes = residentBytesOf(*entry);
+        info.users = usersOf(*entry);
+        info.loading = entry->loading;
+        info.idleSeconds = std::chrono::duration<float>(now - entry->lastUsed).count();
+        models.push_back(info);
+    }
+    return models;
+}
+
+} // namespace dnn_engine
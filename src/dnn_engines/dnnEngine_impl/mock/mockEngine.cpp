@@ -0,0 +1,272 @@
+#include "mockEngine.hpp"
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+
+namespace dnn_engine {
+
+namespace {
+
+bool parseDims(const std::string& value, std::vector<size_t>& dims) {
+    dims.clear();
+    std::stringstream stream(value);
+    std::string item;
+    while (std::getline(stream, item, 'x')) {
+        if (item.empty() || item.find_first_not_of("0123456789") != std::string::npos) {
+            return false;
+        }
+        dims.push_back(static_cast<size_t>(std::stoul(item)));
+    }
+    return !dims.empty();
+}
+
+} // namespace
+
+mockEngine::mockEngine() : m_logger{std::make_unique<Logger>("mockEngine")} {}
+
+mockEngine::~mockEngine() {
+    // the default runInferenceAsync calls back into this object
+    stopInferenceAsync();
+}
+
+bool mockEngine::parseSpec(const std::string& text, MockModelSpec& spec) {
+    std::stringstream stream(text);
+    std::string line;
+    bool custom_outputs = false;
+    bool found = false;
+    while (std::getline(stream, line)) {
+        if (!line.empty() && line.back() == '\r') {
+            line.pop_back();
+        }
+        auto pos = line.find('=');
+        if (line.empty() || line[0] == '#' || pos == std::string::npos) {
+            continue;
+        }
+        std::string key = line.substr(0, pos);
+        std::string value = line.substr(pos + 1);
+        std::vector<size_t> dims;
+        try {
+            if (key == "input" && parseDims(value, dims) && dims.size() == 3) {
+                spec.input = dnnInputShape{dims[0], dims[1], dims[2], 1};
+            }
+            else if (key == "output" && parseDims(value, dims)) {
+                if (!custom_outputs) {
+                    spec.outputs.clear();
+                    custom_outputs = true;
+                }
+                spec.outputs.push_back(dims);
+            }
+            else if (key == "zero_point") {
+                spec.zeroPoint = std::stoi(value);
+            }
+            else if (key == "scale") {
+                spec.scale = std::stof(value);
+            }
+            else if (key == "latency_ms") {
+                spec.latencyMs = std::stof(value);
+            }
+            else if (key == "jitter_ms") {
+                spec.jitterMs = std::stof(value);
+            }
+            else if (key == "detections") {
+                spec.detections = std::stoi(value);
+            }
+            else if (key == "seed") {
+                spec.seed = static_cast<uint32_t>(std::stoul(value));
+            }
+            else {
+                continue;
+            }
+        }
+        catch (const std::exception&) {
+            continue;
+        }
+        found = true;
+    }
+    if (!custom_outputs) {
+        // YOLOv5 heads at strides 8, 16 and 32 of the input
+        spec.outputs.clear();
+        for (size_t stride : {8, 16, 32}) {
+            spec.outputs.push_back({1, 255, spec.input.height / stride, spec.input.width / stride});
+        }
+    }
+    return found;
+}
+
+void mockEngine::loadModel(const std::string& modelPath) {
+    auto begin = std::chrono::steady_clock::now();
+    std::ifstream file(modelPath, std::ios::binary);
+    if (!file.is_open()) {
+        throw std::runtime_error("Failed to open model: " + modelPath);
+    }
+    std::stringstream content;
+    content << file.rdbuf();
+    std::string text = content.str();
+    m_modelSize = text.size();
+    if (!parseSpec(text, m_spec)) {
+        m_logger->printStdoutLog(Logger::LogLevel::Info, "{} is not a mock spec, using the default outputs", modelPath);
+    }
+    m_loadStats.readMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - begin).count();
+
+    allocateOutputs();
+    m_logger->printStdoutLog(Logger::LogLevel::Info, "mock model {}x{}x{}, {} outputs, {:.1f} ms per run",
+        m_spec.input.width, m_spec.input.height, m_spec.input.channel, m_spec.outputs.size(), m_spec.latencyMs);
+}
+
+void mockEngine::allocateOutputs() {
+    m_random.seed(m_spec.seed);
+    m_outputs.resize(m_spec.outputs.size());
+    for (size_t i = 0; i < m_spec.outputs.size(); i++) {
+        size_t elements = 1;
+        for (size_t dim : m_spec.outputs[i]) {
+            elements *= dim;
+        }
+        // zero point = 0.0 everywhere, nothing above any threshold
+        m_outputs[i].assign(elements, static_cast<int8_t>(std::max(-128, std::min(127, m_spec.zeroPoint))));
+    }
+    m_touched.clear();
+}
+
+int mockEngine::getInputShape(dnnInputShape& shape) {
+    shape = m_spec.input;
+    return 0;
+}
+
+int mockEngine::getOutputDescs(std::vector<dnnOutputDesc>& outputDescs) {
+    outputDescs.resize(m_spec.outputs.size());
+    for (size_t i = 0; i < m_spec.outputs.size(); i++) {
+        outputDescs[i].index = i;
+        outputDescs[i].dims = m_spec.outputs[i];
+        outputDescs[i].layout = "NCHW";
+        outputDescs[i].dataType = "int8";
+    }
+    return 0;
+}
+
+int mockEngine::getOutputQuantParams(std::vector<int32_t>& zeroPoints, std::vector<float>& scales) {
+    zeroPoints.assign(m_spec.outputs.size(), m_spec.zeroPoint);
+    scales.assign(m_spec.outputs.size(), m_spec.scale);
+    return 0;
+}
+
+int mockEngine::pushInputData(dnnInput& inputData) {
+    if (inputData.size == 0) {
+        m_logger->printStdoutLog(Logger::LogLevel::Error, "inputData.buf is empty.");
+        return -1;
+    }
+    m_inputSet = true;
+    return 0;
+}
+
+// One object per random cell of the first head: anchor 0, centred box of about a cell, objectness and one class high
+void mockEngine::writeDetections() {
+    auto& head = m_outputs[0];
+    int8_t zero = static_cast<int8_t>(std::max(-128, std::min(127, m_spec.zeroPoint)));
+    for (size_t index : m_touched) {
+        head[index] = zero;
+    }
+    m_touched.clear();
+
+    const auto& dims = m_spec.outputs[0];
+    if (dims.size() != 4 || m_spec.detections <= 0) {
+        return;
+    }
+    size_t channel = dims[1];
+    size_t plane = dims[2] * dims[3];
+    size_t classes = channel / 3 > 5 ? channel / 3 - 5 : 0;
+    if (classes == 0 || plane == 0) {
+        return;
+    }
+    auto quant = [this](float value) {
+        float q = value / m_spec.scale + static_cast<float>(m_spec.zeroPoint);
+        return static_cast<int8_t>(std::max(-128.f, std::min(127.f, q)));
+    };
+    for (int n = 0; n < m_spec.detections; n++) {
+        size_t cell = m_random() % plane;
+        size_t cls = m_random() % classes;
+        // x, y, w, h, objectness, classes
+        const float values[5] = {0.5f, 0.5f, 0.5f, 0.5f, 0.95f};
+        for (size_t k = 0; k < 5; k++) {
+            head[k * plane + cell] = quant(values[k]);
+            m_touched.push_back(k * plane + cell);
+        }
+        head[(5 + cls) * plane + cell] = quant(0.95f);
+        m_touched.push_back((5 + cls) * plane + cell);
+    }
+}
+
+int mockEngine::runInference() {
+    if (!m_inputSet || m_outputs.empty()) {
+        return -1;
+    }
+    float latency_ms = m_spec.latencyMs;
+    if (m_spec.jitterMs > 0.f) {
+        latency_ms += std::uniform_real_distribution<float>(0.f, m_spec.jitterMs)(m_random);
+    }
+    if (latency_ms > 0.f) {
+        std::this_thread::sleep_for(std::chrono::duration<float, std::milli>(latency_ms));
+    }
+    writeDetections();
+    m_inputSet = false;
+    return 0;
+}
+
+int mockEngine::popOutputData(std::vector<dnnOutput>& outputVector) {
+    if (outputVector.size() != m_outputs.size()) {
+        outputVector.resize(m_outputs.size());
+    }
+    for (size_t i = 0; i < m_outputs.size(); i++) {
+        outputVector[i].index = i;
+        outputVector[i].buf = m_outputs[i].data();
+        outputVector[i].size = m_outputs[i].size();
+        outputVector[i].dataType = "int8";
+    }
+    return 0;
+}
+
+std::unique_ptr<IDnnEngine> mockEngine::clone() {
+    if (m_outputs.empty()) {
+        return nullptr;
+    }
+    auto engine = std::make_unique<mockEngine>();
+    engine->m_spec = m_spec;
+    engine->m_modelSize = m_modelSize;
+    engine->m_sharedSpec = true;
+    engine->allocateOutputs();
+    return engine;
+}
+
+void mockEngine::registerMock() {
+    IDnnEngine::registerType("mock", []() { return std::make_unique<mockEngine>(); });
+}
+
+int mockEngine::getLoadStats(dnnLoadStats& stats) {
+    stats = m_loadStats;
+    return 0;
+}
+
+size_t mockEngine::getMemoryFootprint() {
+    size_t bytes = m_sharedSpec ? 0 : m_modelSize;
+    for (const auto& output : m_outputs) {
+        bytes += output.size();
+    }
+    return bytes;
+}
+
+int mockEngine::getMemoryUsage(dnnMemoryUsage& usage) {
+    usage = dnnMemoryUsage{};
+    if (m_sharedSpec) {
+        usage.sharedBytes = m_modelSize;
+    }
+    else {
+        usage.modelBlobBytes = m_modelSize;
+    }
+    for (const auto& output : m_outputs) {
+        usage.ioBytes += output.size();
+    }
+    return 0;
+}
+
+} // namespace dnn_engine
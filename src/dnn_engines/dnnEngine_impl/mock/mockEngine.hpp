@@ -0,0 +1,97 @@
+#ifndef __MOCK_ENGINE_HPP__
+#define __MOCK_ENGINE_HPP__
+
+#include "dnn_engines/IDnnEngine.hpp"
+#include "common/Logger.hpp"
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace dnn_engine {
+
+using namespace common;
+
+// Behaviour of a mock model, read from the model file
+struct MockModelSpec {
+    IDnnEngine::dnnInputShape input{640, 640, 3, 1};
+    // NCHW int8 heads, by default the YOLOv5 heads of the input size
+    std::vector<std::vector<size_t>> outputs{{1, 255, 80, 80}, {1, 255, 40, 40}, {1, 255, 20, 20}};
+    int32_t zeroPoint{-128};
+    float scale{1.f / 255.f};
+    float latencyMs{0.f};       // simulated accelerator time per run
+    float jitterMs{0.f};        // uniformly added to latencyMs
+    int detections{5};          // objects written into the first head per frame
+    uint32_t seed{1};
+};
+
+/**
+ * Engine without an accelerator for soak tests and CI: runInference waits the configured time and produces
+ * int8 outputs that decode to a few objects per frame through the anchor-based YOLO plugins.
+ *
+ * The model file is a text spec with key=value lines, any other file (e.g. a real model) selects the defaults:
+ *   input=640x640x3
+ *   output=1x255x80x80    (repeat for every output, replaces the default heads)
+ *   zero_point=-128
+ *   scale=0.003921569
+ *   latency_ms=20
+ *   jitter_ms=5
+ *   detections=5
+ *   seed=1
+ * Outputs are deterministic for a seed, so two runs of a soak test see the same workload.
+ */
+class mockEngine : public IDnnEngine {
+public:
+    mockEngine();
+    mockEngine(const mockEngine&) = delete;
+    mockEngine& operator=(const mockEngine&) = delete;
+    ~mockEngine();
+
+    void loadModel(const std::string& modelPath) override;
+
+    int getInputShape(dnnInputShape& shape) override;
+
+    int getOutputDescs(std::vector<dnnOutputDesc>& outputDescs) override;
+
+    int getOutputQuantParams(std::vector<int32_t>& zeroPoints, std::vector<float>& scales) override;
+
+    int pushInputData(dnnInput& inputData) override;
+
+    int popOutputData(std::vector<dnnOutput>& outputVector) override;
+
+    int runInference() override;
+
+    std::unique_ptr<IDnnEngine> clone() override;
+
+    int getLoadStats(dnnLoadStats& stats) override;
+
+    size_t getMemoryFootprint() override;
+
+    int getMemoryUsage(dnnMemoryUsage& usage) override;
+
+    static bool parseSpec(const std::string& text, MockModelSpec& spec);
+
+    // Make IDnnEngine::create("mock") return a mockEngine, the production factory does not know it
+    static void registerMock();
+
+private:
+    void allocateOutputs();
+    void writeDetections();
+
+private:
+    std::unique_ptr<Logger> m_logger;
+    MockModelSpec m_spec{};
+    size_t m_modelSize{0};
+    bool m_sharedSpec{false};           // a clone, the spec blob belongs to the engine it was cloned from
+    bool m_inputSet{false};
+    std::vector<std::vector<int8_t>> m_outputs{};
+    std::vector<size_t> m_touched{};    // cells of the first head written by the last run
+    std::mt19937 m_random;
+    dnnLoadStats m_loadStats{};
+};
+
+} // namespace dnn_engine
+
+#endif // __MOCK_ENGINE_HPP__
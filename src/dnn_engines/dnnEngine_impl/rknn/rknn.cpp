@@ -1,4 +1,5 @@
 #include "rknn.hpp"
+#include "common/CpuTopology.hpp"
 #include <dlfcn.h>
 
 namespace dnn_engine {
@@ -6,7 +7,8 @@ namespace dnn_engine {
 rknn::rknn() : m_logger{std::make_unique<Logger>("rknn")}{}
 
 rknn::~rknn() {
-    if(m_params.m_outputs.size() > 0) {
+    stopCompletionThread();
+    if(m_params.m_outputs_held) {
         rknn_outputs_release(m_params.m_rknnCtx, m_params.m_io_num.n_output, m_params.m_outputs.data());
     }
     if(m_params.m_rknnCtx) {
@@ -62,8 +64,17 @@ void rknn::loadModel(const std::string& modelPath)
         throw std::runtime_error("modelPath is empty.");
     }
 
+    auto elapsed_ms = [](std::chrono::steady_clock::time_point& begin) {
+        auto now = std::chrono::steady_clock::now();
+        float ms = std::chrono::duration<float, std::milli>(now - begin).count();
+        begin = now;
+        return ms;
+    };
+    auto begin = std::chrono::steady_clock::now();
+
     // Load RKNN Model
     m_params.m_model_data = loadModelFile(modelPath);
+    m_loadStats.readMs = elapsed_ms(begin);
 
     if (nullptr == m_params.m_model_data ) {
         throw std::runtime_error("load model failed.");
@@ -74,6 +85,7 @@ void rknn::loadModel(const std::string& modelPath)
     if (ret < 0) {
         throw std::runtime_error("rknn_init failed.");
     }
+    m_loadStats.initMs = elapsed_ms(begin);
 
     ret = rknn_query(m_params.m_rknnCtx, RKNN_QUERY_SDK_VERSION, &m_params.m_version, sizeof(m_params.m_version));
 
@@ -116,10 +128,108 @@ void rknn::loadModel(const std::string& modelPath)
     }
 
     memset(m_params.m_inputs, 0, sizeof(m_params.m_inputs));
+    queryNativeInputAttrs();
+    queryMemSize();
+    m_loadStats.queryMs = elapsed_ms(begin);
+    m_logger->printStdoutLog(Logger::LogLevel::Info, "model read {:.1f} ms, rknn_init {:.1f} ms, queries {:.1f} ms",
+        m_loadStats.readMs, m_loadStats.initMs, m_loadStats.queryMs);
+}
+
+void rknn::queryMemSize() {
+    std::memset(&m_params.m_mem_size, 0, sizeof(m_params.m_mem_size));
+    auto ret = rknn_query(m_params.m_rknnCtx, RKNN_QUERY_MEM_SIZE, &m_params.m_mem_size, sizeof(m_params.m_mem_size));
+    if (ret < 0) {
+        m_logger->printStdoutLog(Logger::LogLevel::Error, "rknn_query RKNN_QUERY_MEM_SIZE failed.");
+    }
+}
+
+void rknn::queryNativeInputAttrs() {
+    m_params.m_native_input_attrs.resize(m_params.m_io_num.n_input);
+    memset(m_params.m_native_input_attrs.data(), 0, sizeof(rknn_tensor_attr) * m_params.m_native_input_attrs.size());
+    for (uint32_t i = 0; i < m_params.m_io_num.n_input; i++) {
+        m_params.m_native_input_attrs[i].index = i;
+        auto ret = rknn_query(m_params.m_rknnCtx, RKNN_QUERY_NATIVE_INPUT_ATTR, &m_params.m_native_input_attrs[i],
+                sizeof(m_params.m_native_input_attrs[i]));
+        if (ret < 0) {
+            m_logger->printStdoutLog(Logger::LogLevel::Warn, "rknn_query RKNN_QUERY_NATIVE_INPUT_ATTR failed, no pass-through input.");
+            m_params.m_native_input_attrs.clear();
+            return;
+        }
+    }
+}
+
+/* The clone gets its own context through rknn_dup_context: the weights stay shared with this engine,
+ * only the internal (activation) memory is allocated again.
+ */
+std::unique_ptr<IDnnEngine> rknn::clone() {
+    if (m_params.m_model_data == nullptr) {
+        return nullptr;
+    }
+
+    auto begin = std::chrono::steady_clock::now();
+    auto engine = std::make_unique<rknn>();
+    RknnParams& params = engine->m_params;
+    if (rknn_dup_context(&m_params.m_rknnCtx, &params.m_rknnCtx) < 0) {
+        m_logger->printStdoutLog(Logger::LogLevel::Error, "rknn_dup_context failed.");
+        return nullptr;
+    }
+    engine->m_loadStats.initMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - begin).count();
+    params.m_model_data = m_params.m_model_data;
+    params.m_model_size = m_params.m_model_size;
+    params.m_version = m_params.m_version;
+    params.m_io_num = m_params.m_io_num;
+    params.m_input_attrs = m_params.m_input_attrs;
+    params.m_native_input_attrs = m_params.m_native_input_attrs;
+    params.m_output_attrs = m_params.m_output_attrs;
+    params.m_shared_weights = true;
+    memset(params.m_inputs, 0, sizeof(params.m_inputs));
+    engine->queryMemSize();
+    return engine;
+}
+
+int rknn::getLoadStats(dnnLoadStats& stats) {
+    stats = m_loadStats;
+    return 0;
 }
 
+size_t rknn::getMemoryFootprint() {
+    size_t bytes = m_params.m_mem_size.total_internal_size;
+    if (!m_params.m_shared_weights) {
+        bytes += static_cast<size_t>(m_params.m_model_size) + m_params.m_mem_size.total_weight_size;
+    }
+    return bytes;
+}
+
+// RKNN_QUERY_MEM_SIZE for the context, the tensor attributes for the I/O buffers
+int rknn::getMemoryUsage(dnnMemoryUsage& usage) {
+    usage = dnnMemoryUsage{};
+    if (m_params.m_model_data == nullptr) {
+        return -1;
+    }
+    size_t blob_bytes = static_cast<size_t>(m_params.m_model_size);
+    size_t weight_bytes = m_params.m_mem_size.total_weight_size;
+    if (m_params.m_shared_weights) {
+        usage.sharedBytes = blob_bytes + weight_bytes;
+    }
+    else {
+        usage.modelBlobBytes = blob_bytes;
+        usage.weightBytes = weight_bytes;
+    }
+    usage.internalBytes = m_params.m_mem_size.total_internal_size;
+    for (const auto& attr : m_params.m_input_attrs) {
+        usage.ioBytes += attr.size_with_stride > 0 ? attr.size_with_stride : attr.size;
+    }
+    std::string data_type;
+    for (const auto& attr : m_params.m_output_attrs) {
+        // outputs converted to float are allocated by the runtime at 4 bytes per element
+        usage.ioBytes += selectOutputType(attr, data_type) != 0 ? static_cast<size_t>(attr.n_elems) * sizeof(float) : attr.size;
+    }
+    usage.dmaBytes = static_cast<size_t>(m_params.m_mem_size.total_dma_allocated_size);
+    return 0;
+}
 
 int rknn::getInputShape(dnnInputShape& shape) {
+    shape.batch = m_params.m_input_attrs[0].dims[0] > 0 ? m_params.m_input_attrs[0].dims[0] : 1;
     if (m_params.m_input_attrs[0].fmt == RKNN_TENSOR_NCHW) {
         shape.height = m_params.m_input_attrs[0].dims[2];
         shape.width  = m_params.m_input_attrs[0].dims[3];
@@ -133,7 +243,49 @@ int rknn::getInputShape(dnnInputShape& shape) {
     return 0;
 }
 
+int rknn::getOutputDescs(std::vector<dnnOutputDesc>& outputDescs) {
+    outputDescs.resize(m_params.m_io_num.n_output);
+    for (uint32_t i = 0; i < m_params.m_io_num.n_output; i++) {
+        const auto& attr = m_params.m_output_attrs[i];
+        outputDescs[i].index = i;
+        outputDescs[i].dims.assign(attr.dims, attr.dims + attr.n_dims);
+        outputDescs[i].layout = attr.fmt == RKNN_TENSOR_NHWC ? "NHWC" : "NCHW";
+        selectOutputType(attr, outputDescs[i].dataType);
+    }
+    return 0;
+}
+
+int rknn::getInputDesc(dnnInputDesc& desc) {
+    if (m_params.m_native_input_attrs.empty()) {
+        return -1;
+    }
+    const auto& attr = m_params.m_native_input_attrs[0];
+    desc.index = attr.index;
+    desc.dims.assign(attr.dims, attr.dims + attr.n_dims);
+    switch (attr.fmt) {
+        case RKNN_TENSOR_NCHW: desc.layout = "NCHW"; break;
+        case RKNN_TENSOR_NHWC: desc.layout = "NHWC"; break;
+        case RKNN_TENSOR_NC1HWC2: desc.layout = "NC1HWC2"; break;
+        default: return -1;
+    }
+    switch (attr.type) {
+        case RKNN_TENSOR_UINT8: desc.dataType = "UINT8"; break;
+        case RKNN_TENSOR_INT8: desc.dataType = "INT8"; break;
+        case RKNN_TENSOR_FLOAT16: desc.dataType = "FP16"; break;
+        case RKNN_TENSOR_FLOAT32: desc.dataType = "FP32"; break;
+        default: return -1;
+    }
+    bool affine = attr.qnt_type == RKNN_TENSOR_QNT_AFFINE_ASYMMETRIC;
+    desc.zeroPoint = affine ? attr.zp : 0;
+    desc.scale = affine ? attr.scale : 1.f;
+    desc.widthStride = attr.w_stride;
+    desc.size = attr.size_with_stride > 0 ? attr.size_with_stride : attr.size;
+    return 0;
+}
+
 int rknn::getOutputQuantParams(std::vector<int32_t>& zeroPoints, std::vector<float>& scales) {
+    zeroPoints.clear();
+    scales.clear();
     for (int i = 0; i < m_params.m_io_num.n_output; i++) {
         zeroPoints.push_back(m_params.m_output_attrs[i].zp);
         scales.push_back(m_params.m_output_attrs[i].scale);
@@ -147,23 +299,62 @@ int rknn::pushInputData(dnnInput& inputData) {
         return -1;
     }
 
+    // The buffer is the native tensor, the runtime neither converts nor re-lays it out
+    if (inputData.passThrough) {
+        if (m_params.m_native_input_attrs.empty()) {
+            m_logger->printStdoutLog(Logger::LogLevel::Error, "The model has no pass-through input.");
+            return -1;
+        }
+        const auto& attr = m_params.m_native_input_attrs[0];
+        uint32_t size = attr.size_with_stride > 0 ? attr.size_with_stride : attr.size;
+        if (inputData.buf.size() < size) {
+            m_logger->printStdoutLog(Logger::LogLevel::Error, "pass-through input of {} bytes, the model needs {}.", inputData.buf.size(), size);
+            return -1;
+        }
+        m_params.m_inputs[0].index        = inputData.index;
+        m_params.m_inputs[0].type         = attr.type;
+        m_params.m_inputs[0].size         = size;
+        m_params.m_inputs[0].fmt          = attr.fmt;
+        m_params.m_inputs[0].pass_through = 1;
+        m_params.m_inputs[0].buf          = static_cast<void*>(inputData.buf.data());
+        return rknn_inputs_set(m_params.m_rknnCtx, m_params.m_io_num.n_input, m_params.m_inputs);
+    }
+
     // Set Input Data before inference(rknn_run())
     m_params.m_inputs[0].index = inputData.index;
     m_params.m_inputs[0].type         = m_params.dataTypeMap.at(inputData.dataType);
-    m_params.m_inputs[0].size         = m_params.m_input_attrs[0].dims[1] * m_params.m_input_attrs[0].dims[2] * m_params.m_input_attrs[0].dims[3];
+    m_params.m_inputs[0].size         = m_params.m_input_attrs[0].dims[0] * m_params.m_input_attrs[0].dims[1] * m_params.m_input_attrs[0].dims[2] * m_params.m_input_attrs[0].dims[3];
     m_params.m_inputs[0].fmt          = m_params.m_input_attrs[0].fmt;
     m_params.m_inputs[0].pass_through = 0;
     m_params.m_inputs[0].buf          = static_cast<void*>(inputData.buf.data());
     return rknn_inputs_set(m_params.m_rknnCtx, m_params.m_io_num.n_input, m_params.m_inputs);
 }
 
+/* int8 (affine), fp16 and fp32 outputs are passed through in their native type, the plugins decode them directly.
+ * Any other output (e.g. dynamic fixed point, int16 or uint8 tensors of hybrid-quantized models) is converted
+ * to float32 by the runtime.
+ */
+uint8_t rknn::selectOutputType(const rknn_tensor_attr& attr, std::string& dataType) {
+    if (attr.type == RKNN_TENSOR_INT8 && attr.qnt_type == RKNN_TENSOR_QNT_AFFINE_ASYMMETRIC) {
+        dataType = "int8";
+        return 0;
+    }
+    if (attr.type == RKNN_TENSOR_FLOAT16) {
+        dataType = "float16";
+        return 0;
+    }
+    dataType = "float32";
+    return attr.type == RKNN_TENSOR_FLOAT32 ? 0 : 1;
+}
+
 int rknn::popOutputData(std::vector<dnnOutput>& outputVector) {
     if (m_params.m_outputs.size() != m_params.m_io_num.n_output) {
         m_params.m_outputs.resize(m_params.m_io_num.n_output);
+        m_params.m_output_types.resize(m_params.m_io_num.n_output);
         for (int i = 0; i < m_params.m_io_num.n_output; i++) {
             std::memset(&m_params.m_outputs[i], 0, sizeof(rknn_output));
             m_params.m_outputs[i].index = i;
-            m_params.m_outputs[i].want_float = 0;
+            m_params.m_outputs[i].want_float = selectOutputType(m_params.m_output_attrs[i], m_params.m_output_types[i]);
         }
     }
 
@@ -171,15 +362,22 @@ int rknn::popOutputData(std::vector<dnnOutput>& outputVector) {
         outputVector.resize(m_params.m_io_num.n_output);
     }
 
+    // The previous outputs were consumed by the caller, every get must be paired with a release
+    if (m_params.m_outputs_held) {
+        rknn_outputs_release(m_params.m_rknnCtx, m_params.m_io_num.n_output, m_params.m_outputs.data());
+        m_params.m_outputs_held = false;
+    }
+
     // Get Output
     int ret = rknn_outputs_get(m_params.m_rknnCtx, m_params.m_io_num.n_output,
                     m_params.m_outputs.data(), nullptr);
+    m_params.m_outputs_held = ret == 0;
 
     for (int i = 0; i < m_params.m_io_num.n_output; i++) {
         outputVector[i].index = m_params.m_outputs[i].index;
         outputVector[i].buf = m_params.m_outputs[i].buf;
         outputVector[i].size = m_params.m_outputs[i].size;
-        outputVector[i].dataType = m_params.m_outputs[i].want_float ? "float32" : "int8";
+        outputVector[i].dataType = m_params.m_output_types[i];
     }
 
     return ret;
@@ -189,5 +387,88 @@ int rknn::runInference() {
     return rknn_run(m_params.m_rknnCtx, nullptr);
 }
 
+/* One run is in flight per context: the input is set and rknn_run returns without waiting for the NPU,
+ * the next call blocks until the completion thread has delivered the previous outputs.
+ */
+int rknn::runInferenceAsync(dnnInput& inputData, InferenceCompletion completion) {
+    {
+        std::unique_lock<std::mutex> lock(m_asyncMutex);
+        if (!m_completionThread.joinable()) {
+            m_asyncStop = false;
+            m_completionThread = std::thread(&rknn::completionLoop, this);
+        }
+        m_asyncCv.wait(lock, [this]() { return !m_asyncBusy; });
+        m_asyncBusy = true;
+    }
+
+    rknn_run_extend run_extend;
+    std::memset(&run_extend, 0, sizeof(run_extend));
+    run_extend.non_block = 1;
+    int ret = pushInputData(inputData);
+    if (ret == 0) {
+        ret = rknn_run(m_params.m_rknnCtx, &run_extend);
+    }
+
+    std::lock_guard<std::mutex> lock(m_asyncMutex);
+    if (ret != 0) {
+        m_logger->printStdoutLog(Logger::LogLevel::Error, "Failed to start the asynchronous run: {}", ret);
+        m_asyncBusy = false;
+        m_asyncCv.notify_all();
+        return ret;
+    }
+    m_asyncRuns.push_back({run_extend.frame_id, std::move(completion)});
+    m_asyncCv.notify_all();
+    return 0;
+}
+
+int rknn::waitInferenceAsync() {
+    std::unique_lock<std::mutex> lock(m_asyncMutex);
+    m_asyncCv.wait(lock, [this]() { return !m_asyncBusy; });
+    return 0;
+}
+
+void rknn::completionLoop() {
+    CpuAffinity::applyToCurrentThread(CpuAffinity::Stage::Inference);
+    std::vector<dnnOutput> outputs;
+    while (true) {
+        AsyncRun run;
+        {
+            std::unique_lock<std::mutex> lock(m_asyncMutex);
+            m_asyncCv.wait(lock, [this]() { return m_asyncStop || !m_asyncRuns.empty(); });
+            if (m_asyncRuns.empty()) {
+                return;
+            }
+            run = std::move(m_asyncRuns.front());
+            m_asyncRuns.pop_front();
+        }
+
+        rknn_run_extend wait_extend;
+        std::memset(&wait_extend, 0, sizeof(wait_extend));
+        wait_extend.frame_id = run.frameId;
+        int ret = rknn_wait(m_params.m_rknnCtx, &wait_extend);
+        if (ret == 0) {
+            ret = popOutputData(outputs);
+        }
+        if (run.completion) {
+            run.completion(ret, outputs);
+        }
+
+        std::lock_guard<std::mutex> lock(m_asyncMutex);
+        m_asyncBusy = false;
+        m_asyncCv.notify_all();
+    }
+}
+
+void rknn::stopCompletionThread() {
+    {
+        std::lock_guard<std::mutex> lock(m_asyncMutex);
+        m_asyncStop = true;
+    }
+    m_asyncCv.notify_all();
+    if (m_completionThread.joinable()) {
+        m_completionThread.join();
+    }
+}
+
 
 } // namespace dnn_engine
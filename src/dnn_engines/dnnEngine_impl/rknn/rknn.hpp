@@ -8,6 +8,11 @@
 #include <string>
 #include <vector>
 #include <memory>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
 
 namespace dnn_engine {
 
@@ -20,10 +25,18 @@ struct RknnParams {
     int32_t m_model_size;
     rknn_sdk_version m_version;
     rknn_input_output_num m_io_num;
+    rknn_mem_size m_mem_size;
+    // the context was created by rknn_dup_context, the model blob and the weights belong to the original
+    bool m_shared_weights{false};
     std::vector<rknn_tensor_attr> m_input_attrs{};
+    // layout and type of the inputs submitted with pass_through, empty if the query failed
+    std::vector<rknn_tensor_attr> m_native_input_attrs{};
     std::vector<rknn_tensor_attr> m_output_attrs{};
     rknn_input m_inputs[1];
     std::vector<rknn_output> m_outputs{};
+    // the buffers of the last rknn_outputs_get, released by the next popOutputData
+    bool m_outputs_held{false};
+    std::vector<std::string> m_output_types{};
     const std::unordered_map<std::string, rknn_tensor_type> dataTypeMap{
         {"FP32", rknn_tensor_type::RKNN_TENSOR_FLOAT32},
         {"FP16", rknn_tensor_type::RKNN_TENSOR_FLOAT16},
@@ -56,6 +69,10 @@ public:
 
     int getInputShape(dnnInputShape& shape) override;
 
+    int getOutputDescs(std::vector<dnnOutputDesc>& outputDescs) override;
+
+    int getInputDesc(dnnInputDesc& desc) override;
+
     int getOutputQuantParams(std::vector<int32_t>& zeroPoints, std::vector<float>& scales) override;
 
     int pushInputData(dnnInput& inputData) override;
@@ -64,13 +81,43 @@ public:
 
     int runInference() override;
 
+    int runInferenceAsync(dnnInput& inputData, InferenceCompletion completion) override;
+
+    int waitInferenceAsync() override;
+
+    std::unique_ptr<IDnnEngine> clone() override;
+
+    int getLoadStats(dnnLoadStats& stats) override;
+
+    size_t getMemoryFootprint() override;
+
+    int getMemoryUsage(dnnMemoryUsage& usage) override;
+
 private:
     std::shared_ptr<unsigned char> loadModelFile(const std::string& modelPath);
     std::shared_ptr<unsigned char> loadModelData(FILE* fp, size_t offset, size_t size);
+    static uint8_t selectOutputType(const rknn_tensor_attr& attr, std::string& dataType);
+    void queryMemSize();
+    void queryNativeInputAttrs();
+    void completionLoop();
+    void stopCompletionThread();
 
 private:
     RknnParams m_params{};
     std::unique_ptr<Logger> m_logger;
+    dnnLoadStats m_loadStats{};
+
+    // Runs started with rknn_run(non_block), completed by m_completionThread
+    struct AsyncRun {
+        uint64_t frameId{0};
+        InferenceCompletion completion{};
+    };
+    std::thread m_completionThread;
+    std::mutex m_asyncMutex;
+    std::condition_variable m_asyncCv;
+    std::deque<AsyncRun> m_asyncRuns{};
+    bool m_asyncBusy{false};
+    bool m_asyncStop{false};
 
 };
 